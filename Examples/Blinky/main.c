@@ -87,6 +87,7 @@ int main(void) {
 
   while (TRUE) {
     Timer_softwareTimersUpdate();
+    Timer_sleepUntilNextTimer(); // nothing to do until next timer or interrupt
   }
 
   return 0;
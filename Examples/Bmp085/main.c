@@ -22,6 +22,7 @@
 #include "led.h"
 #include "utils.h"
 #include "serial_port.h"
+#include "serial_command.h"
 #include "bmp085.h"
 
 #define DEBUG
@@ -41,27 +42,8 @@ void softTimerCallback(void) {
 
   Led_toggle(LED_NUMBER2);
 
-  const int FRAME_MAX_SIZE = 10;
-  char frameBuffer[FRAME_MAX_SIZE];   // buffer for receiving commands from PC
-  int length;                         // length of command
-
-  // check for new frames from PC
-  if (SerialPort_getFrame(frameBuffer, &length, FRAME_MAX_SIZE) == SERIAL_PORT_GOT_FRAME) {
-    println("Got frame of length %d: %s", (int)length, (char*)frameBuffer);
-    // control LED0 from terminal
-    if (!strcmp((char*)frameBuffer, ":LED 0 ON")) {
-      Led_changeState(LED_NUMBER0, LED_ON);
-    }
-    if (!strcmp((char*)frameBuffer, ":LED 0 OFF")) {
-      Led_changeState(LED_NUMBER0, LED_OFF);
-    }
-    if (!strcmp((char*)frameBuffer, ":LED 1 ON")) {
-      Led_changeState(LED_NUMBER1, LED_ON);
-    }
-    if (!strcmp((char*)frameBuffer, ":LED 1 OFF")) {
-      Led_changeState(LED_NUMBER1, LED_OFF);
-    }
-  }
+  // execute commands from PC
+  SerialCommand_process();
   Bmp085_readMeasurements();
 }
 /**
@@ -71,6 +53,7 @@ int main(void) {
   CommonHal_initialize();
   const int COMM_BAUD_RATE = 115200;
   SerialPort_initialize(COMM_BAUD_RATE);
+  SerialCommand_register(":LED", Led_command);
   println("Starting program");
   Led_addNewLed(LED_NUMBER0);
   Led_addNewLed(LED_NUMBER1);
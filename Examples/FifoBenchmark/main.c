@@ -0,0 +1,193 @@
+/**
+ * @file    main.c
+ * @brief   Host benchmark of the lock-free Fifo against the previous one
+ * @date    18.10.2026
+ * @author  Michal Ksiezopolski
+ *
+ *
+ * @verbatim
+ * Copyright (c) 2026 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include "fifo.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define FIFO_LENGTH     256       ///< Length of tested FIFOs
+#define TOTAL_BYTES     100000000 ///< Bytes passed through every FIFO
+#define BLOCK_LENGTH    64        ///< Bytes pushed before popping them
+
+/**
+ * @brief Previous FIFO (element counter shared by producer and consumer).
+ * @details Kept here as the reference: it needed interrupts disabled around
+ * every access, which isn't counted in the results below.
+ */
+typedef struct {
+  int   head;       ///< Head
+  int   tail;       ///< Tail
+  char* dataBuffer; ///< Pointer to buffer
+  int   length;     ///< Maximum length of FIFO
+  int   count;      ///< Current number of data elements
+} OldFifo;
+
+static OldFifo oldFifo;
+static Fifo newFifo;
+static char oldBuffer[FIFO_LENGTH];
+static char newBuffer[FIFO_LENGTH];
+static volatile unsigned int checksum; ///< Keeps the compiler from removing pops
+
+static FifoResultCode oldPush(OldFifo* fifo, char newData);
+static FifoResultCode oldPop(OldFifo* fifo, char* c);
+static double getSeconds(void);
+static double runOldBytes(void);
+static double runNewBytes(void);
+static double runNewBlocks(void);
+
+/**
+ * @brief Main function
+ * @details Every test passes TOTAL_BYTES through a FIFO in blocks of
+ * BLOCK_LENGTH bytes and prints the time per byte.
+ * @return 0
+ */
+int main(void) {
+
+  oldFifo.dataBuffer = oldBuffer;
+  oldFifo.length = FIFO_LENGTH;
+  Fifo_addNewFifo(&newFifo, newBuffer, FIFO_LENGTH);
+
+  double oldTime = runOldBytes();
+  double newTime = runNewBytes();
+  double blockTime = runNewBlocks();
+
+  printf("Previous Fifo push/pop:   %6.2f ns/byte\r\n", oldTime * 1e9 / TOTAL_BYTES);
+  printf("Lock-free Fifo push/pop:  %6.2f ns/byte\r\n", newTime * 1e9 / TOTAL_BYTES);
+  printf("Lock-free Fifo write/read:%6.2f ns/byte\r\n", blockTime * 1e9 / TOTAL_BYTES);
+  printf("Checksum %u\r\n", checksum);
+  return 0;
+}
+
+/**
+ * @brief Pushes data to the previous FIFO.
+ * @param fifo Pointer to FIFO structure
+ * @param newData Data byte
+ * @retval FIFO_OK Data added
+ * @retval FIFO_FULL FIFO is full
+ */
+static FifoResultCode oldPush(OldFifo* fifo, char newData) {
+
+  if (fifo->count == fifo->length) {
+    return FIFO_FULL;
+  }
+
+  fifo->dataBuffer[fifo->head++] = newData;
+  fifo->count++;
+
+  if (fifo->head == fifo->length) {
+    fifo->head = 0;
+  }
+
+  return FIFO_OK;
+}
+/**
+ * @brief Pops data from the previous FIFO.
+ * @param fifo Pointer to FIFO structure
+ * @param c data
+ * @retval FIFO_OK Got valid data
+ * @retval FIFO_EMPTY FIFO is empty
+ */
+static FifoResultCode oldPop(OldFifo* fifo, char* c) {
+
+  if (fifo->count == 0) {
+    return FIFO_EMPTY;
+  }
+
+  *c = fifo->dataBuffer[fifo->tail++];
+  fifo->count--;
+
+  if (fifo->tail == fifo->length) {
+    fifo->tail = 0;
+  }
+
+  return FIFO_OK;
+}
+/**
+ * @brief Returns monotonic time.
+ * @return Time in seconds
+ */
+static double getSeconds(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec * 1e-9;
+}
+/**
+ * @brief Passes data byte by byte through the previous FIFO.
+ * @return Time in seconds
+ */
+static double runOldBytes(void) {
+
+  unsigned int sum = 0;
+  char c;
+  double start = getSeconds();
+
+  for (int i = 0; i < TOTAL_BYTES; i += BLOCK_LENGTH) {
+    for (int j = 0; j < BLOCK_LENGTH; j++) {
+      oldPush(&oldFifo, (char)j);
+    }
+    while (oldPop(&oldFifo, &c) == FIFO_OK) {
+      sum += (unsigned char)c;
+    }
+  }
+  checksum += sum;
+  return getSeconds() - start;
+}
+/**
+ * @brief Passes data byte by byte through the lock-free FIFO.
+ * @return Time in seconds
+ */
+static double runNewBytes(void) {
+
+  unsigned int sum = 0;
+  char c;
+  double start = getSeconds();
+
+  for (int i = 0; i < TOTAL_BYTES; i += BLOCK_LENGTH) {
+    for (int j = 0; j < BLOCK_LENGTH; j++) {
+      Fifo_push(&newFifo, (char)j);
+    }
+    while (Fifo_pop(&newFifo, &c) == FIFO_OK) {
+      sum += (unsigned char)c;
+    }
+  }
+  checksum += sum;
+  return getSeconds() - start;
+}
+/**
+ * @brief Passes data in blocks through the lock-free FIFO.
+ * @return Time in seconds
+ */
+static double runNewBlocks(void) {
+
+  char block[BLOCK_LENGTH];
+  unsigned int sum = 0;
+
+  for (int j = 0; j < BLOCK_LENGTH; j++) {
+    block[j] = (char)j;
+  }
+  double start = getSeconds();
+
+  for (int i = 0; i < TOTAL_BYTES; i += BLOCK_LENGTH) {
+    Fifo_write(&newFifo, block, BLOCK_LENGTH);
+    int count = Fifo_read(&newFifo, block, BLOCK_LENGTH);
+    sum += (unsigned char)block[count - 1];
+  }
+  checksum += sum;
+  return getSeconds() - start;
+}
@@ -17,8 +17,10 @@
  */
 
 #include "timers.h"
+#include "scheduler.h"
 #include "led.h"
 #include "serial_port.h"
+#include "serial_command.h"
 #include "common_hal.h"
 #include "keys.h"
 #include "graphics.h"
@@ -52,33 +54,35 @@
 static void tscEvent1(int x, int y);
 static void tscEvent2(int x, int y);
 
+static int serialTaskId; ///< Task executing commands from PC
+
+/**
+ * @brief Executes commands from PC.
+ * @details Highest priority, so commands don't wait for LCD redraw.
+ * @param events Posted events
+ */
+static void serialTask(uint32_t events) {
+  while (SerialCommand_process() != SERIAL_COMMAND_NO_COMMAND);
+}
+/**
+ * @brief Wakes serial task when a frame is received (called from ISR).
+ */
+static void frameReceived(void) {
+  Scheduler_postEvents(serialTaskId, 1);
+}
+/**
+ * @brief Handles touch screen and redraws LCD.
+ * @param events Posted events
+ */
+static void touchTask(uint32_t events) {
+  TSC2046_Update();
+}
 /**
- * @brief Callback for performing periodic tasks
+ * @brief Prints CPU time of tasks.
+ * @param events Posted events
  */
-void softTimerCallback(void) {
-
-  const int FRAME_MAX_SIZE = 10;
-  char frameBuffer[FRAME_MAX_SIZE];   // buffer for receiving commands from PC
-  int length;                         // length of command
-
-  // check for new frames from PC
-  if (SerialPort_getFrame(frameBuffer, &length, FRAME_MAX_SIZE) == SERIAL_PORT_GOT_FRAME) {
-    println("Got frame of length %d: %s", (int)length, (char*)frameBuffer);
-
-    // control LED0 from terminal
-    if (!strcmp((char*)frameBuffer, ":LED 0 ON")) {
-      Led_changeState(LED_NUMBER0, LED_ON);
-    }
-    if (!strcmp((char*)frameBuffer, ":LED 0 OFF")) {
-      Led_changeState(LED_NUMBER0, LED_OFF);
-    }
-    if (!strcmp((char*)frameBuffer, ":LED 1 ON")) {
-      Led_changeState(LED_NUMBER1, LED_ON);
-    }
-    if (!strcmp((char*)frameBuffer, ":LED 1 OFF")) {
-      Led_changeState(LED_NUMBER1, LED_OFF);
-    }
-  }
+static void reportTask(uint32_t events) {
+  Scheduler_printReport();
 }
 
 /**
@@ -90,16 +94,22 @@ int main(void) {
 
   const int COMM_BAUD_RATE = 115200;
   SerialPort_initialize(COMM_BAUD_RATE);
+  SerialCommand_register(":LED", Led_command);
   println("Starting program"); // Print a string to terminal
 
   Led_addNewLed(LED_NUMBER0);
   Led_addNewLed(LED_NUMBER1);
   Led_addNewLed(LED_NUMBER2);
 
-  // Add a soft timer with callback
-  const int SOFT_TIMER_PERIOD_MILLIS = 1000;
-  int timerId = Timer_addSoftwareTimer(SOFT_TIMER_PERIOD_MILLIS, softTimerCallback);
-  Timer_startSoftwareTimer(timerId);
+  // serial RX runs ahead of touch handling and LCD redraw
+  serialTaskId = Scheduler_addTask("serial", 0, serialTask);
+  SerialPort_setFrameCallback(frameReceived);
+  const int TOUCH_PERIOD_MILLIS = 10;
+  int touchTaskId = Scheduler_addTask("touch", 1, touchTask);
+  Scheduler_wakeEveryMillis(touchTaskId, TOUCH_PERIOD_MILLIS);
+  const int REPORT_PERIOD_MILLIS = 10000;
+  int reportTaskId = Scheduler_addTask("report", 2, reportTask);
+  Scheduler_wakeEveryMillis(reportTaskId, REPORT_PERIOD_MILLIS);
 
 #ifdef USE_BARE_GRAPHICS
   GRAPH_LcdDriverTypedef lcdDriver;
@@ -181,10 +191,7 @@ int main(void) {
   MK_GUI_AddButton(200, 50, 100, 50, tscEvent2, "LED 1", BUTTON_COLOR, GRAPH_WHITE);
 #endif
 
-  while (TRUE) {
-    Timer_softwareTimersUpdate(); // run timers
-    TSC2046_Update();
-  }
+  Scheduler_run(); // never returns
 }
 /**
  * @brief Example touchscreen event handler.
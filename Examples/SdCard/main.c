@@ -17,13 +17,16 @@
  */
 
 #include "timers.h"
+#include "systick.h"
 #include "led.h"
 #include "serial_port.h"
+#include "serial_command.h"
 #include "common_hal.h"
 #include "keys.h"
 #include "fat.h"
 #include "sdcard.h"
 #include "utils.h"
+#include "log.h"
 #include <stdio.h>
 #include <string.h>
 
@@ -37,33 +40,37 @@
 #define println(str, args...) (void)0
 #endif
 
+/**
+ * @brief Measures time of reading a 512 byte sector.
+ * @details Uses the DWT cycle counter, so the SPI burst loops can be
+ * compared on F4 and F7. Nothing is written, so the card isn't modified.
+ */
+static void measureSectorTransfer(void) {
+
+  const uint32_t SECTOR = 0;
+  uint8_t sector[512];
+
+  uint32_t cyclesPerMicrosecond = SysTick_getCyclesPerMicrosecond();
+  SysTick_initializeCycleCounter();
+
+  uint32_t startCycles = SysTick_getCycles();
+  int result = SD_ReadSectors(sector, SECTOR, 1);
+  uint32_t readCycles = SysTick_getCycles() - startCycles;
+
+  if (result != 0) {
+    println("Sector read failed");
+    return;
+  }
+  println("512 byte read: %lu cycles (%lu us)", (unsigned long)readCycles,
+      (unsigned long)(readCycles / cyclesPerMicrosecond));
+}
 /**
  * @brief Callback for performing periodic tasks
  */
 void softTimerCallback(void) {
 
-  const int FRAME_MAX_SIZE = 10;
-  char frameBuffer[FRAME_MAX_SIZE];   // buffer for receiving commands from PC
-  int length;                         // length of command
-
-  // check for new frames from PC
-  if (SerialPort_getFrame(frameBuffer, &length, FRAME_MAX_SIZE) == SERIAL_PORT_GOT_FRAME) {
-    println("Got frame of length %d: %s", (int)length, (char*)frameBuffer);
-
-    // control LED0 from terminal
-    if (!strcmp((char*)frameBuffer, ":LED 0 ON")) {
-      Led_changeState(LED_NUMBER0, LED_ON);
-    }
-    if (!strcmp((char*)frameBuffer, ":LED 0 OFF")) {
-      Led_changeState(LED_NUMBER0, LED_OFF);
-    }
-    if (!strcmp((char*)frameBuffer, ":LED 1 ON")) {
-      Led_changeState(LED_NUMBER1, LED_ON);
-    }
-    if (!strcmp((char*)frameBuffer, ":LED 1 OFF")) {
-      Led_changeState(LED_NUMBER1, LED_OFF);
-    }
-  }
+  // execute commands from PC
+  SerialCommand_process();
 }
 
 /**
@@ -75,6 +82,7 @@ int main(void) {
 
   const int COMM_BAUD_RATE = 115200;
   SerialPort_initialize(COMM_BAUD_RATE);
+  SerialCommand_register(":LED", Led_command);
   println("Starting program"); // Print a string to terminal
 
   Led_addNewLed(LED_NUMBER0);
@@ -86,7 +94,11 @@ int main(void) {
   int timerId = Timer_addSoftwareTimer(SOFT_TIMER_PERIOD_MILLIS, softTimerCallback);
   Timer_startSoftwareTimer(timerId);
 
+  FAT_SetSectorCountCallback(SD_ReadSectorCount); // check partitions against card size
   FAT_Init(SD_Initialize, SD_ReadSectors, SD_WriteSectors);
+  FAT_SetEraseCallback(SD_EraseSectors); // let the card reclaim freed clusters
+  SD_EnableCrc(TRUE); // check data integrity of all transfers
+  measureSectorTransfer();
   int hello = FAT_OpenFile("HELLO   TXT");
   uint8_t data[100];
 
@@ -112,5 +124,6 @@ int main(void) {
 
   while (TRUE) {
     Timer_softwareTimersUpdate(); // run timers
+    Log_process(); // send deferred log entries
   }
 }
@@ -0,0 +1,111 @@
+/**
+ * @file    main.c
+ * @brief   SD card and FAT libraries run on a PC with the SD card emulator
+ * @date    18.10.2026
+ * @author  Michal Ksiezopolski
+ *
+ *
+ * @verbatim
+ * Copyright (c) 2026 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include "fat.h"
+#include "sdcard.h"
+#include "sdcard_emulator.h"
+#include "utils.h"
+#include <stdio.h>
+#include <string.h>
+
+#define DEBUG
+
+#ifdef DEBUG
+#define print(str, args...) printf(""str"%s",##args,"")
+#define println(str, args...) printf("MAIN--> "str"%s",##args,"\r\n")
+#else
+#define print(str, args...) (void)0
+#define println(str, args...) (void)0
+#endif
+
+#define READ_CHUNK_LENGTH 100 ///< Bytes read from file at once
+
+/**
+ * @brief Main function
+ * @details Usage: sdcard_emulator <FAT32 card image> [8.3 file name]
+ * The file name is given like in the root directory, e.g. "HELLO   TXT".
+ * @return 0 if all transfers succeeded
+ */
+int main(int argc, char* argv[]) {
+
+  if (argc < 2) {
+    println("Usage: %s <card image> [file name]", argv[0]);
+    return 1;
+  }
+  const char* fileName = (argc > 2) ? argv[2] : "HELLO   TXT";
+
+  SdEmulatorConfig config;
+  SdEmulator_getDefaultConfig(&config);
+  if (SdEmulator_initialize(argv[1], &config) != 0) {
+    println("Can't open card image %s", argv[1]);
+    return 1;
+  }
+
+  // mount (initializes the card)
+  FAT_SetSectorCountCallback(SD_ReadSectorCount);
+  if (FAT_Init(SD_Initialize, SD_ReadSectors, SD_WriteSectors) != FAT_NO_ERROR) {
+    println("Can't mount FAT partition");
+    SdEmulator_close();
+    return 1;
+  }
+  FAT_SetEraseCallback(SD_EraseSectors);
+  SD_EnableCrc(TRUE);
+  SdEmulator_printStatistics("mount");
+
+  SdEmulator_resetStatistics();
+  int file = FAT_OpenFile(fileName);
+  if (file < 0) {
+    println("File %s not found", fileName);
+    SdEmulator_close();
+    return 1;
+  }
+  uint8_t data[READ_CHUNK_LENGTH];
+  int fileLength = 0;
+  int count;
+  while ((count = FAT_ReadFile(file, data, READ_CHUNK_LENGTH)) > 0) {
+    fileLength += count;
+  }
+  println("Read %d bytes", fileLength);
+  SdEmulator_printStatistics("read");
+
+  // write at end of file with a corrupted block and command on the way
+  SdEmulator_resetStatistics();
+  SdEmulator_getConfig()->writeCrcErrors = 1;
+  SdEmulator_getConfig()->commandCrcErrors = 1;
+  const char MESSAGE[] = "Hello from the SD card emulator\r\n";
+  FAT_MoveWrPtr(file, fileLength);
+  count = FAT_WriteFile(file, (const uint8_t*)MESSAGE, strlen(MESSAGE));
+  println("Written %d bytes", count);
+  SdEmulator_printStatistics("write");
+
+  // read the message back with a corrupted block
+  SdEmulator_resetStatistics();
+  SdEmulator_getConfig()->readCrcErrors = 1;
+  FAT_MoveRdPtr(file, fileLength);
+  count = FAT_ReadFile(file, data, strlen(MESSAGE));
+  Utils_hexdumpWithCharacters(data, count);
+  SdEmulator_printStatistics("read back");
+
+  SdEmulator_close();
+
+  if (count != (int)strlen(MESSAGE) || memcmp(data, MESSAGE, count) != 0) {
+    println("Message read back doesn't match");
+    return 1;
+  }
+  return 0;
+}
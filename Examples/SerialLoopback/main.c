@@ -0,0 +1,192 @@
+/**
+ * @file    main.c
+ * @brief   SerialPort and SerialFrame tested on a PC with the loopback transport
+ * @date    18.10.2026
+ * @author  Michal Ksiezopolski
+ *
+ *
+ * @verbatim
+ * Copyright (c) 2026 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include "serial_port.h"
+#include "serial_frame.h"
+#include "common_hal.h"
+#include "timers.h"
+#include <stdio.h>
+#include <string.h>
+
+#define FRAME_BUFFER_LENGTH 64 ///< Buffer for SerialPort frames
+
+static int failureCount;       ///< Number of failed checks
+static int frameCallbackCount; ///< Calls of SerialPort frame callback
+
+static void check(Boolean condition, const char* description);
+static void frameCallback(void);
+static void testSerialPort(void);
+static void testSerialFrame(void);
+
+/**
+ * @brief Main function
+ * @details Data sent by SerialPort and SerialFrame is passed straight back
+ * to their receive callbacks, so the FIFO, frame queue and COBS/CRC layers
+ * are checked without hardware. Both use the same loopback, so they are
+ * tested one after another.
+ * @return Number of failed checks
+ */
+int main(void) {
+
+  testSerialPort();
+  testSerialFrame();
+
+  printf("%s: %d checks failed\r\n", failureCount ? "FAIL" : "PASS", failureCount);
+  return failureCount;
+}
+
+/**
+ * @brief Prints result of a check.
+ * @param condition Checked condition
+ * @param description What is checked
+ */
+static void check(Boolean condition, const char* description) {
+  printf("%s %s\r\n", condition ? "ok  " : "FAIL", description);
+  if (!condition) {
+    failureCount++;
+  }
+}
+/**
+ * @brief Counts received SerialPort frames.
+ */
+static void frameCallback(void) {
+  frameCallbackCount++;
+}
+/**
+ * @brief Sends text frames through SerialPort and reads them back.
+ */
+static void testSerialPort(void) {
+
+  char frame[FRAME_BUFFER_LENGTH];
+  int length;
+
+  SerialPort_initialize(115200);
+  SerialPort_setFrameCallback(frameCallback);
+
+  SerialPort_write("ONE\rTWO\r", 8);
+  check(frameCallbackCount == 2, "SerialPort: callback called for every frame");
+  check(SerialPort_getFrame(frame, &length, sizeof(frame)) == SERIAL_PORT_GOT_FRAME &&
+      length == 3 && strcmp(frame, "ONE") == 0, "SerialPort: first frame");
+  check(SerialPort_getFrame(frame, &length, sizeof(frame)) == SERIAL_PORT_GOT_FRAME &&
+      length == 3 && strcmp(frame, "TWO") == 0, "SerialPort: second frame");
+  check(SerialPort_getFrame(frame, &length, sizeof(frame)) == SERIAL_PORT_NO_FRAME_READY,
+      "SerialPort: no more frames");
+
+  for (int i = 0; i < FRAME_BUFFER_LENGTH; i++) {
+    SerialPort_putCharacter('X');
+  }
+  SerialPort_putCharacter('\r');
+  SerialPort_write("OK\r", 3);
+  check(SerialPort_getFrame(frame, &length, sizeof(frame)) == SERIAL_PORT_FRAME_TOO_LARGE,
+      "SerialPort: frame longer than buffer is dropped");
+  check(SerialPort_getFrame(frame, &length, sizeof(frame)) == SERIAL_PORT_GOT_FRAME &&
+      strcmp(frame, "OK") == 0, "SerialPort: frame after dropped frame");
+
+  SerialPort_write("AB\r", 3);
+  // terminators of frames read with getFrame stay in the FIFO
+  char character;
+  do {
+    character = SerialPort_getCharacter();
+  } while (character == '\r');
+  check(character == 'A', "SerialPort: getCharacter");
+  check(SerialPort_getFrame(frame, &length, sizeof(frame)) == SERIAL_PORT_NO_FRAME_READY,
+      "SerialPort: frame started by getCharacter is dropped");
+  SerialPort_write("CD\r", 3);
+  check(SerialPort_getFrame(frame, &length, sizeof(frame)) == SERIAL_PORT_GOT_FRAME &&
+      strcmp(frame, "CD") == 0, "SerialPort: next frame");
+}
+/**
+ * @brief Sends binary frames through SerialFrame and reads them back.
+ */
+static void testSerialFrame(void) {
+
+  uint8_t payload[SERIAL_FRAME_MAX_PAYLOAD + 1];
+  const uint8_t* data;
+  int length;
+  SerialFrameStatistics statistics;
+
+  SerialFrame_initialize(115200);
+
+  // zeros and runs longer than a COBS block
+  for (int i = 0; i < SERIAL_FRAME_MAX_PAYLOAD; i++) {
+    payload[i] = (i % 3 == 0) ? 0 : (uint8_t)i;
+  }
+  check(SerialFrame_send(payload, SERIAL_FRAME_MAX_PAYLOAD) == SERIAL_FRAME_OK,
+      "SerialFrame: send frame with zeros");
+  check(SerialFrame_getFrame(&data, &length) == SERIAL_FRAME_OK &&
+      length == SERIAL_FRAME_MAX_PAYLOAD && memcmp(data, payload, length) == 0,
+      "SerialFrame: frame with zeros received");
+  SerialFrame_releaseFrame();
+
+  memset(payload, 0xaa, sizeof(payload));
+  check(SerialFrame_send(payload, SERIAL_FRAME_MAX_PAYLOAD) == SERIAL_FRAME_OK,
+      "SerialFrame: send frame without zeros");
+  check(SerialFrame_getFrame(&data, &length) == SERIAL_FRAME_OK &&
+      length == SERIAL_FRAME_MAX_PAYLOAD && memcmp(data, payload, length) == 0,
+      "SerialFrame: frame without zeros received");
+  SerialFrame_releaseFrame();
+
+  check(SerialFrame_send(payload, 0) == SERIAL_FRAME_OK &&
+      SerialFrame_getFrame(&data, &length) == SERIAL_FRAME_OK && length == 0,
+      "SerialFrame: empty frame");
+  SerialFrame_releaseFrame();
+
+  check(SerialFrame_send(payload, SERIAL_FRAME_MAX_PAYLOAD + 1) == SERIAL_FRAME_TOO_LONG,
+      "SerialFrame: payload too long");
+
+  // two frames more than there are slots
+  for (int i = 0; i < SERIAL_FRAME_SLOTS + 2; i++) {
+    payload[0] = (uint8_t)i;
+    SerialFrame_send(payload, 1);
+  }
+  int receivedCount = 0;
+  while (SerialFrame_getFrame(&data, &length) == SERIAL_FRAME_OK) {
+    receivedCount++;
+    SerialFrame_releaseFrame();
+  }
+  check(receivedCount == SERIAL_FRAME_SLOTS, "SerialFrame: all slots received");
+
+  SerialFrame_getStatistics(&statistics);
+  check(statistics.framesSent == SERIAL_FRAME_SLOTS + 5, "SerialFrame: frames sent");
+  check(statistics.framesReceived == SERIAL_FRAME_SLOTS + 3, "SerialFrame: frames received");
+  check(statistics.droppedFrames == 2, "SerialFrame: frames dropped when slots busy");
+  check(statistics.lostFrames == 0 && statistics.crcErrors == 0 &&
+      statistics.framingErrors == 0, "SerialFrame: no other errors");
+}
+
+/**
+ * @brief Interrupts are not used on PC.
+ * @return Previous state (unused)
+ */
+uint32_t CommonHal_disableInterrupts(void) {
+  return 0;
+}
+/**
+ * @brief Interrupts are not used on PC.
+ * @param state State returned by CommonHal_disableInterrupts
+ */
+void CommonHal_restoreInterrupts(uint32_t state) {
+  (void)state;
+}
+/**
+ * @brief Delay used by utils.c (not needed with loopback).
+ * @param millis Delay time
+ */
+void Timer_delayMillis(unsigned int millis) {
+  (void)millis;
+}
@@ -1,6 +1,6 @@
 /**
  * @file    main.c
- * @brief   Blinky test
+ * @brief   USB virtual COM port test
  * @date    07.10.2016
  * @author  Michal Ksiezopolski
  *
@@ -13,13 +13,17 @@
  * and is available at
  * http://www.gnu.org/licenses/gpl.html
  * @endverbatim
+ *
+ * Compile with USE_USB_CDC defined, so that the serial port (printf and
+ * commands) goes through USB instead of UART.
  */
 
 #include <stdio.h>
 #include <string.h>
 #include "common_hal.h"
 #include "timers.h"
-#include "comm.h"
+#include "serial_port.h"
+#include "serial_command.h"
 #include "led.h"
 #include "utils.h"
 
@@ -38,56 +42,36 @@
  */
 void softTimerCallback(void) {
 
-  LED_Toggle(_LED2);
+  Led_toggle(LED_NUMBER2);
   println("Hello world");
 
-  const int FRAME_MAX_SIZE = 10;
-  char frameBuffer[FRAME_MAX_SIZE];   // buffer for receiving commands from PC
-  int length;                         // length of command
-
-  // check for new frames from PC
-  if (COMM_GetFrame(frameBuffer, &length, FRAME_MAX_SIZE) == COMM_GOT_FRAME) {
-    println("Got frame of length %d: %s", (int)length, (char*)frameBuffer);
-
-    // control LED0 from terminal
-    if (!strcmp((char*)frameBuffer, ":LED 0 ON")) {
-      LED_ChangeState(_LED0, LED_ON);
-    }
-    if (!strcmp((char*)frameBuffer, ":LED 0 OFF")) {
-      LED_ChangeState(_LED0, LED_OFF);
-    }
-    if (!strcmp((char*)frameBuffer, ":LED 1 ON")) {
-      LED_ChangeState(_LED1, LED_ON);
-    }
-    if (!strcmp((char*)frameBuffer, ":LED 1 OFF")) {
-      LED_ChangeState(_LED1, LED_OFF);
-    }
-  }
+  // execute commands from PC
+  SerialCommand_process();
 }
 /**
   * @brief  Main program
   */
 int main(void) {
 
-  COMMON_HAL_Init();
+  CommonHal_initialize();
 
-  const int COMM_BAUD_RATE = 115200;
-  COMM_Initialize(COMM_BAUD_RATE);
+  const int COMM_BAUD_RATE = 115200; // not used by USB
+  SerialPort_initialize(COMM_BAUD_RATE);
+  SerialCommand_register(":LED", Led_command);
   println("Starting program"); // Print a string to terminal
 
-  LED_Add(_LED0);
-  LED_Add(_LED1);
-  LED_Add(_LED2);
+  Led_addNewLed(LED_NUMBER0);
+  Led_addNewLed(LED_NUMBER1);
+  Led_addNewLed(LED_NUMBER2);
 
   // Add a soft timer with callback
   const int SOFT_TIMER_PERIOD_MILLIS = 1000;
-  int timerId = TIMER_AddSoftTimer(SOFT_TIMER_PERIOD_MILLIS, softTimerCallback);
-  TIMER_StartSoftTimer(timerId);
+  int timerId = Timer_addSoftwareTimer(SOFT_TIMER_PERIOD_MILLIS, softTimerCallback);
+  Timer_startSoftwareTimer(timerId);
 
   while (TRUE) {
-    TIMER_SoftTimersUpdate();
+    Timer_softwareTimersUpdate();
   }
 
   return 0;
 }
-
@@ -91,9 +91,7 @@ void _exit (int status) {
 
 int _write(int file, char *ptr, int len) {
 
-  for (int i = 0; i < len; i++) {
-    SerialPort_putCharacter(*ptr++);
-  }
+  SerialPort_write(ptr, len);
 	return len;
 }
 
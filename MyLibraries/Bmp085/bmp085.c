@@ -11,15 +11,9 @@
 #include <stdio.h>
 #include <math.h>
 
-#define DEBUG_BMP085
-
-#ifdef DEBUG_BMP085
-#define print(str, args...) printf(""str"%s",##args,"")
-#define println(str, args...) printf("BMP085--> "str"%s",##args,"\r\n")
-#else
-#define print(str, args...) (void)0
-#define println(str, args...) (void)0
-#endif
+#define LOG_MODULE_PREFIX "BMP085--> "     ///< Prefix of log lines
+#define LOG_MODULE_LEVEL  LOG_LEVEL_BMP085 ///< Set with -DLOG_LEVEL_BMP085=<level>
+#include "log_module.h"
 
 #define BMP085_ADDRESS 0xee ///< BMP085 address on I2C bus
 /**
@@ -99,16 +93,16 @@ void Bmp085_readMeasurements(void) {
   } MeasurementState;
 
   static MeasurementState state = START_TEMPERATURE_MEASURMENT;
-  static unsigned int conversionTimerMillis;
+  static uint64_t conversionDeadline;
 
   switch(state) {
   case START_TEMPERATURE_MEASURMENT:
     startMeasurement(MEASURMENT_TEMPERATURE);
-    conversionTimerMillis = Timer_getTimeMillis();
+    conversionDeadline = Timer_getDeadlineMillis(TEMPERATURE_CONVERSION_TIME_MILLIS);
     state = TEMPERATURE_DELAY;
     break;
   case TEMPERATURE_DELAY:
-    if (Timer_delayTimer(TEMPERATURE_CONVERSION_TIME_MILLIS, conversionTimerMillis)) {
+    if (Timer_isDeadlineReached(conversionDeadline)) {
       temperatureMeasurement = readMeasurement();
       float temperatureCelsius = calculateTemperatureDegreesCelsius(temperatureMeasurement);
       println("Temperature = %.2f deg. Celsius", temperatureCelsius);
@@ -117,12 +111,11 @@ void Bmp085_readMeasurements(void) {
     break;
   case START_PRESSURE_MEASUREMENT:
     startMeasurement(MEASUREMENT_PRESSURE_OVERSAMPLING0);
-    conversionTimerMillis = Timer_getTimeMillis();
+    conversionDeadline = Timer_getDeadlineMillis(PRESSURE_OVERSAMPLING0_CONVERSION_TIME_MILLIS);
     state = PRESSURE_DELAY;
     break;
   case PRESSURE_DELAY:
-    if (Timer_delayTimer(PRESSURE_OVERSAMPLING0_CONVERSION_TIME_MILLIS,
-        conversionTimerMillis)) {
+    if (Timer_isDeadlineReached(conversionDeadline)) {
       pressureMeasurement = readMeasurement();
       float pressureHectopascals = calculatePressureHectopascals(pressureMeasurement);
       println("Pressure = %.2f hPa", pressureHectopascals);
@@ -23,15 +23,9 @@
 #include "onewire.h"
 #include <stdio.h>
 
-#define DEBUG_DS18B20
-
-#ifdef DEBUG_DS18B20
-#define print(str, args...) printf("DS18B20--> "str"%s",##args,"\r")
-#define println(str, args...) printf("DS18B20--> "str"%s",##args,"\r\n")
-#else
-#define print(str, args...) (void)0
-#define println(str, args...) (void)0
-#endif
+#define LOG_MODULE_PREFIX "DS18B20--> "     ///< Prefix of log lines
+#define LOG_MODULE_LEVEL  LOG_LEVEL_DS18B20 ///< Set with -DLOG_LEVEL_DS18B20=<level>
+#include "log_module.h"
 
 /**
  * @brief DS18B20 commands
@@ -79,7 +73,7 @@ static char romCode[ROMCODE_SIZE];      ///< Device ROMCODE TODO Add structure f
 Ds18b20ResultCode Ds18b20_initialize(void) {
   Onewire_readRom(romCode);
   if (romCode[ROMCODE_DEVICE_ID_POSITION] != ROMCODE_DEVICE_ID) {
-    println("Not DS18B20!");
+    logError("Not DS18B20!");
     return DS18B20_NO_DEVICE_ON_BUS;
   }
   return DS18B20_RESULT_OK;
@@ -20,15 +20,9 @@
 #include <stdio.h>
 #include <string.h>
 
-#define DEBUG_FAT
-
-#ifdef DEBUG_FAT
-  #define print(str, args...) printf(""str"%s",##args,"")
-  #define println(str, args...) printf("FAT--> "str"%s",##args,"\r\n")
-#else
-  #define print(str, args...) (void)0
-  #define println(str, args...) (void)0
-#endif
+#define LOG_MODULE_PREFIX "FAT--> "     ///< Prefix of log lines
+#define LOG_MODULE_LEVEL  LOG_LEVEL_FAT ///< Set with -DLOG_LEVEL_FAT=<level>
+#include "log_module.h"
 
 /**
  * @addtogroup FAT
@@ -222,6 +216,8 @@ typedef struct {
   uint32_t startSector;      ///< Start address - LBA sector number
   uint32_t lengthInSectors;   ///< Length of partition in sectors
   uint32_t startFatSector;    ///< Sector where FAT start
+  uint32_t sectorsPerFat;     ///< Number of sectors occupied by one FAT
+  uint32_t numberOfFats;      ///< Number of FAT copies on partition
   uint32_t rootDirSector;     ///< Sector where root directory starts
   uint32_t rootDirCluster;    ///< First cluster of root directory
   uint32_t dataStartSector;   ///< Sector where data starts
@@ -242,12 +238,27 @@ typedef struct {
   int (*phyInit)(void);
   int (*phyReadSectors)(uint8_t* readBuffer, uint32_t sector, uint32_t count);
   int (*phyWriteSectors)(uint8_t* writeBuffer, uint32_t sector, uint32_t count);
+  int (*phyEraseSectors)(uint32_t sector, uint32_t count); ///< Optional, may be NULL
+  uint64_t (*phySectorCount)(void); ///< Optional, may be NULL
 } FAT_PhysicalCb;
+/**
+ * @brief Range of contiguous freed clusters
+ */
+typedef struct {
+  uint32_t firstCluster; ///< First freed cluster
+  uint32_t clusterCount; ///< Number of freed clusters
+} FAT_Extent;
 
 #define FAT_MAX_DISKS     2   ///< Maximum number of mounted disks
 #define MAX_OPENED_FILES  32  ///< Maximum number of opened files
 #define FAT_LAST_CLUSTER  0x0fffffff ///< Last cluster in file
+#define FAT_FREE_CLUSTER  0x00000000 ///< Cluster not allocated to any file
+#define FAT_ENTRY_MASK    0x0fffffff ///< FAT32 entries use only the lower 28 bits
+#define FAT_MIN_END_OF_CHAIN 0x0ffffff8 ///< Entries from this value up mark end of chain
+#define FAT_DELETED_ENTRY 0xe5       ///< First byte of a deleted directory entry
+#define FAT_LONG_NAME_ATTRIBUTES 0x0f ///< Attributes of a long file name entry
 #define BYTES_PER_SECTOR  512 ///< Number of bytes in sector
+#define MAX_FREED_EXTENTS 16  ///< Extents of a deleted file passed to erase (the rest isn't erased)
 /**
  * @brief Opened files
  * @details If a file ID is -1 then the file is not present.
@@ -258,9 +269,19 @@ static FAT_DiskInfo mountedDisks[FAT_MAX_DISKS]; ///< Disk info for mounted disk
 static uint8_t bufferForReadingSectors[512]; ///< Buffer for reading sectors
 static FAT_PhysicalCb phyCallbacks; ///< Physical layer callbacks
 static Boolean isFilesystemMounted;
+static uint32_t sectorCurrentlyInBuffer = UINT32_MAX; ///< Sector held in bufferForReadingSectors
+static uint32_t dirtyFatSector = UINT32_MAX; ///< Modified sector of first FAT in buffer (not written yet)
+static FAT_Extent freedExtents[MAX_FREED_EXTENTS]; ///< Extents freed by releaseClusterChain
+static int freedExtentCount; ///< Number of extents in freedExtents
 
 static uint32_t convertClusterToSector(uint32_t cluster);
-static uint32_t getEntryInFat(uint32_t cluster);
+static FAT_ErrorTypedef getEntryInFat(uint32_t cluster, uint32_t* entry);
+static FAT_ErrorTypedef setEntryInFat(uint32_t cluster, uint32_t value);
+static FAT_ErrorTypedef flushFatSector(void);
+static FAT_ErrorTypedef releaseClusterChain(uint32_t firstCluster);
+static void addFreedExtent(uint32_t firstCluster, uint32_t clusterCount);
+static void releaseExtent(uint32_t firstCluster, uint32_t clusterCount);
+static FAT_ErrorTypedef markRootEntryDeleted(uint32_t rootDirEntry);
 static int findFile(FAT_File* file);
 static int getNextId(void);
 static int getCluster(uint32_t firstCluster, uint32_t clusterOffset,
@@ -299,10 +320,17 @@ int FAT_Init(int (*phyInit)(void),
     return FAT_HAL_ERROR;
   }
 
+  // without the callback partitions can't be checked against the disk size
+  uint64_t diskSectorCount = UINT64_MAX;
+  if (phyCallbacks.phySectorCount != NULL) {
+    diskSectorCount = phyCallbacks.phySectorCount();
+    logInfo("Disk size is: %u sectors", (unsigned int)diskSectorCount);
+  }
+
   FAT_MBR* mbr = (FAT_MBR*)bufferForReadingSectors;
   const uint16_t MBR_SIGNATURE = 0xaa55;
   if (mbr->signature != MBR_SIGNATURE) {
-    println("Invalid disk signature %04x", mbr->signature);
+    logError("Invalid disk signature %04x", mbr->signature);
     return FAT_INVALID_MBR_ERROR;
   }
 
@@ -319,12 +347,20 @@ int FAT_Init(int (*phyInit)(void),
     } else {
       println("Partition %d type is: %02x", i, mbr->partitionTable[i].type);
       if (mbr->partitionTable[i].type == PAR_TYPE_FAT32) {
-        println("FAT32 partition found");
+        logInfo("FAT32 partition found");
       }
       println("Partition %d start sector is: %u", i,
           (unsigned int)mbr->partitionTable[i].partitionLBA);
-      println("Partition %d size is: %u bytes", i,
-          (unsigned int)mbr->partitionTable[i].sizeInSectors*BYTES_PER_SECTOR);
+      // size in bytes may not fit 32 bits
+      println("Partition %d size is: %u kB", i,
+          (unsigned int)(mbr->partitionTable[i].sizeInSectors /
+          (1024 / BYTES_PER_SECTOR)));
+
+      if ((uint64_t)mbr->partitionTable[i].partitionLBA +
+          mbr->partitionTable[i].sizeInSectors > diskSectorCount) {
+        logError("Partition %d exceeds disk size", i);
+        return FAT_WRONG_PARTITION_SIZE;
+      }
 
       mountedDisks[0].partitionInfo[i].partitionNumber = i;
       mountedDisks[0].partitionInfo[i].type = mbr->partitionTable[i].type;
@@ -342,19 +378,19 @@ int FAT_Init(int (*phyInit)(void),
   FAT32_BootSector* bootSector = (FAT32_BootSector*)bufferForReadingSectors;
   const uint16_t PARTITION_SIGNATURE = 0xaa55;
   if (bootSector->signature != PARTITION_SIGNATURE) {
-    println("Invalid partition signature %04x", bootSector->signature);
+    logError("Invalid partition signature %04x", bootSector->signature);
     return FAT_INVALID_PARTITION_ERROR;
   }
   println("Found valid partition signature");
 
   if (bootSector->totalSectors32 != mountedDisks[0].partitionInfo[0].lengthInSectors) {
-    println("Error: Wrong partition size");
+    logError("Wrong partition size");
     return FAT_WRONG_PARTITION_SIZE;
   }
 
   if (bootSector->bytesPerSector != BYTES_PER_SECTOR) {
     // TODO Make library sector length independent
-    println("Error: incompatible sector length");
+    logError("Incompatible sector length");
     return FAT_INCOMPATIBLE_SECTOR_LENGTH;
   }
   println("Sectors per cluster =  %d", (unsigned int)bootSector->sectorsPerCluster);
@@ -366,6 +402,8 @@ int FAT_Init(int (*phyInit)(void),
   uint32_t fatStart = mountedDisks[0].partitionInfo[0].startSector +
       bootSector->reservedSectors;
   mountedDisks[0].partitionInfo[0].startFatSector = fatStart;
+  mountedDisks[0].partitionInfo[0].sectorsPerFat = bootSector->sectorsPerFAT32;
+  mountedDisks[0].partitionInfo[0].numberOfFats = bootSector->numberOfFATs;
   println("FATs start at sector %d", (unsigned int)fatStart);
 
   // Sector on disk where data clusters start
@@ -434,6 +472,79 @@ int FAT_NewFile(const char* filename) {
   }
   return 0;
 }
+/**
+ * @brief Set the physical layer erase function.
+ *
+ * @details The erase function is optional. If it is set, whole
+ * cluster ranges freed by the file system are passed to it, so
+ * the medium can reclaim them (TRIM). Can be called before or
+ * after FAT_Init.
+ *
+ * @param phyEraseSectors Erase sectors function or NULL to disable.
+ */
+void FAT_SetEraseCallback(
+    int (*phyEraseSectors)(uint32_t sector, uint32_t count)) {
+  phyCallbacks.phyEraseSectors = phyEraseSectors;
+}
+/**
+ * @brief Set the physical layer sector count function.
+ *
+ * @details The function is optional. If it is set, FAT_Init
+ * checks that all partitions fit on the disk. Has to be
+ * called before FAT_Init.
+ *
+ * @param phySectorCount Sector count function or NULL to disable.
+ */
+void FAT_SetSectorCountCallback(uint64_t (*phySectorCount)(void)) {
+  phyCallbacks.phySectorCount = phySectorCount;
+}
+/**
+ * @brief Deletes a file from the root directory.
+ *
+ * @details Frees the cluster chain of the file in all FAT copies and
+ * marks the directory entries of the file as deleted. Only then the freed
+ * extents are passed to the erase callback (if set), so a failed write or
+ * power loss never leaves a file pointing at erased data.
+ *
+ * @param filename Name of file
+ * @retval FAT_NO_ERROR File deleted
+ * @retval -1 File not found
+ * @retval FAT_HAL_READ_ERROR Reading FAT or directory failed
+ * @retval FAT_HAL_WRITE_ERROR Writing FAT or directory failed
+ */
+int FAT_DeleteFile(const char* filename) {
+
+  FAT_File file;
+  strcpy(file.filename, filename);
+  println("%s: Deleting file %s", __FUNCTION__, filename);
+
+  if (findFile(&file) < 0) {
+    return -1;
+  }
+
+  // close the file if it is opened
+  for (int i = 0; i < MAX_OPENED_FILES; i++) {
+    if ((openedFiles[i].id != -1) &&
+        (openedFiles[i].rootDirEntry == file.rootDirEntry)) {
+      openedFiles[i].id = -1;
+    }
+  }
+
+  FAT_ErrorTypedef result = releaseClusterChain(file.firstCluster);
+  if (result != FAT_NO_ERROR) {
+    return result;
+  }
+  result = markRootEntryDeleted(file.rootDirEntry);
+  if (result != FAT_NO_ERROR) {
+    return result;
+  }
+
+  for (int i = 0; i < freedExtentCount; i++) {
+    releaseExtent(freedExtents[i].firstCluster, freedExtents[i].clusterCount);
+  }
+  freedExtentCount = 0;
+  return FAT_NO_ERROR;
+}
 /**
  * @brief Close a file.
  * @param file ID of file
@@ -517,17 +628,17 @@ int FAT_MoveWrPtr(int file, int newWrPtr) {
  */
 int FAT_ReadFile(int file, uint8_t* data, int count) {
 
-  println("%s", __FUNCTION__);
+  trace("%s", __FUNCTION__);
 
   // if incorrect file ID
   if (file >= MAX_OPENED_FILES) {
-    println("Maximum number of files open");
+    logWarning("Maximum number of files open");
     return -1;
   }
 
   // File not opened
   if (openedFiles[file].id == -1) {
-    println("File not open");
+    logWarning("File not open");
     return -1; // EOF for not open file
   }
   // We have already reached EOF
@@ -564,7 +675,7 @@ int FAT_ReadFile(int file, uint8_t* data, int count) {
   // start getting data from read pointer (in the current sector)
   uint8_t* ptr = bufferForReadingSectors + openedFiles[file].rdPtr % 512;
 
-  println("%s: reading data", __FUNCTION__);
+  trace("%s: reading data", __FUNCTION__);
   for (int i = 0; i < count; i++) {
 
     data[i] = *ptr++;
@@ -572,12 +683,12 @@ int FAT_ReadFile(int file, uint8_t* data, int count) {
     len++;
     // check if EOF reached
     if (openedFiles[file].rdPtr >= openedFiles[file].fileSize) {
-      println("%s: EOF reached", __FUNCTION__);
+      trace("%s: EOF reached", __FUNCTION__);
       break;
     }
     // if sector boundary reached
     if (openedFiles[file].rdPtr % 512 == 0) {
-      println("%s: read new sector", __FUNCTION__);
+      trace("%s: read new sector", __FUNCTION__);
       // increment sector counter
       sectorOffset++;
       // which sector in cluster is it
@@ -586,7 +697,7 @@ int FAT_ReadFile(int file, uint8_t* data, int count) {
 
       // if first sector, then read new cluster
       if (sectorOffset == 0) {
-        println("%s: jump to next cluster", __FUNCTION__);
+        trace("%s: jump to next cluster", __FUNCTION__);
         // change cluster to next
         getCluster(baseCluster, 1, &baseCluster);
       }
@@ -609,23 +720,23 @@ int FAT_ReadFile(int file, uint8_t* data, int count) {
  */
 int FAT_WriteFile(int file, const uint8_t* data, int count) {
 
-  println("%s", __FUNCTION__);
+  trace("%s", __FUNCTION__);
 
   // if incorrect file ID
   if (file >= MAX_OPENED_FILES) {
-    println("Maximum number of files open");
+    logWarning("Maximum number of files open");
     return -1;
   }
 
   // File not opened
   if (openedFiles[file].id == -1) {
-    println("File not open");
+    logWarning("File not open");
     return -1; // EOF for not open file
   }
   // We have already reached EOF
   // TODO Make this cross EOF - adding more data - change file size in root dir
   if (openedFiles[file].wrPtr >= openedFiles[file].fileSize) {
-    println("%s: EOF reached", __FUNCTION__);
+    trace("%s: EOF reached", __FUNCTION__);
 
     // TODO Zero out the bytes between wrPtr and filesize
     // TODO If new cluster we need to add cluster info in FAT
@@ -659,7 +770,7 @@ int FAT_WriteFile(int file, const uint8_t* data, int count) {
   // start writing data from write pointer (in the current sector)
   uint8_t* ptr = bufferForReadingSectors + openedFiles[file].wrPtr % 512;
 
-  println("%s: writing data", __FUNCTION__);
+  trace("%s: writing data", __FUNCTION__);
   for (int i = 0; i < count; i++) {
 
     *ptr++ = data[i];
@@ -668,7 +779,7 @@ int FAT_WriteFile(int file, const uint8_t* data, int count) {
 
     // if sector boundary reached
     if (openedFiles[file].wrPtr % 512 == 0) {
-      println("%s: new sector", __FUNCTION__);
+      trace("%s: new sector", __FUNCTION__);
       writeSector(baseSector); // save data
 //      FAT_UpdateRootEntry(file);
       // increment sector counter
@@ -679,7 +790,7 @@ int FAT_WriteFile(int file, const uint8_t* data, int count) {
 
       // if first sector, then read new cluster
       if (sectorOffset == 0) {
-        println("%s: jump to next cluster", __FUNCTION__);
+        trace("%s: jump to next cluster", __FUNCTION__);
 
         if (openedFiles[file].wrPtr >= openedFiles[file].fileSize) {
           // TODO If new cluster then update FAT
@@ -731,14 +842,14 @@ void updateRootEntry(int file) {
   // read sector where entry is at
 
   readSector(sector);
-  println("%s: Read sector %u", __FUNCTION__, (unsigned int)sector);
+  trace("%s: Read sector %u", __FUNCTION__, (unsigned int)sector);
 
   // point to entry in the current sector
 //  uint8_t* ptr = buf;
 //  ptr += (openedFiles[file].rootDirEntry * sizeof(FAT_RootDirEntry)) % 512;
 
   FAT_RootDirEntry* dirEntry = (FAT_RootDirEntry*) bufferForReadingSectors;
-  println("%s: Dir entry %u", __FUNCTION__,
+  trace("%s: Dir entry %u", __FUNCTION__,
       (unsigned int)openedFiles[file].rootDirEntry);
   dirEntry += openedFiles[file].rootDirEntry;
 
@@ -771,7 +882,9 @@ int getCluster(uint32_t firstCluster, uint32_t clusterOffset,
   uint32_t entry = firstCluster;
 
   for (uint32_t i = 0; i < clusterOffset; i++) {
-    entry = getEntryInFat(entry);
+    if (getEntryInFat(entry, &entry) != FAT_NO_ERROR) {
+      entry = LAST_CLUSTER_OF_FILE; // chain can't be followed
+    }
     // last cluster reached before we reached clusterOffset
     if (entry == LAST_CLUSTER_OF_FILE) {
       *clusterNumber = entry; // return the entry
@@ -798,9 +911,12 @@ uint32_t convertClusterToSector(uint32_t cluster) {
 /**
  * @brief Gets FAT entry for given cluster
  * @param cluster Cluster number
- * @return FAT entry for given cluster
+ * @param entry FAT entry for given cluster (function writes this)
+ * @retval FAT_NO_ERROR Entry read
+ * @retval FAT_HAL_READ_ERROR Reading FAT sector failed
+ * @retval FAT_HAL_WRITE_ERROR Writing previous FAT sector failed
  */
-uint32_t getEntryInFat(uint32_t cluster) {
+FAT_ErrorTypedef getEntryInFat(uint32_t cluster, uint32_t* entry) {
 
   // Calculate the sector where the FAT entry for the cluster is located at.
   // Every entry is 4 bytes long. We divide the byte number where the entry
@@ -810,10 +926,11 @@ uint32_t getEntryInFat(uint32_t cluster) {
   uint32_t fatEntrySector = mountedDisks[0].partitionInfo[0].startFatSector +
       cluster * FAT_ENTRY_LENGHT_BYTES /
       mountedDisks[0].partitionInfo[0].bytesPerSector;
-  println("%s: FAT entry is at sector %d", __FUNCTION__, (unsigned int)fatEntrySector);
+  trace("%s: FAT entry is at sector %d", __FUNCTION__, (unsigned int)fatEntrySector);
 
-  if (readSector(fatEntrySector) != 0) {
-    // TODO Add error handling here
+  FAT_ErrorTypedef result = readSector(fatEntrySector);
+  if (result != FAT_NO_ERROR) {
+    return result;
   }
   // the byte number of the entry in the given sector is the remainder
   // of the previous calculation
@@ -823,9 +940,189 @@ uint32_t getEntryInFat(uint32_t cluster) {
   // the 4-byte entry is at the calculated offset
   uint32_t* fatEntry = (uint32_t*)(bufferForReadingSectors + entryOffsetInSector);
 
-  println("%s: Fat entry is %08x", __FUNCTION__, (unsigned int)*fatEntry);
+  trace("%s: Fat entry is %08x", __FUNCTION__, (unsigned int)*fatEntry);
 
-  return *fatEntry;
+  *entry = *fatEntry;
+  return FAT_NO_ERROR;
+}
+/**
+ * @brief Sets FAT entry for given cluster
+ * @details The entry is changed in the buffered sector of the first FAT.
+ * The sector is written to all FAT copies by flushFatSector, which is
+ * called when another sector is read into the buffer, so a chain update
+ * writes every FAT sector only once per copy.
+ * @param cluster Cluster number
+ * @param value New value of the entry
+ * @retval FAT_NO_ERROR Entry set
+ * @retval FAT_HAL_READ_ERROR Reading FAT sector failed
+ * @retval FAT_HAL_WRITE_ERROR Writing previous FAT sector failed
+ */
+FAT_ErrorTypedef setEntryInFat(uint32_t cluster, uint32_t value) {
+
+  const int FAT_ENTRY_LENGHT_BYTES = 4;
+  const uint32_t FAT_RESERVED_BITS = ~FAT_ENTRY_MASK;
+  FAT_PartitionInfo* partition = &mountedDisks[0].partitionInfo[0];
+
+  uint32_t fatEntrySector = partition->startFatSector +
+      cluster * FAT_ENTRY_LENGHT_BYTES / partition->bytesPerSector;
+  int entryOffsetInSector = (cluster * FAT_ENTRY_LENGHT_BYTES) %
+      partition->bytesPerSector;
+
+  FAT_ErrorTypedef result = readSector(fatEntrySector);
+  if (result != FAT_NO_ERROR) {
+    return result;
+  }
+  uint32_t* fatEntry = (uint32_t*)(bufferForReadingSectors + entryOffsetInSector);
+  // upper 4 bits are reserved and have to be preserved
+  *fatEntry = (*fatEntry & FAT_RESERVED_BITS) | (value & FAT_ENTRY_MASK);
+  dirtyFatSector = fatEntrySector;
+
+  return FAT_NO_ERROR;
+}
+/**
+ * @brief Writes modified FAT sector to all FAT copies.
+ * @retval FAT_NO_ERROR Sector written or nothing to write
+ * @retval FAT_HAL_WRITE_ERROR Writing failed
+ */
+FAT_ErrorTypedef flushFatSector(void) {
+
+  if (dirtyFatSector == UINT32_MAX) {
+    return FAT_NO_ERROR;
+  }
+
+  FAT_PartitionInfo* partition = &mountedDisks[0].partitionInfo[0];
+  uint32_t sector = dirtyFatSector;
+  dirtyFatSector = UINT32_MAX;
+
+  for (uint32_t i = 0; i < partition->numberOfFats; i++) {
+    FAT_ErrorTypedef result = writeSector(sector + i * partition->sectorsPerFat);
+    if (result != FAT_NO_ERROR) {
+      return result;
+    }
+  }
+  return FAT_NO_ERROR;
+}
+/**
+ * @brief Frees all clusters of a cluster chain.
+ * @details Contiguous runs of clusters are collected in freedExtents, so
+ * they can be erased after the metadata is written.
+ * @param firstCluster First cluster of the chain
+ * @retval FAT_NO_ERROR Chain freed in all FAT copies
+ * @retval FAT_HAL_READ_ERROR Reading FAT failed
+ * @retval FAT_HAL_WRITE_ERROR Writing FAT failed
+ */
+FAT_ErrorTypedef releaseClusterChain(uint32_t firstCluster) {
+
+  const uint32_t FIRST_DATA_CLUSTER = 2;
+  uint32_t cluster = firstCluster;
+  uint32_t extentStart = firstCluster;
+  uint32_t extentLength = 0;
+  freedExtentCount = 0;
+
+  while ((cluster >= FIRST_DATA_CLUSTER) && (cluster < FAT_MIN_END_OF_CHAIN)) {
+
+    uint32_t nextCluster;
+    FAT_ErrorTypedef result = getEntryInFat(cluster, &nextCluster);
+    if (result != FAT_NO_ERROR) {
+      return result;
+    }
+    nextCluster &= FAT_ENTRY_MASK;
+    result = setEntryInFat(cluster, FAT_FREE_CLUSTER);
+    if (result != FAT_NO_ERROR) {
+      return result;
+    }
+    extentLength++;
+
+    // chain is not contiguous anymore - store the current extent
+    if (nextCluster != cluster + 1) {
+      addFreedExtent(extentStart, extentLength);
+      extentStart = nextCluster;
+      extentLength = 0;
+    }
+    cluster = nextCluster;
+  }
+
+  return flushFatSector();
+}
+/**
+ * @brief Stores a range of freed clusters for erasing.
+ * @details Erase is only a hint for the medium, so extents which don't fit
+ * are left unerased.
+ * @param firstCluster First freed cluster
+ * @param clusterCount Number of freed clusters
+ */
+void addFreedExtent(uint32_t firstCluster, uint32_t clusterCount) {
+
+  if (freedExtentCount >= MAX_FREED_EXTENTS) {
+    println("%s: Too many extents, %u clusters not erased", __FUNCTION__,
+        (unsigned int)clusterCount);
+    return;
+  }
+  freedExtents[freedExtentCount].firstCluster = firstCluster;
+  freedExtents[freedExtentCount].clusterCount = clusterCount;
+  freedExtentCount++;
+}
+/**
+ * @brief Passes a range of freed clusters to the physical layer.
+ * @param firstCluster First freed cluster
+ * @param clusterCount Number of freed clusters
+ */
+void releaseExtent(uint32_t firstCluster, uint32_t clusterCount) {
+
+  if ((phyCallbacks.phyEraseSectors == NULL) || (clusterCount == 0)) {
+    return;
+  }
+
+  uint32_t sector = convertClusterToSector(firstCluster);
+  uint32_t count = clusterCount *
+      mountedDisks[0].partitionInfo[0].sectorsPerCluster;
+  println("%s: Erasing %u sectors from %u", __FUNCTION__,
+      (unsigned int)count, (unsigned int)sector);
+
+  if (phyCallbacks.phyEraseSectors(sector, count) != 0) {
+    // Erase is only a hint for the medium, data is already freed
+    logError("%s: Erase failed", __FUNCTION__);
+  }
+}
+/**
+ * @brief Marks a root directory entry and its long name entries as deleted.
+ * @param rootDirEntry Number of the short directory entry in root directory
+ * @retval FAT_NO_ERROR Entries marked
+ * @retval FAT_HAL_READ_ERROR Reading directory failed
+ * @retval FAT_HAL_WRITE_ERROR Writing directory failed
+ */
+FAT_ErrorTypedef markRootEntryDeleted(uint32_t rootDirEntry) {
+
+  const uint32_t ENTRIES_PER_SECTOR = BYTES_PER_SECTOR / sizeof(FAT_RootDirEntry);
+  uint32_t rootDirSector = convertClusterToSector(
+      mountedDisks[0].partitionInfo[0].rootDirCluster);
+  uint32_t entry = rootDirEntry;
+
+  while (TRUE) {
+    uint32_t sector = rootDirSector + entry / ENTRIES_PER_SECTOR;
+    FAT_ErrorTypedef result = readSector(sector);
+    if (result != FAT_NO_ERROR) {
+      return result;
+    }
+    FAT_RootDirEntry* dirEntry = (FAT_RootDirEntry*)bufferForReadingSectors +
+        entry % ENTRIES_PER_SECTOR;
+
+    // stop at the first entry preceding the file, which isn't its long name
+    if ((entry != rootDirEntry) &&
+        (dirEntry->attributes != FAT_LONG_NAME_ATTRIBUTES)) {
+      return FAT_NO_ERROR;
+    }
+    dirEntry->filename[0] = FAT_DELETED_ENTRY;
+    result = writeSector(sector);
+    if (result != FAT_NO_ERROR) {
+      return result;
+    }
+
+    if (entry == 0) {
+      return FAT_NO_ERROR;
+    }
+    entry--;
+  }
 }
 /**
  * @brief Finds next free ID of file
@@ -846,26 +1143,31 @@ int getNextId(void) {
 /**
  * @brief Convenience function for reading sectors.
  * @details It checks if the sector isn't in the buffer first
- * as a simple caching mechanism.
+ * as a simple caching mechanism. A modified FAT sector in the buffer is
+ * written before it is replaced.
  * @param sector Sector to read.
  */
 FAT_ErrorTypedef readSector(uint32_t sector) {
 
   const int NUMBER_OF_SECTORS_TO_READ = 1;
-  static uint32_t sectorCurrentlyInBuffer = UINT32_MAX;
 
   // check if we already read the sector
   if (sectorCurrentlyInBuffer == sector) {
-    println("%s: Sector %u already read", __FUNCTION__, sector);
+    trace("%s: Sector %u already read", __FUNCTION__, sector);
     return FAT_NO_ERROR;
   }
+  FAT_ErrorTypedef flushResult = flushFatSector();
+  if (flushResult != FAT_NO_ERROR) {
+    return flushResult;
+  }
+  sectorCurrentlyInBuffer = UINT32_MAX; // buffer is overwritten even if read fails
   int result = phyCallbacks.phyReadSectors(bufferForReadingSectors, sector,
       NUMBER_OF_SECTORS_TO_READ);
   if (result != 0) {
     return FAT_HAL_READ_ERROR;
   }
   sectorCurrentlyInBuffer = sector;
-  println("%s: Read sector %u", __FUNCTION__, (unsigned int) sector);
+  trace("%s: Read sector %u", __FUNCTION__, (unsigned int) sector);
 
   return FAT_NO_ERROR;
 }
@@ -880,7 +1182,7 @@ FAT_ErrorTypedef writeSector(uint32_t sector) {
   if (result != 0) {
     return FAT_HAL_WRITE_ERROR;
   }
-  println("%s: Written sector %u", __FUNCTION__, (unsigned int) sector);
+  trace("%s: Written sector %u", __FUNCTION__, (unsigned int) sector);
   return FAT_NO_ERROR;
 }
 /**
@@ -910,7 +1212,7 @@ int findFile(FAT_File* file) {
     // there are 16 entries per sector
     // Read new sector every 16 entries
     if ((i%16) == 0) {
-      println("%s: read new sector", __FUNCTION__);
+      trace("%s: read new sector", __FUNCTION__);
       // TODO Also change cluster
       // if whole cluster read - find next cluster
 //      if ((i%mountedDisks[0].partitionInfo[0].sectorsPerCluster) == 0) {
@@ -948,7 +1250,7 @@ int findFile(FAT_File* file) {
 
     if (dirEntry->filename[0] == 0x00) {
       // last root dir entry
-      println("%s: Last entry reached. File not found", __FUNCTION__);
+      trace("%s: Last entry reached. File not found", __FUNCTION__);
       return -1;
     }
 
@@ -50,6 +50,10 @@ int FAT_ReadFile(int file, uint8_t* data, int count);
 int FAT_MoveRdPtr(int file, int newWrPtr);
 int FAT_MoveWrPtr(int file, int newWrPtr);
 int FAT_WriteFile(int file, const uint8_t* data, int count);
+int FAT_DeleteFile(const char* filename);
+void FAT_SetEraseCallback(
+    int (*phyEraseSectors)(uint32_t sector, uint32_t count));
+void FAT_SetSectorCountCallback(uint64_t (*phySectorCount)(void));
 
 /**
  * @}
@@ -17,14 +17,12 @@
 
 #include <fifo.h>
 #include <stdio.h>
+#include <string.h>
 
-#ifdef DEBUG_FIFO
-  #define print(str, args...) printf("FIFO--> "str"%s",##args,"\r")
-  #define println(str, args...) printf("FIFO--> "str"%s",##args,"\r\n")
-#else
-  #define print(str, args...) (void)0
-  #define println(str, args...) (void)0
-#endif
+#define LOG_MODULE_PREFIX "FIFO--> "            ///< Prefix of log lines
+#define LOG_MODULE_LEVEL  LOG_LEVEL_FIFO        ///< Set with -DLOG_LEVEL_FIFO=<level>
+#define LOG_MODULE_DEFAULT_LEVEL LOG_LEVEL_NONE ///< Logging off by default
+#include "log_module.h"
 
 /**
  * @addtogroup FIFO
@@ -39,9 +37,12 @@
  * buffer pointer. The rest is handled automatically.
  *
  * @param fifo Pointer to FIFO structure
+ * @param dataBuffer Buffer for data
+ * @param length Length of the buffer (has to be a power of two)
  * @retval FIFO_OK FIFO added successfully
  * @retval FIFO_ZERO_LENGTH FIFO length is 0
  * @retval FIFO_NULL_BUFFER Received buffer is null
+ * @retval FIFO_LENGTH_NOT_POWER_OF_TWO FIFO length is not a power of two
  */
 FifoResultCode Fifo_addNewFifo(Fifo * fifo, char * dataBuffer, int length) {
 
@@ -53,16 +54,20 @@ FifoResultCode Fifo_addNewFifo(Fifo * fifo, char * dataBuffer, int length) {
     return FIFO_NULL_BUFFER;
   }
 
+  if (!IS_POWER_OF_TWO(length)) {
+    return FIFO_LENGTH_NOT_POWER_OF_TWO;
+  }
+
   fifo->dataBuffer = dataBuffer;
-  fifo->length = length;
-  fifo->tail  = 0;
-  fifo->head  = 0;
-  fifo->count = 0;
+  fifo->mask = length - 1;
+  fifo->tail = 0;
+  fifo->head = 0;
 
   return FIFO_OK;
 }
 /**
  * @brief Pushes data to FIFO.
+ * @details May be called only by the producer.
  * @param fifo Pointer to FIFO structure
  * @param newData Data byte
  * @retval FIFO_OK Data added
@@ -70,39 +75,40 @@ FifoResultCode Fifo_addNewFifo(Fifo * fifo, char * dataBuffer, int length) {
  */
 FifoResultCode Fifo_push(Fifo* fifo, char newData) {
 
-  // Check for overflow
-  if (fifo->count == fifo->length) {
+  unsigned int head = fifo->head;
+
+  // Check for overflow (slot is overwritten only after consumer has read it)
+  if (head - __atomic_load_n(&fifo->tail, __ATOMIC_ACQUIRE) > fifo->mask) {
     return FIFO_FULL;
   }
 
-  fifo->dataBuffer[fifo->head++] = newData;
-  fifo->count++;
-
-  if (fifo->head == fifo->length) {
-    fifo->head = 0; // start from beginning
-  }
+  fifo->dataBuffer[head & fifo->mask] = newData;
+  // data has to be in the buffer before consumer sees new head
+  __atomic_store_n(&fifo->head, head + 1, __ATOMIC_RELEASE);
 
   return FIFO_OK;
 }
 /**
  * @brief Pops data from the FIFO.
+ * @details May be called only by the consumer.
  * @param fifo Pointer to FIFO structure
  * @param c data
  * @retval FIFO_OK Got valid data
  * @retval FIFO_EMPTY FIFO is empty
  */
 FifoResultCode Fifo_pop(Fifo* fifo, char* c) {
-  if (fifo->count == 0) {
-    return FIFO_EMPTY;
-  }
 
-  *c = fifo->dataBuffer[fifo->tail++];
-  fifo->count--;
+  unsigned int tail = fifo->tail;
 
-  if (fifo->tail == fifo->length) {
-    fifo->tail = 0; // start from beginning
+  // read data only after seeing the head
+  if (__atomic_load_n(&fifo->head, __ATOMIC_ACQUIRE) == tail) {
+    return FIFO_EMPTY;
   }
 
+  *c = fifo->dataBuffer[tail & fifo->mask];
+  // data has to be read before producer sees the free space
+  __atomic_store_n(&fifo->tail, tail + 1, __ATOMIC_RELEASE);
+
   return FIFO_OK;
 }
 /**
@@ -112,19 +118,174 @@ FifoResultCode Fifo_pop(Fifo* fifo, char* c) {
  * @retval FALSE FIFO is not empty
  */
 Boolean Fifo_isEmpty(Fifo * fifo) {
-  if (fifo->count == 0) {
+  if (fifo->head == fifo->tail) {
     return TRUE;
   }
   return FALSE;
 }
+/**
+ * @brief Returns free space in the FIFO.
+ * @details Called by the producer the result is a lower bound (consumer can
+ * only free more space in the meantime).
+ * @param fifo Pointer to FIFO structure
+ * @return Number of bytes that can be pushed
+ */
+int Fifo_getFreeSpace(Fifo * fifo) {
+  return (int)(fifo->mask + 1 - (fifo->head - fifo->tail));
+}
+/**
+ * @brief Pushes a block of data to FIFO.
+ * @details May be called only by the producer. Data is copied with at most
+ * two memcpy calls (if it wraps around the end of the buffer).
+ * @param fifo Pointer to FIFO structure
+ * @param data Data to push
+ * @param length Length of data
+ * @return Number of bytes pushed (less than length if FIFO got full)
+ */
+int Fifo_write(Fifo * fifo, const char * data, int length) {
+
+  int written = 0;
+
+  while (written < length) {
+    char* block;
+    int count = Fifo_peekWrite(fifo, &block);
+    if (count == 0) {
+      break; // FIFO full
+    }
+    if (count > length - written) {
+      count = length - written;
+    }
+    memcpy(block, data + written, count);
+    Fifo_commitWrite(fifo, count);
+    written += count;
+  }
+
+  return written;
+}
+/**
+ * @brief Pops a block of data from FIFO.
+ * @details May be called only by the consumer. Data is copied with at most
+ * two memcpy calls (if it wraps around the end of the buffer).
+ * @param fifo Pointer to FIFO structure
+ * @param data Buffer for data
+ * @param maxLength Length of the buffer
+ * @return Number of bytes popped
+ */
+int Fifo_read(Fifo * fifo, char * data, int maxLength) {
+
+  int read = 0;
+
+  while (read < maxLength) {
+    char* block;
+    int count = Fifo_peekRead(fifo, &block);
+    if (count == 0) {
+      break; // FIFO empty
+    }
+    if (count > maxLength - read) {
+      count = maxLength - read;
+    }
+    memcpy(data + read, block, count);
+    Fifo_commitRead(fifo, count);
+    read += count;
+  }
+
+  return read;
+}
+/**
+ * @brief Gets the oldest contiguous block of data without removing it.
+ * @details The block ends either at the head or at the end of the buffer,
+ * so data wrapping around the end of the buffer is returned by two calls.
+ * The data stays in the FIFO (and can't be overwritten) until it is removed
+ * with Fifo_commitRead, so it can be passed directly to DMA.
+ * May be called only by the consumer.
+ * @param fifo Pointer to FIFO structure
+ * @param data Pointer to the beginning of the block
+ * @return Number of bytes in the block
+ */
+int Fifo_peekRead(Fifo * fifo, char ** data) {
+
+  unsigned int tail   = fifo->tail;
+  // read data only after seeing the head
+  unsigned int count  = __atomic_load_n(&fifo->head, __ATOMIC_ACQUIRE) - tail;
+  unsigned int offset = tail & fifo->mask;
+
+  if (count > fifo->mask + 1 - offset) {
+    count = fifo->mask + 1 - offset;
+  }
+
+  *data = fifo->dataBuffer + offset;
+
+  return (int)count;
+}
+/**
+ * @brief Removes data returned by Fifo_peekRead from the FIFO.
+ * @details May be called only by the consumer.
+ * @param fifo Pointer to FIFO structure
+ * @param count Number of bytes to remove
+ */
+void Fifo_commitRead(Fifo * fifo, int count) {
+
+  unsigned int tail = fifo->tail;
+  unsigned int available = fifo->head - tail;
+
+  if ((unsigned int)count > available) {
+    count = (int)available;
+  }
+
+  // data has to be read before producer sees the free space
+  __atomic_store_n(&fifo->tail, tail + count, __ATOMIC_RELEASE);
+}
+/**
+ * @brief Gets the largest contiguous free block of the FIFO.
+ * @details The block ends either at the tail or at the end of the buffer.
+ * Data written to the block becomes visible to the consumer after calling
+ * Fifo_commitWrite, so the block can be filled by DMA or memcpy.
+ * May be called only by the producer.
+ * @param fifo Pointer to FIFO structure
+ * @param data Pointer to the beginning of the free block
+ * @return Number of bytes in the block
+ */
+int Fifo_peekWrite(Fifo * fifo, char ** data) {
+
+  unsigned int head   = fifo->head;
+  // write data only after seeing the tail
+  unsigned int count  = fifo->mask + 1 -
+      (head - __atomic_load_n(&fifo->tail, __ATOMIC_ACQUIRE));
+  unsigned int offset = head & fifo->mask;
+
+  if (count > fifo->mask + 1 - offset) {
+    count = fifo->mask + 1 - offset;
+  }
+
+  *data = fifo->dataBuffer + offset;
+
+  return (int)count;
+}
+/**
+ * @brief Adds data written to the block returned by Fifo_peekWrite to the FIFO.
+ * @details May be called only by the producer.
+ * @param fifo Pointer to FIFO structure
+ * @param count Number of bytes to add
+ */
+void Fifo_commitWrite(Fifo * fifo, int count) {
+
+  unsigned int head = fifo->head;
+  unsigned int space = fifo->mask + 1 - (head - fifo->tail);
+
+  if ((unsigned int)count > space) {
+    count = (int)space;
+  }
+
+  // data has to be in the buffer before consumer sees new head
+  __atomic_store_n(&fifo->head, head + count, __ATOMIC_RELEASE);
+}
 /**
  * @brief Flush the FIFO
+ * @details May be called only by the consumer. Drops all data pushed so far.
  * @param fifo Pointer to FIFO structure
  */
 void Fifo_flush(Fifo * fifo) {
-  fifo->tail  = 0;
-  fifo->head  = 0;
-  fifo->count = 0;
+  fifo->tail = fifo->head;
 }
 /**
  * @}
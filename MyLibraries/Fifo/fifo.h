@@ -32,13 +32,17 @@
 
 /**
  * @brief FIFO structure typedef.
+ * @details Single producer single consumer ring buffer. Head is written only
+ * by the producer and tail only by the consumer, so a FIFO can be shared by
+ * an ISR and the main loop without disabling interrupts. Both indexes run
+ * freely and are masked when accessing the buffer, so the length has to be
+ * a power of two.
  */
 typedef struct {
-  int   head;       ///< Head
-  int   tail;       ///< Tail
-  char* dataBuffer; ///< Pointer to buffer
-  int   length;     ///< Maximum length of FIFO
-  int   count;      ///< Current number of data elements
+  volatile unsigned int head; ///< Number of pushed elements (written by producer)
+  volatile unsigned int tail; ///< Number of popped elements (written by consumer)
+  char*        dataBuffer;    ///< Pointer to buffer
+  unsigned int mask;          ///< Length of FIFO minus one
 } Fifo;
 /**
  * @brief Error codes
@@ -49,13 +53,21 @@ typedef enum {
   FIFO_NULL_BUFFER,//!< FIFO_NULL_BUFFER
   FIFO_FULL,       //!< FIFO_FULL
   FIFO_EMPTY,      //!< FIFO_EMPTY
+  FIFO_LENGTH_NOT_POWER_OF_TWO,//!< FIFO_LENGTH_NOT_POWER_OF_TWO
 } FifoResultCode;
 
 FifoResultCode Fifo_addNewFifo (Fifo * fifo, char * dataBuffer, int length);
 FifoResultCode Fifo_push       (Fifo * fifo, char newData);
 FifoResultCode Fifo_pop        (Fifo * fifo, char * data);
 Boolean        Fifo_isEmpty    (Fifo * fifo);
+int            Fifo_getFreeSpace(Fifo * fifo);
 void           Fifo_flush      (Fifo * fifo);
+int            Fifo_write      (Fifo * fifo, const char * data, int length);
+int            Fifo_read       (Fifo * fifo, char * data, int maxLength);
+int            Fifo_peekRead   (Fifo * fifo, char ** data);
+void           Fifo_commitRead (Fifo * fifo, int count);
+int            Fifo_peekWrite  (Fifo * fifo, char ** data);
+void           Fifo_commitWrite(Fifo * fifo, int count);
 /**
  * @}
  */
@@ -0,0 +1,143 @@
+/**
+ * @file    ring_buffer.h
+ * @brief   Typed single producer single consumer ring buffer
+ * @date    18.10.2026
+ * @author  Michal Ksiezopolski
+ *
+ * @verbatim
+ * Copyright (c) 2026 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef RING_BUFFER_H_
+#define RING_BUFFER_H_
+
+#include "utils.h"
+#include <string.h>
+
+/**
+ * @defgroup  RING_BUFFER RING_BUFFER
+ * @brief     Ring buffers for elements of any type
+ *
+ * @details RING_BUFFER_DEFINE generates a ring buffer type with static
+ * storage for a given element type and capacity, together with static
+ * inline functions for it. Like Fifo it works lock-free for one producer
+ * (e.g. sensor ISR) and one consumer (main loop). Capacity has to be a
+ * power of two. Example:
+ *
+ * @code
+ * typedef struct { int32_t pressure; int16_t temperature; } Sample;
+ * RING_BUFFER_DEFINE(SampleRing, Sample, 16)
+ *
+ * static SampleRing samples;
+ * SampleRing_initialize(&samples);
+ * SampleRing_push(&samples, &sample);              // in ISR
+ * int n = SampleRing_popBatch(&samples, batch, 8); // in main loop
+ * @endcode
+ */
+
+/**
+ * @addtogroup RING_BUFFER
+ * @{
+ */
+
+/**
+ * @brief Defines ring buffer type NAME for elements of TYPE and its functions.
+ * @param NAME Name of the ring buffer type and prefix of its functions
+ * @param TYPE Element type
+ * @param CAPACITY Number of elements (power of two)
+ */
+#define RING_BUFFER_DEFINE(NAME, TYPE, CAPACITY) \
+  typedef char NAME##_capacityIsPowerOfTwo[IS_POWER_OF_TWO(CAPACITY) ? 1 : -1]; \
+  \
+  typedef struct { \
+    volatile unsigned int head;     /* Number of pushed elements (written by producer) */ \
+    volatile unsigned int tail;     /* Number of popped elements (written by consumer) */ \
+    TYPE elements[CAPACITY];        /* Element storage */ \
+  } NAME; \
+  \
+  static inline void NAME##_initialize(NAME* ring) { \
+    ring->head = 0; \
+    ring->tail = 0; \
+  } \
+  \
+  static inline int NAME##_count(const NAME* ring) { \
+    return (int)(ring->head - ring->tail); \
+  } \
+  \
+  static inline Boolean NAME##_isEmpty(const NAME* ring) { \
+    return (ring->head == ring->tail) ? TRUE : FALSE; \
+  } \
+  \
+  static inline Boolean NAME##_push(NAME* ring, const TYPE* element) { \
+    unsigned int head = ring->head; \
+    if (head - ring->tail >= (CAPACITY)) { \
+      return FALSE; \
+    } \
+    ring->elements[head & ((CAPACITY) - 1)] = *element; \
+    MEMORY_BARRIER(); \
+    ring->head = head + 1; \
+    return TRUE; \
+  } \
+  \
+  static inline Boolean NAME##_pop(NAME* ring, TYPE* element) { \
+    unsigned int tail = ring->tail; \
+    if (ring->head == tail) { \
+      return FALSE; \
+    } \
+    MEMORY_BARRIER(); \
+    *element = ring->elements[tail & ((CAPACITY) - 1)]; \
+    MEMORY_BARRIER(); \
+    ring->tail = tail + 1; \
+    return TRUE; \
+  } \
+  \
+  static inline int NAME##_pushBatch(NAME* ring, const TYPE* elements, int count) { \
+    unsigned int head = ring->head; \
+    unsigned int space = (CAPACITY) - (head - ring->tail); \
+    if ((unsigned int)count > space) { \
+      count = (int)space; \
+    } \
+    MEMORY_BARRIER(); \
+    unsigned int offset = head & ((CAPACITY) - 1); \
+    unsigned int first = (CAPACITY) - offset; \
+    if (first > (unsigned int)count) { \
+      first = (unsigned int)count; \
+    } \
+    memcpy(&ring->elements[offset], elements, first * sizeof(TYPE)); \
+    memcpy(&ring->elements[0], elements + first, (count - first) * sizeof(TYPE)); \
+    MEMORY_BARRIER(); \
+    ring->head = head + count; \
+    return count; \
+  } \
+  \
+  static inline int NAME##_popBatch(NAME* ring, TYPE* elements, int maxCount) { \
+    unsigned int tail = ring->tail; \
+    unsigned int count = ring->head - tail; \
+    if (count > (unsigned int)maxCount) { \
+      count = (unsigned int)maxCount; \
+    } \
+    MEMORY_BARRIER(); \
+    unsigned int offset = tail & ((CAPACITY) - 1); \
+    unsigned int first = (CAPACITY) - offset; \
+    if (first > count) { \
+      first = count; \
+    } \
+    memcpy(elements, &ring->elements[offset], first * sizeof(TYPE)); \
+    memcpy(elements + first, &ring->elements[0], (count - first) * sizeof(TYPE)); \
+    MEMORY_BARRIER(); \
+    ring->tail = tail + count; \
+    return (int)count; \
+  }
+
+/**
+ * @}
+ */
+
+#endif /* RING_BUFFER_H_ */
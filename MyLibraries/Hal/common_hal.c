@@ -214,6 +214,24 @@ void CommonHal_errorHandler(void) {
 
   }
 }
+/**
+ * @brief Disables interrupts (enters critical section).
+ * @details Critical sections can be nested, every call has to be
+ * paired with CommonHal_restoreInterrupts.
+ * @return Previous interrupt state
+ */
+uint32_t CommonHal_disableInterrupts(void) {
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  return primask;
+}
+/**
+ * @brief Restores interrupts (leaves critical section).
+ * @param state Interrupt state returned by CommonHal_disableInterrupts
+ */
+void CommonHal_restoreInterrupts(uint32_t state) {
+  __set_PRIMASK(state);
+}
 /**
   * @brief   This function handles NMI exception.
   */
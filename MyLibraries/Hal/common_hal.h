@@ -19,7 +19,11 @@
 #ifndef INC_COMMON_HAL_H_
 #define INC_COMMON_HAL_H_
 
-void CommonHal_initialize(void);
-void CommonHal_errorHandler(void);
+#include <inttypes.h>
+
+void     CommonHal_initialize(void);
+void     CommonHal_errorHandler(void);
+uint32_t CommonHal_disableInterrupts(void);
+void     CommonHal_restoreInterrupts(uint32_t state);
 
 #endif /* INC_COMMON_HAL_H_ */
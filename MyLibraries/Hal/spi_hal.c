@@ -17,6 +17,8 @@
 
 #include "spi_hal.h"
 #include "common_hal.h"
+#include "utils.h"
+#include <stddef.h>
 #ifdef USE_F4_DISCOVERY
   #include <stm32f4xx_hal.h>
 #endif
@@ -65,11 +67,77 @@
 #define SPI1_MOSI_AF                     GPIO_AF5_SPI1
 #define SPI1_CS_PIN                      GPIO_PIN_4
 #define SPI1_CS_PORT                     GPIOA
+#define SPI1_AUX_CS_GPIO_CLK_ENABLE()    __HAL_RCC_GPIOC_CLK_ENABLE()
+#define SPI1_AUX_CS_PIN                  GPIO_PIN_4
+#define SPI1_AUX_CS_PORT                 GPIOC
 
 static SPI_HandleTypeDef spi1Handle;
 static SPI_HandleTypeDef spi3Handle;
 
-#define SPI_MAX_DELAY_TIME 500 ///< Maximum delay for polling mode
+#define SPI_MAX_BUSES      3   ///< Number of SPI peripherals (SpiNumber)
+#define DUMMY_BYTE         0xff ///< Sent in data phase without transmit data
+
+#ifdef USE_F7_DISCOVERY
+  #define SPI_MAX_BYTES_IN_FLIGHT 4 ///< Depth of the TX/RX FIFOs
+#else
+  #define SPI_MAX_BYTES_IN_FLIGHT 1 ///< No FIFO - wait for every received byte
+#endif
+
+/**
+ * @brief State of a SPI bus
+ */
+typedef struct {
+  Boolean isInitialized;      ///< Was the peripheral initialized
+  volatile Boolean isBusy;    ///< Is the bus owned by someone
+  int currentDevice;          ///< Device the bus is configured for (-1 - none)
+  SpiTransaction* queueHead;  ///< First queued transaction
+  SpiTransaction* queueTail;  ///< Last queued transaction
+} SpiBus;
+
+/**
+ * @brief Chip select pin
+ */
+typedef struct {
+  GPIO_TypeDef* port;
+  uint16_t      pin;
+} SpiChipSelectPin;
+
+static const SpiChipSelectPin chipSelectPins[] = {
+    {SPI1_CS_PORT,      SPI1_CS_PIN},     // SPI_HAL_CS_SPI1
+    {SPI1_AUX_CS_PORT,  SPI1_AUX_CS_PIN}, // SPI_HAL_CS_SPI1_AUX
+    {SPI3_CS_PORT,      SPI3_CS_PIN},     // SPI_HAL_CS_SPI3
+};
+
+static const uint32_t clockPrescalers[] = {
+    SPI_BAUDRATEPRESCALER_2,
+    SPI_BAUDRATEPRESCALER_4,
+    SPI_BAUDRATEPRESCALER_8,
+    SPI_BAUDRATEPRESCALER_16,
+    SPI_BAUDRATEPRESCALER_32,
+    SPI_BAUDRATEPRESCALER_64,
+    SPI_BAUDRATEPRESCALER_128,
+    SPI_BAUDRATEPRESCALER_256,
+};
+
+static SPI_HandleTypeDef* const handles[SPI_MAX_BUSES] = {
+    &spi1Handle,  // SPI_HAL_SPI1
+    NULL,         // SPI_HAL_SPI2 - not supported
+    &spi3Handle,  // SPI_HAL_SPI3
+};
+
+static SpiBus buses[SPI_MAX_BUSES];                 ///< State of buses
+static SpiDeviceConfig devices[SPI_HAL_MAX_DEVICES]; ///< Registered devices
+static int numberOfDevices;                          ///< Number of registered devices
+
+static SPI_HandleTypeDef* getHandle(SpiNumber spi);
+static void initializeChipSelect(SpiChipSelect chipSelect);
+static void setChipSelect(SpiChipSelect chipSelect, Boolean isSelected);
+static Boolean lockBus(SpiNumber spi);
+static void configureBus(int device);
+static void runQueue(SpiNumber spi);
+static void runTransaction(SpiTransaction* transaction);
+static void transferBurst(SpiNumber spi, const uint8_t* transmitBuffer,
+    uint8_t* receiveBuffer, int length);
 
 /**
  * @brief Initialize SPI and SS pin.
@@ -108,114 +176,143 @@ void SpiHal_initialize(SpiNumber spi) {
   if(HAL_SPI_Init(currentHandle) != HAL_OK) {
     CommonHal_errorHandler();
   }
+
+  // configuration was reset
+  buses[spi].isInitialized = TRUE;
+  buses[spi].currentDevice = -1;
 }
 /**
- * @brief Select chip.
+ * @brief Registers a device on a SPI bus.
+ * @details Initializes the bus (if it wasn't initialized) and
+ * the chip select pin of the device.
+ * @param config Configuration of the device
+ * @return Device ID or -1 if there is no space for new devices
  */
-void SpiHal_select(SpiNumber spi) {
-  switch(spi) {
-  case SPI_HAL_SPI3:
-    HAL_GPIO_WritePin(SPI3_CS_PORT, SPI3_CS_PIN, GPIO_PIN_RESET);
-    break;
+int SpiHal_addDevice(const SpiDeviceConfig* config) {
 
-  case SPI_HAL_SPI1:
-    HAL_GPIO_WritePin(SPI1_CS_PORT, SPI1_CS_PIN, GPIO_PIN_RESET);
-    break;
+  if (numberOfDevices >= SPI_HAL_MAX_DEVICES || getHandle(config->spi) == NULL) {
+    return -1;
+  }
 
-  default:
+  if (!buses[config->spi].isInitialized) {
+    SpiHal_initialize(config->spi);
+  }
+  initializeChipSelect(config->chipSelect);
+
+  devices[numberOfDevices] = *config;
+  return numberOfDevices++;
+}
+/**
+ * @brief Changes the clock of a device.
+ * @details E.g. SD cards have to be initialized with a slow clock
+ * and can be switched to a fast one afterwards. The bus is
+ * reconfigured before the next transfer to the device.
+ * @param device Device ID
+ * @param prescaler New clock prescaler
+ */
+void SpiHal_setClock(int device, SpiClockPrescaler prescaler) {
+  if (device < 0 || device >= numberOfDevices) {
     return;
   }
+  devices[device].prescaler = prescaler;
+  // force reconfiguration
+  if (buses[devices[device].spi].currentDevice == device) {
+    buses[devices[device].spi].currentDevice = -1;
+  }
 }
 /**
- * @brief Deselect chip.
+ * @brief Takes the bus for a device and selects the device.
+ * @details The bus is configured for the device (if another device
+ * was using it) and the chip select is held until SpiHal_release.
+ * In between the SpiHal_*Byte/Buffer functions may be used.
+ * @param device Device ID
+ * @retval 0 Bus acquired
+ * @retval -1 Bus is used by someone else (e.g. acquire called from
+ * an interrupt) - use SpiHal_submit instead
  */
-void SpiHal_deselect(SpiNumber spi) {
-  switch(spi) {
-  case SPI_HAL_SPI3:
-    HAL_GPIO_WritePin(SPI3_CS_PORT, SPI3_CS_PIN, GPIO_PIN_SET);
-    break;
+int SpiHal_acquire(int device) {
 
-  case SPI_HAL_SPI1:
-    HAL_GPIO_WritePin(SPI1_CS_PORT, SPI1_CS_PIN, GPIO_PIN_SET);
-    break;
+  if (device < 0 || device >= numberOfDevices) {
+    return -1;
+  }
+  if (!lockBus(devices[device].spi)) {
+    return -1;
+  }
+  configureBus(device);
+  setChipSelect(devices[device].chipSelect, TRUE);
+  return 0;
+}
+/**
+ * @brief Deselects the device and frees the bus.
+ * @details Transactions queued while the bus was taken are
+ * run before this function returns.
+ * @param device Device ID
+ */
+void SpiHal_release(int device) {
 
-  default:
+  if (device < 0 || device >= numberOfDevices) {
     return;
   }
+  setChipSelect(devices[device].chipSelect, FALSE);
+  runQueue(devices[device].spi);
+}
+/**
+ * @brief Queues a transaction.
+ * @details If the bus is free, the transaction (and all transactions
+ * queued in the meantime) is run immediately. Otherwise it is run by
+ * the current owner of the bus when it releases it. The function may
+ * be called from interrupts.
+ * @param transaction Transaction to run
+ */
+void SpiHal_submit(SpiTransaction* transaction) {
+
+  if (transaction->device < 0 || transaction->device >= numberOfDevices) {
+    return;
+  }
+  SpiNumber spi = devices[transaction->device].spi;
+  SpiBus* bus = &buses[spi];
+  transaction->next = NULL;
+
+  uint32_t interruptState = CommonHal_disableInterrupts();
+  if (bus->queueTail) {
+    bus->queueTail->next = transaction;
+  } else {
+    bus->queueHead = transaction;
+  }
+  bus->queueTail = transaction;
+
+  if (bus->isBusy) {
+    // owner of the bus will run the transaction
+    CommonHal_restoreInterrupts(interruptState);
+    return;
+  }
+  bus->isBusy = TRUE;
+  CommonHal_restoreInterrupts(interruptState);
+
+  runQueue(spi);
 }
 /**
  * @brief Send multiple data on SPI.
  * @param transmitBuffer Buffer to send.
  * @param length Number of bytes to send.
  * @warning Blocking function!
- * FIXME SD card not working with the commented out code
  */
 void SpiHal_sendBuffer(SpiNumber spi, uint8_t* transmitBuffer,
     int length) {
-
-  while (length--) {
-    SpiHal_transmitByte(spi, *transmitBuffer++);
-  }
-  return;
-
-//  SPI_HandleTypeDef * spiHandle;
-//
-//  switch (spi) {
-//  case SPI_HAL_SPI3:
-//    spiHandle = &spi3Handle;
-//    break;
-//
-//  case SPI_HAL_SPI1:
-//    spiHandle = &spi1Handle;
-//    break;
-//
-//  default:
-//    return;
-//  }
-//
-//  if (HAL_SPI_Transmit(spiHandle, (uint8_t*)transmitBuffer,
-//       length, SPI_MAX_DELAY_TIME) != HAL_OK) {
-//    COMMON_HAL_ErrorHandler();
-//  }
-
+  transferBurst(spi, transmitBuffer, NULL, length);
 }
 /**
  * @brief Read multiple data on SPI.
  * @param receiveBuffer Buffer to place read data.
  * @param length Number of bytes to read.
  * @warning Blocking function!
- * FIXME SD card not working with the commented out code
  */
 void SpiHal_readBuffer(SpiNumber spi, uint8_t* receiveBuffer,
     int length) {
-
-  while (length--) {
-    *receiveBuffer++ = SpiHal_transmitByte(spi, 0xff);
-  }
-  return;
-
-//  SPI_HandleTypeDef * spiHandle;
-//
-//  switch (spi) {
-//  case SPI_HAL_SPI3:
-//    spiHandle = &spi3Handle;
-//    break;
-//
-//  case SPI_HAL_SPI1:
-//    spiHandle = &spi1Handle;
-//    break;
-//
-//  default:
-//    return;
-//  }
-//
-//  if (HAL_SPI_Receive(spiHandle, (uint8_t*)receiveBuffer,
-//       length, SPI_MAX_DELAY_TIME) != HAL_OK) {
-//    COMMON_HAL_ErrorHandler();
-//  }
+  transferBurst(spi, NULL, receiveBuffer, length);
 }
 /**
- * @brief Transmit multiple data on SPI3.
+ * @brief Transmit multiple data on SPI.
  * @param receiveBuffer Receive buffer.
  * @param transmitBuffer Transmit buffer.
  * @param length Number of bytes to transmit.
@@ -223,59 +320,249 @@ void SpiHal_readBuffer(SpiNumber spi, uint8_t* receiveBuffer,
  */
 void SpiHal_transmitBuffer(SpiNumber spi, uint8_t* receiveBuffer,
     uint8_t* transmitBuffer, int length) {
+  transferBurst(spi, transmitBuffer, receiveBuffer, length);
+}
+/**
+ * @brief Sends and receives one byte to the SPI slave
+ * @param spi SPI to send data on
+ * @param dataToSend Data to send
+ * @return Received data
+ */
+uint8_t SpiHal_transmitByte(SpiNumber spi, uint8_t dataToSend) {
+  uint8_t receivedData = DUMMY_BYTE;
+  transferBurst(spi, &dataToSend, &receivedData, 1);
+  return receivedData;
+}
+/**
+ * @brief Sends and receives data using the SPI registers directly.
+ *
+ * @details The HAL polling functions check the state, lock and timeout
+ * for every byte. Here the data register is accessed directly, so the
+ * gap between bytes is only a few loop cycles. On F4 a byte is written
+ * only after the previous one was received (nothing is pipelined) -
+ * with the single data register an interrupt between two reads could
+ * otherwise cause an overrun. F7 has 4 byte FIFOs, so up to 4 bytes are
+ * in flight and the bus runs without gaps.
+ *
+ * @param spi SPI number
+ * @param transmitBuffer Data to send or NULL to send dummy bytes
+ * @param receiveBuffer Buffer for received data or NULL to drop them
+ * @param length Number of bytes
+ */
+void transferBurst(SpiNumber spi, const uint8_t* transmitBuffer,
+    uint8_t* receiveBuffer, int length) {
 
-  SPI_HandleTypeDef * spiHandle;
+  SPI_HandleTypeDef* spiHandle = getHandle(spi);
+  if (spiHandle == NULL) {
+    return;
+  }
 
-  switch (spi) {
-  case SPI_HAL_SPI3:
-    spiHandle = &spi3Handle;
-    break;
+  SPI_TypeDef* instance = spiHandle->Instance;
+  // 8-bit access, so the F7 FIFO packs single bytes
+  volatile uint8_t* dataRegister = (volatile uint8_t*)&instance->DR;
 
-  case SPI_HAL_SPI1:
-    spiHandle = &spi1Handle;
-    break;
+#ifdef USE_F7_DISCOVERY
+  // RXNE when FIFO holds one byte
+  SET_BIT(instance->CR2, SPI_CR2_FRXTH);
+#endif
+  if ((instance->CR1 & SPI_CR1_SPE) == 0) {
+    __HAL_SPI_ENABLE(spiHandle);
+  }
+  // drop stale data
+  while (instance->SR & SPI_SR_RXNE) {
+    (void)*dataRegister;
+  }
+
+  int bytesToSend = length;
+  int bytesToReceive = length;
+
+  while (bytesToReceive > 0) {
+    if ((bytesToSend > 0) && (instance->SR & SPI_SR_TXE) &&
+        (bytesToReceive - bytesToSend < SPI_MAX_BYTES_IN_FLIGHT)) {
+      *dataRegister = transmitBuffer ? *transmitBuffer++ : DUMMY_BYTE;
+      bytesToSend--;
+    }
+    if (instance->SR & SPI_SR_RXNE) {
+      uint8_t data = *dataRegister;
+      if (receiveBuffer) {
+        *receiveBuffer++ = data;
+      }
+      bytesToReceive--;
+    }
+  }
+}
+/**
+ * @brief Gets the HAL handle of a bus.
+ * @param spi SPI number
+ * @return Handle or NULL if the SPI is not supported
+ */
+SPI_HandleTypeDef* getHandle(SpiNumber spi) {
+  if ((unsigned int)spi >= SPI_MAX_BUSES) {
+    return NULL;
+  }
+  return handles[spi];
+}
+/**
+ * @brief Initializes a chip select pin (device not selected).
+ * @param chipSelect Chip select line
+ */
+void initializeChipSelect(SpiChipSelect chipSelect) {
+
+  GPIO_InitTypeDef  gpioInitialization;
 
+  switch (chipSelect) {
+  case SPI_HAL_CS_SPI1:
+    SPI1_CS_GPIO_CLK_ENABLE();
+    break;
+  case SPI_HAL_CS_SPI1_AUX:
+    SPI1_AUX_CS_GPIO_CLK_ENABLE();
+    break;
+  case SPI_HAL_CS_SPI3:
+    SPI3_CS_GPIO_CLK_ENABLE();
+    break;
   default:
     return;
   }
 
-  if (HAL_SPI_TransmitReceive(spiHandle, (uint8_t*)transmitBuffer,
-      (uint8_t *)receiveBuffer, length, SPI_MAX_DELAY_TIME) != HAL_OK) {
-    CommonHal_errorHandler();
+  // deselect before switching pin to output
+  setChipSelect(chipSelect, FALSE);
+
+  gpioInitialization.Pin    = chipSelectPins[chipSelect].pin;
+  gpioInitialization.Mode   = GPIO_MODE_OUTPUT_PP;
+  gpioInitialization.Speed  = GPIO_SPEED_FREQ_VERY_HIGH;
+  gpioInitialization.Pull   = GPIO_NOPULL;
+  HAL_GPIO_Init(chipSelectPins[chipSelect].port, &gpioInitialization);
+}
+/**
+ * @brief Drives a chip select pin (active low).
+ * @param chipSelect Chip select line
+ * @param isSelected TRUE to select device
+ */
+void setChipSelect(SpiChipSelect chipSelect, Boolean isSelected) {
+  HAL_GPIO_WritePin(chipSelectPins[chipSelect].port,
+      chipSelectPins[chipSelect].pin,
+      isSelected ? GPIO_PIN_RESET : GPIO_PIN_SET);
+}
+/**
+ * @brief Takes a bus if it is free.
+ * @param spi SPI number
+ * @retval TRUE Bus was taken
+ * @retval FALSE Bus is busy
+ */
+Boolean lockBus(SpiNumber spi) {
+  Boolean wasTaken = FALSE;
+  uint32_t interruptState = CommonHal_disableInterrupts();
+  if (!buses[spi].isBusy) {
+    buses[spi].isBusy = TRUE;
+    wasTaken = TRUE;
   }
+  CommonHal_restoreInterrupts(interruptState);
+  return wasTaken;
 }
 /**
- * @brief Sends and receives one byte to the SPI slave
- * @param spi SPI to send data on
- * @param dataToSend Data to send
- * @return Received data
+ * @brief Configures clock and mode of the bus for a device.
+ * @details The peripheral is only reconfigured when the device
+ * changes and has different settings than the previous one.
+ * @param device Device ID
  */
-uint8_t SpiHal_transmitByte(SpiNumber spi, uint8_t dataToSend) {
+void configureBus(int device) {
 
-  const uint8_t INVALID_DATA = 0xff;
+  SpiNumber spi = devices[device].spi;
 
-  SPI_HandleTypeDef * spiHandle;
+  if (buses[spi].currentDevice == device) {
+    return;
+  }
+  buses[spi].currentDevice = device;
+
+  SPI_HandleTypeDef* spiHandle = getHandle(spi);
+  SpiMode mode = devices[device].mode;
+  uint32_t prescaler = clockPrescalers[devices[device].prescaler];
+  uint32_t polarity = (mode == SPI_HAL_MODE_2 || mode == SPI_HAL_MODE_3) ?
+      SPI_POLARITY_HIGH : SPI_POLARITY_LOW;
+  uint32_t phase = (mode == SPI_HAL_MODE_1 || mode == SPI_HAL_MODE_3) ?
+      SPI_PHASE_2EDGE : SPI_PHASE_1EDGE;
+
+  if ((spiHandle->Init.BaudRatePrescaler == prescaler) &&
+      (spiHandle->Init.CLKPolarity == polarity) &&
+      (spiHandle->Init.CLKPhase == phase)) {
+    return;
+  }
+  spiHandle->Init.BaudRatePrescaler = prescaler;
+  spiHandle->Init.CLKPolarity = polarity;
+  spiHandle->Init.CLKPhase = phase;
+
+  // settings can only be changed when SPI is disabled,
+  // HAL enables it again before next transfer
+  __HAL_SPI_DISABLE(spiHandle);
+  MODIFY_REG(spiHandle->Instance->CR1,
+      SPI_CR1_BR | SPI_CR1_CPOL | SPI_CR1_CPHA,
+      prescaler | polarity | phase);
+}
+/**
+ * @brief Runs queued transactions and frees the bus.
+ * @details Called by the owner of the bus.
+ * @param spi SPI number
+ */
+void runQueue(SpiNumber spi) {
+
+  SpiBus* bus = &buses[spi];
+
+  while (TRUE) {
+    uint32_t interruptState = CommonHal_disableInterrupts();
+    SpiTransaction* transaction = bus->queueHead;
+    if (transaction == NULL) {
+      // nothing left - free the bus
+      bus->isBusy = FALSE;
+      CommonHal_restoreInterrupts(interruptState);
+      return;
+    }
+    bus->queueHead = transaction->next;
+    if (bus->queueHead == NULL) {
+      bus->queueTail = NULL;
+    }
+    CommonHal_restoreInterrupts(interruptState);
+
+    runTransaction(transaction);
+  }
+}
+/**
+ * @brief Runs a single transaction.
+ * @param transaction Transaction to run
+ */
+void runTransaction(SpiTransaction* transaction) {
 
-  switch (spi) {
-  case SPI_HAL_SPI3:
-    spiHandle = &spi3Handle;
-    break;
+  SpiDeviceConfig* device = &devices[transaction->device];
 
-  case SPI_HAL_SPI1:
-    spiHandle = &spi1Handle;
-    break;
+  configureBus(transaction->device);
+  setChipSelect(device->chipSelect, TRUE);
 
-  default:
-    return INVALID_DATA;
+  if (transaction->commandLength > 0) {
+    SpiHal_sendBuffer(device->spi, (uint8_t*)transaction->command,
+        transaction->commandLength);
   }
 
-  uint8_t receivedData;
+  if (transaction->dataLength > 0) {
+    if (transaction->transmitData && transaction->receiveData) {
+      SpiHal_transmitBuffer(device->spi, transaction->receiveData,
+          (uint8_t*)transaction->transmitData, transaction->dataLength);
+    } else if (transaction->transmitData) {
+      SpiHal_sendBuffer(device->spi, (uint8_t*)transaction->transmitData,
+          transaction->dataLength);
+    } else if (transaction->receiveData) {
+      SpiHal_readBuffer(device->spi, transaction->receiveData,
+          transaction->dataLength);
+    } else {
+      for (int i = 0; i < transaction->dataLength; i++) {
+        SpiHal_transmitByte(device->spi, DUMMY_BYTE);
+      }
+    }
+  }
 
-  if (HAL_SPI_TransmitReceive(spiHandle, &dataToSend,
-      &receivedData, 1, SPI_MAX_DELAY_TIME) != HAL_OK) {
-    CommonHal_errorHandler();
+  setChipSelect(device->chipSelect, FALSE);
+
+  if (transaction->callback) {
+    transaction->callback(transaction);
   }
-  return receivedData;
 }
 /**
  * @brief Initalize SPI HAL driver
@@ -288,7 +575,6 @@ void HAL_SPI_MspInit(SPI_HandleTypeDef *spiHandle) {
     SPI3_SCK_GPIO_CLK_ENABLE();
     SPI3_MISO_GPIO_CLK_ENABLE();
     SPI3_MOSI_GPIO_CLK_ENABLE();
-    SPI3_CS_GPIO_CLK_ENABLE();
     SPI3_CLK_ENABLE();
 
     gpioInitialization.Pin       = SPI3_SCK_PIN;
@@ -306,18 +592,10 @@ void HAL_SPI_MspInit(SPI_HandleTypeDef *spiHandle) {
     gpioInitialization.Alternate = SPI3_MOSI_AF;
     HAL_GPIO_Init(SPI3_MOSI_GPIO_PORT, &gpioInitialization);
 
-    gpioInitialization.Pin    = SPI3_CS_PIN;
-    gpioInitialization.Mode   = GPIO_MODE_OUTPUT_PP;
-    gpioInitialization.Speed  = GPIO_SPEED_FAST;
-    gpioInitialization.Pull   = GPIO_NOPULL;
-    HAL_GPIO_Init(SPI3_CS_PORT, &gpioInitialization);
-    HAL_GPIO_WritePin(SPI3_CS_PORT, SPI3_CS_PIN, GPIO_PIN_SET);
-
   } else if (spiHandle == &spi1Handle) {
     SPI1_SCK_GPIO_CLK_ENABLE();
     SPI1_MISO_GPIO_CLK_ENABLE();
     SPI1_MOSI_GPIO_CLK_ENABLE();
-    SPI1_CS_GPIO_CLK_ENABLE();
     SPI1_CLK_ENABLE();
 
     gpioInitialization.Pin       = SPI1_SCK_PIN;
@@ -334,13 +612,6 @@ void HAL_SPI_MspInit(SPI_HandleTypeDef *spiHandle) {
     gpioInitialization.Pin = SPI1_MOSI_PIN;
     gpioInitialization.Alternate = SPI1_MOSI_AF;
     HAL_GPIO_Init(SPI1_MOSI_GPIO_PORT, &gpioInitialization);
-
-    gpioInitialization.Pin    = SPI1_CS_PIN;
-    gpioInitialization.Mode   = GPIO_MODE_OUTPUT_PP;
-    gpioInitialization.Speed  = GPIO_SPEED_FREQ_VERY_HIGH;
-    gpioInitialization.Pull   = GPIO_NOPULL;
-    HAL_GPIO_Init(SPI1_CS_PORT, &gpioInitialization);
-    HAL_GPIO_WritePin(SPI1_CS_PORT, SPI1_CS_PIN, GPIO_PIN_SET);
   }
 
 }
@@ -356,13 +627,11 @@ void HAL_SPI_MspDeInit(SPI_HandleTypeDef *spiHandle) {
     HAL_GPIO_DeInit(SPI3_SCK_GPIO_PORT, SPI3_SCK_PIN);
     HAL_GPIO_DeInit(SPI3_MISO_GPIO_PORT, SPI3_MISO_PIN);
     HAL_GPIO_DeInit(SPI3_MOSI_GPIO_PORT, SPI3_MOSI_PIN);
-    HAL_GPIO_DeInit(SPI3_CS_PORT, SPI3_CS_PIN);
 
   } else if (spiHandle == &spi1Handle) {
     HAL_GPIO_DeInit(SPI1_SCK_GPIO_PORT, SPI1_SCK_PIN);
     HAL_GPIO_DeInit(SPI1_MISO_GPIO_PORT, SPI1_MISO_PIN);
     HAL_GPIO_DeInit(SPI1_MOSI_GPIO_PORT, SPI1_MOSI_PIN);
-    HAL_GPIO_DeInit(SPI1_CS_PORT, SPI1_CS_PIN);
   }
 }
 /**
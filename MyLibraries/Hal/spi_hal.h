@@ -37,10 +37,72 @@ typedef enum {
   SPI_HAL_SPI2,//!< SPI_HAL_SPI2
   SPI_HAL_SPI3,//!< SPI_HAL_SPI3
 } SpiNumber;
+/**
+ * @brief Chip select lines
+ */
+typedef enum {
+  SPI_HAL_CS_SPI1,      //!< PA4 - SD card
+  SPI_HAL_CS_SPI1_AUX,  //!< PC4 - MFRC522 RFID reader
+  SPI_HAL_CS_SPI3,      //!< PA15 - TSC2046 touch screen
+} SpiChipSelect;
+/**
+ * @brief SPI clock prescaler (divides the APB clock)
+ */
+typedef enum {
+  SPI_HAL_CLOCK_DIV_2,
+  SPI_HAL_CLOCK_DIV_4,
+  SPI_HAL_CLOCK_DIV_8,
+  SPI_HAL_CLOCK_DIV_16,
+  SPI_HAL_CLOCK_DIV_32,
+  SPI_HAL_CLOCK_DIV_64,
+  SPI_HAL_CLOCK_DIV_128,
+  SPI_HAL_CLOCK_DIV_256,
+} SpiClockPrescaler;
+/**
+ * @brief SPI clock polarity and phase
+ */
+typedef enum {
+  SPI_HAL_MODE_0, //!< CPOL = 0, CPHA = 0
+  SPI_HAL_MODE_1, //!< CPOL = 0, CPHA = 1
+  SPI_HAL_MODE_2, //!< CPOL = 1, CPHA = 0
+  SPI_HAL_MODE_3, //!< CPOL = 1, CPHA = 1
+} SpiMode;
+/**
+ * @brief Configuration of a device on the SPI bus
+ */
+typedef struct {
+  SpiNumber         spi;        ///< Bus of the device
+  SpiChipSelect     chipSelect; ///< Chip select line of the device
+  SpiClockPrescaler prescaler;  ///< Clock used for the device
+  SpiMode           mode;       ///< Clock polarity and phase used for the device
+} SpiDeviceConfig;
+
+#define SPI_HAL_MAX_DEVICES 4 ///< Maximum number of registered devices
+
+/**
+ * @brief SPI transaction
+ * @details A transaction has a command phase (received bytes are
+ * dropped) followed by a data phase. The chip select is held during
+ * the whole transaction. The structure is linked into the queue of
+ * the bus, so it has to stay valid until the callback is called.
+ */
+typedef struct SpiTransaction {
+  int device;                  ///< Device ID from SpiHal_addDevice
+  const uint8_t* command;      ///< Command bytes, may be NULL
+  int commandLength;           ///< Number of command bytes
+  const uint8_t* transmitData; ///< Data to send, NULL sends dummy bytes (0xff)
+  uint8_t* receiveData;        ///< Buffer for received data, may be NULL
+  int dataLength;              ///< Number of data bytes
+  void (*callback)(struct SpiTransaction* transaction); ///< Called after the transaction, may be NULL
+  struct SpiTransaction* next; ///< Used internally by the queue
+} SpiTransaction;
 
 void    SpiHal_initialize    (SpiNumber spi);
-void    SpiHal_select        (SpiNumber spi);
-void    SpiHal_deselect      (SpiNumber spi);
+int     SpiHal_addDevice     (const SpiDeviceConfig* config);
+void    SpiHal_setClock      (int device, SpiClockPrescaler prescaler);
+int     SpiHal_acquire       (int device);
+void    SpiHal_release       (int device);
+void    SpiHal_submit        (SpiTransaction* transaction);
 uint8_t SpiHal_transmitByte  (SpiNumber spi, uint8_t dataToSend);
 void    SpiHal_readBuffer    (SpiNumber spi, uint8_t* receiveBuffer, int length);
 void    SpiHal_sendBuffer    (SpiNumber spi, uint8_t* transmitBuffer, int length);
@@ -19,151 +19,199 @@
 #include "usart.h"
 #if defined(USE_F4_DISCOVERY)
   #include <stm32f4xx_hal.h>
+  #include "usart_f4_discovery_defs.h"
 #elif defined(USE_F7_DISCOVERY)
   #include <stm32f7xx_hal.h>
+  #include "usart_f7_discovery_defs.h"
 #else
   #error "No board defined"
 #endif
 
-#include "usart_f4_discovery_defs.h"
-#include "usart_f7_discovery_defs.h"
-
 /**
  * @addtogroup UART
  * @{
  */
 
+#ifndef USART_RX_DMA_BUFFER_LENGTH
+  #define USART_RX_DMA_BUFFER_LENGTH 64     ///< Length of the circular DMA receive buffer
+#endif
+
+/**
+ * @brief Indexes of USARTs available on the board
+ */
+enum {
+#ifdef USART1_IRQ_NUMBER
+  USART1_INDEX,
+#endif
+#ifdef USART2_IRQ_NUMBER
+  USART2_INDEX,
+#endif
+#ifdef USART6_IRQ_NUMBER
+  USART6_INDEX,
+#endif
+  USART_COUNT, ///< Number of available USARTs
+};
+
+/**
+ * @brief USART hardware description
+ */
+typedef struct {
+  USART_TypeDef*      instance;     ///< USART peripheral
+  GPIO_TypeDef*       txPort;       ///< TX pin port
+  uint32_t            txPin;        ///< TX pin
+  uint32_t            txAlternate;  ///< TX pin alternate function
+  GPIO_TypeDef*       rxPort;       ///< RX pin port
+  uint32_t            rxPin;        ///< RX pin
+  uint32_t            rxAlternate;  ///< RX pin alternate function
+  IRQn_Type           irq;          ///< USART IRQ number
+  uint32_t            irqPriority;  ///< Priority of USART and DMA IRQs
+  DMA_Stream_TypeDef* rxDmaStream;  ///< RX DMA stream
+  uint32_t            rxDmaChannel; ///< RX DMA channel
+  IRQn_Type           rxDmaIrq;     ///< RX DMA IRQ number
+  DMA_Stream_TypeDef* txDmaStream;  ///< TX DMA stream
+  uint32_t            txDmaChannel; ///< TX DMA channel
+  IRQn_Type           txDmaIrq;     ///< TX DMA IRQ number
+} UsartHardware;
+
+/**
+ * @brief State of a USART instance
+ */
+typedef struct {
+  UART_HandleTypeDef handle;        ///< Handle for UART peripheral (has to be first - HAL callbacks get its address)
+  DMA_HandleTypeDef  rxDmaHandle;   ///< Handle for RX DMA stream
+  DMA_HandleTypeDef  txDmaHandle;   ///< Handle for TX DMA stream
+  void (*rxCallback)(const char*, int); ///< Callback function for receiving data (gets spans of received bytes)
+  int  (*txCallback)(int, const char**);///< Callback function for transmitting data (releases sent data and gets next block)
+  char rxDmaBuffer[USART_RX_DMA_BUFFER_LENGTH]; ///< Circular buffer filled by the RX DMA
+  int  rxReadPosition;              ///< Position in rxDmaBuffer up to which data was passed to upper layer
+  int  txLength;                    ///< Length of the block currently sent by the TX DMA
+  volatile Boolean isSendingData;   ///< Flag saying if UART is currently sending any data
+} UsartInstance;
+
+/**
+ * @brief Fills hardware description of USART number n from board definitions
+ */
+#define USART_HARDWARE(n) { \
+    USART##n, \
+    USART##n##_TX_GPIO_PORT, USART##n##_TX_PIN, USART##n##_TX_AF, \
+    USART##n##_RX_GPIO_PORT, USART##n##_RX_PIN, USART##n##_RX_AF, \
+    USART##n##_IRQ_NUMBER, USART##n##_IRQ_PRIORITY, \
+    USART##n##_RX_DMA_STREAM, USART##n##_RX_DMA_CHANNEL, USART##n##_RX_DMA_IRQ_NUMBER, \
+    USART##n##_TX_DMA_STREAM, USART##n##_TX_DMA_CHANNEL, USART##n##_TX_DMA_IRQ_NUMBER, \
+  }
 
-#define RECEIVE_BUFFER_LENGTH 1             ///< Length of the low level receive buffer
-static void (*rxCallback)(char);            ///< Callback function for receiving data
-static int  (*txCallback)(char*);           ///< Callback function for transmitting data (fills up buffer with data to send)
+static const UsartHardware hardware[USART_COUNT] = {
+#ifdef USART1_IRQ_NUMBER
+  [USART1_INDEX] = USART_HARDWARE(1),
+#endif
+#ifdef USART2_IRQ_NUMBER
+  [USART2_INDEX] = USART_HARDWARE(2),
+#endif
+#ifdef USART6_IRQ_NUMBER
+  [USART6_INDEX] = USART_HARDWARE(6),
+#endif
+};
 
-static char rxBuffer[RECEIVE_BUFFER_LENGTH];///< Reception buffer - we receive one character at a time
-static volatile Boolean isSendingData;      ///< Flag saying if UART is currently sending any data
+static UsartInstance usarts[USART_COUNT]; ///< State of USARTs
 
-static UART_HandleTypeDef usart1Handle;     ///< Handle for UART peripheral
-static UART_HandleTypeDef usart2Handle;     ///< Handle for UART peripheral
-static UART_HandleTypeDef usart6Handle;     ///< Handle for UART peripheral
+static UsartInstance* getInstance(UsartNumber usart);
+static void enableClocks(UART_HandleTypeDef * usartHandle);
+static void resetUsart(UART_HandleTypeDef * usartHandle);
+static void sendData(UsartInstance * usart);
+static void startReception(UsartInstance * usart);
+static void processReceivedData(UsartInstance * usart);
+static void handleUsartIrq(UsartInstance * usart);
+static void initializeDma(UART_HandleTypeDef * usartHandle, DMA_HandleTypeDef * dmaHandle,
+    DMA_Stream_TypeDef * stream, uint32_t channel, uint32_t direction);
 
 /**
- * @brief Enables UART IRQ
+ * @brief Enables UART IRQ (and TX DMA IRQ)
  */
 void Usart_enableIrq(UsartNumber usart) {
-  switch(usart) {
-  case USART_HAL_USART1:
-    break;
-  case USART_HAL_USART2:
-    HAL_NVIC_EnableIRQ(USART2_IRQ_NUMBER);
-    break;
-  case USART_HAL_USART6:
-    HAL_NVIC_EnableIRQ(USART6_IRQ_NUMBER);
-    break;
+  UsartInstance* instance = getInstance(usart);
+  if (instance == NULL) {
+    return;
   }
+  const UsartHardware* hw = &hardware[instance - usarts];
+  HAL_NVIC_EnableIRQ(hw->txDmaIrq);
+  HAL_NVIC_EnableIRQ(hw->irq);
 }
 /**
- * @brief Disables UART IRQ
+ * @brief Disables UART IRQ (and TX DMA IRQ)
  */
 void Usart_disableIrq(UsartNumber usart) {
-  switch(usart) {
-  case USART_HAL_USART1:
-    break;
-  case USART_HAL_USART2:
-    HAL_NVIC_DisableIRQ(USART2_IRQ_NUMBER);
-    break;
-  case USART_HAL_USART6:
-    HAL_NVIC_DisableIRQ(USART6_IRQ_NUMBER);
-    break;
+  UsartInstance* instance = getInstance(usart);
+  if (instance == NULL) {
+    return;
   }
+  const UsartHardware* hw = &hardware[instance - usarts];
+  HAL_NVIC_DisableIRQ(hw->irq);
+  HAL_NVIC_DisableIRQ(hw->txDmaIrq);
 }
 /**
  * @brief Checks if UART is currently sending any data
  * @details If so the IRQ will automatically get new data from the FIFO. If not we
- * have to explicitly call HAL_UART_SendData to enable the TX IRQ.
+ * have to explicitly call Usart_sendDataIrq to start the TX DMA.
  * @retval TRUE UART is sending data
  * @retval FALSE UART is not sending data
  */
 Boolean Usart_isSendingData(UsartNumber usart) {
-  switch(usart) {
-  case USART_HAL_USART1:
-    return isSendingData;
-  case USART_HAL_USART2:
-    return isSendingData;
-  case USART_HAL_USART6:
-    return isSendingData;
-  default:
+  UsartInstance* instance = getInstance(usart);
+  if (instance == NULL) {
     return FALSE;
   }
+  return instance->isSendingData;
 }
 /**
- * @brief Sends data using the UART IRQ
- * @details This function is called automatically when the TX IRQ is running.
- * However if the IRQ is not running this function has to be called manually to
- * enable the IRQ.
+ * @brief Sends data using the UART TX DMA
+ * @details The transmit callback releases the previously sent block and
+ * returns the next contiguous block, which is sent by DMA directly from
+ * the upper layer buffer. This function is called automatically when a
+ * transfer completes. However if no transfer is running this function
+ * has to be called manually to start the DMA.
+ *
+ * Interrupts are disabled while the transfer is started, so the UART
+ * callbacks never find the HAL handle locked by the main loop.
  */
 void Usart_sendDataIrq(UsartNumber usart) {
-
-  UART_HandleTypeDef * usartHandle;
-
-  switch(usart) {
-  case USART_HAL_USART1:
-    usartHandle = &usart1Handle;
-    break;
-  case USART_HAL_USART2:
-    usartHandle = &usart2Handle;
-    break;
-  case USART_HAL_USART6:
-    usartHandle = &usart6Handle;
-    break;
-  }
-
-  // has to be static to serve as a buffer for UART
-  static char buf[UART_BUF_LEN_TX];
-
-  // if no function set do nothing
-  if (txCallback == NULL) {
+  UsartInstance* instance = getInstance(usart);
+  if (instance == NULL) {
     return;
   }
-
-  // get the data
-  int numberOfBytes = txCallback(buf);
-
-  // if there is any data in the FIFO
-  if (numberOfBytes > 0) {
-    // send it to PC
-    if (HAL_UART_Transmit_IT(usartHandle, (uint8_t*)buf, numberOfBytes) != HAL_OK) {
-      CommonHal_errorHandler();
-    }
-    isSendingData = TRUE;
-  } else {
-    isSendingData = FALSE;
-  }
+  uint32_t interruptState = CommonHal_disableInterrupts();
+  sendData(instance);
+  CommonHal_restoreInterrupts(interruptState);
 }
 /**
  * @brief Initialize UART
+ * @details Every USART has its own callbacks, buffers and DMA streams,
+ * so several ports can be used at the same time.
+ * Data is received by DMA into a circular buffer. The receive callback
+ * gets contiguous spans of received bytes on half transfer, transfer complete
+ * and idle line events, so the number of interrupts doesn't depend on the baud rate.
+ * @param usart USART number
  * @param baud Baud rate
- * @param rxCb Receive callback
- * @param txCb Transmit callback
+ * @param rxCb Receive callback (gets received data and its length)
+ * @param txCb Transmit callback (gets the number of sent bytes to release and
+ * returns the next contiguous block of data to send and its length)
  */
-void Usart_initialize(UsartNumber usart, int baud, void(*rxCb)(char), int(*txCb)(char*) ) {
-
-  txCallback = txCb;
-  rxCallback = rxCb;
+void Usart_initialize(UsartNumber usart, int baud, void(*rxCb)(const char*, int),
+    int(*txCb)(int, const char**)) {
 
-  UART_HandleTypeDef * usartHandle;
+  UsartInstance* instance = getInstance(usart);
 
-  switch(usart) {
-  case USART_HAL_USART2:
-    usart2Handle.Instance = USART2;
-    usartHandle = &usart2Handle;
-    break;
-  case USART_HAL_USART6:
-    usart6Handle.Instance = USART6;
-    usartHandle = &usart6Handle;
-    break;
-  default:
-    return;
+  if (instance == NULL) {
+    return; // USART not available on this board
   }
 
+  instance->txCallback    = txCb;
+  instance->rxCallback    = rxCb;
+  instance->txLength      = 0;
+  instance->isSendingData = FALSE;
+
+  UART_HandleTypeDef * usartHandle = &instance->handle;
+
+  usartHandle->Instance        = hardware[instance - usarts].instance;
   usartHandle->Init.BaudRate   = baud;
   usartHandle->Init.WordLength = UART_WORDLENGTH_8B;
   usartHandle->Init.StopBits   = UART_STOPBITS_1;
@@ -175,117 +223,382 @@ void Usart_initialize(UsartNumber usart, int baud, void(*rxCb)(char), int(*txCb)
     CommonHal_errorHandler();
   }
 
-  if(HAL_UART_Receive_IT(usartHandle, (uint8_t*)rxBuffer, RECEIVE_BUFFER_LENGTH) != HAL_OK) {
+  uint32_t interruptState = CommonHal_disableInterrupts();
+  startReception(instance);
+  CommonHal_restoreInterrupts(interruptState);
+}
+/**
+ * @brief Returns state of given USART.
+ * @param usart USART number
+ * @return Pointer to USART state or NULL if USART is not available on the board
+ */
+static UsartInstance* getInstance(UsartNumber usart) {
+  switch(usart) {
+#ifdef USART1_IRQ_NUMBER
+  case USART_HAL_USART1:
+    return &usarts[USART1_INDEX];
+#endif
+#ifdef USART2_IRQ_NUMBER
+  case USART_HAL_USART2:
+    return &usarts[USART2_INDEX];
+#endif
+#ifdef USART6_IRQ_NUMBER
+  case USART_HAL_USART6:
+    return &usarts[USART6_INDEX];
+#endif
+  default:
+    return NULL;
+  }
+}
+/**
+ * @brief Enables clocks of USART and its pins and DMA.
+ * @param usartHandle UART handle
+ */
+static void enableClocks(UART_HandleTypeDef * usartHandle) {
+#ifdef USART1_IRQ_NUMBER
+  if (usartHandle->Instance == USART1) {
+    USART1_TX_GPIO_CLK_ENABLE();
+    USART1_RX_GPIO_CLK_ENABLE();
+    USART1_CLK_ENABLE();
+    USART1_DMA_CLK_ENABLE();
+  }
+#endif
+#ifdef USART2_IRQ_NUMBER
+  if (usartHandle->Instance == USART2) {
+    USART2_TX_GPIO_CLK_ENABLE();
+    USART2_RX_GPIO_CLK_ENABLE();
+    USART2_CLK_ENABLE();
+    USART2_DMA_CLK_ENABLE();
+  }
+#endif
+#ifdef USART6_IRQ_NUMBER
+  if (usartHandle->Instance == USART6) {
+    USART6_TX_GPIO_CLK_ENABLE();
+    USART6_RX_GPIO_CLK_ENABLE();
+#ifdef USART6_CLOCK_SOURCE
+    RCC_PeriphCLKInitTypeDef RCC_PeriphClkInit;
+    RCC_PeriphClkInit.PeriphClockSelection = RCC_PERIPHCLK_USART6;
+    RCC_PeriphClkInit.Usart6ClockSelection = USART6_CLOCK_SOURCE;
+    HAL_RCCEx_PeriphCLKConfig(&RCC_PeriphClkInit);
+#endif
+    USART6_CLK_ENABLE();
+    USART6_DMA_CLK_ENABLE();
+  }
+#endif
+}
+/**
+ * @brief Resets USART peripheral.
+ * @param usartHandle UART handle
+ */
+static void resetUsart(UART_HandleTypeDef * usartHandle) {
+#ifdef USART1_IRQ_NUMBER
+  if (usartHandle->Instance == USART1) {
+    USART1_FORCE_RESET();
+    USART1_RELEASE_RESET();
+  }
+#endif
+#ifdef USART2_IRQ_NUMBER
+  if (usartHandle->Instance == USART2) {
+    USART2_FORCE_RESET();
+    USART2_RELEASE_RESET();
+  }
+#endif
+#ifdef USART6_IRQ_NUMBER
+  if (usartHandle->Instance == USART6) {
+    USART6_FORCE_RESET();
+    USART6_RELEASE_RESET();
+  }
+#endif
+}
+/**
+ * @brief Releases sent data and starts DMA transfer of the next block.
+ * @details If HAL is busy, the block isn't released and the flag is
+ * cleared, so the next write starts the transfer again.
+ * @param usart USART state
+ */
+static void sendData(UsartInstance * usart) {
+
+  // if no function set do nothing
+  if (usart->txCallback == NULL) {
+    return;
+  }
+
+  // release the sent data and get the next block
+  const char* data;
+  int numberOfBytes = usart->txCallback(usart->txLength, &data);
+  usart->txLength = 0;
+
+  if (numberOfBytes == 0) {
+    usart->isSendingData = FALSE;
+    MEMORY_BARRIER();
+    // upper layer may have added data after the check, but before it saw the cleared flag
+    numberOfBytes = usart->txCallback(0, &data);
+    if (numberOfBytes == 0) {
+      return;
+    }
+  }
+
+  // set before starting DMA, because transfer complete IRQ may come right away
+  usart->txLength = numberOfBytes;
+  usart->isSendingData = TRUE;
+
+  // send it to PC
+  HAL_StatusTypeDef status = HAL_UART_Transmit_DMA(&usart->handle,
+      (uint8_t*)data, numberOfBytes);
+  if (status == HAL_BUSY) {
+    usart->txLength = 0;
+    usart->isSendingData = FALSE;
+  } else if (status != HAL_OK) {
+    CommonHal_errorHandler();
+  }
+}
+/**
+ * @brief Starts circular DMA reception with idle line detection.
+ * @details HAL_BUSY means reception is already running, so it isn't an error.
+ * @param usart USART state
+ */
+static void startReception(UsartInstance * usart) {
+
+  HAL_StatusTypeDef status = HAL_UART_Receive_DMA(&usart->handle,
+      (uint8_t*)usart->rxDmaBuffer, USART_RX_DMA_BUFFER_LENGTH);
+  if (status == HAL_BUSY) {
+    return;
+  } else if (status != HAL_OK) {
     CommonHal_errorHandler();
   }
+  usart->rxReadPosition = 0;
+  __HAL_UART_CLEAR_IDLEFLAG(&usart->handle);
+  __HAL_UART_ENABLE_IT(&usart->handle, UART_IT_IDLE);
 }
-// ********************** HAL UART callbacks and IRQs **********************
 /**
-  * @brief  Transfer completed callback
-  * @param  uart UART handle
-  */
-void HAL_UART_RxCpltCallback(UART_HandleTypeDef * usartHandle) {
+ * @brief Passes data received by DMA since the last call to upper layer.
+ * @details The DMA write position is taken from the stream counter. If the data
+ * wraps around the end of the buffer it is passed as two spans.
+ * @param usart USART state
+ */
+static void processReceivedData(UsartInstance * usart) {
+
+  int readPosition = usart->rxReadPosition;
+  int writePosition = USART_RX_DMA_BUFFER_LENGTH -
+      (int)__HAL_DMA_GET_COUNTER(&usart->rxDmaHandle);
+
+  if (writePosition >= USART_RX_DMA_BUFFER_LENGTH) {
+    writePosition = 0;
+  }
 
-  if (rxCallback == NULL) {
+  if (writePosition == readPosition || usart->rxCallback == NULL) {
+    usart->rxReadPosition = writePosition;
     return;
   }
 
-  // send the received char to upper layer
-  rxCallback(*rxBuffer);
+  if (writePosition > readPosition) {
+    usart->rxCallback(usart->rxDmaBuffer + readPosition, writePosition - readPosition);
+  } else {
+    usart->rxCallback(usart->rxDmaBuffer + readPosition, USART_RX_DMA_BUFFER_LENGTH - readPosition);
+    if (writePosition > 0) {
+      usart->rxCallback(usart->rxDmaBuffer, writePosition);
+    }
+  }
+  usart->rxReadPosition = writePosition;
+}
+/**
+ * @brief Handles USART interrupt (idle line detection and HAL events).
+ * @param usart USART state
+ */
+static void handleUsartIrq(UsartInstance * usart) {
+  if (__HAL_UART_GET_FLAG(&usart->handle, UART_FLAG_IDLE) &&
+      __HAL_UART_GET_IT_SOURCE(&usart->handle, UART_IT_IDLE)) {
+    __HAL_UART_CLEAR_IDLEFLAG(&usart->handle);
+    processReceivedData(usart);
+  }
+  HAL_UART_IRQHandler(&usart->handle);
+}
+/**
+ * @brief Configures a DMA stream and links it to the UART handle.
+ * @details RX stream works in circular mode, TX stream in normal mode.
+ * @param usartHandle UART handle
+ * @param dmaHandle DMA handle
+ * @param stream DMA stream
+ * @param channel DMA channel
+ * @param direction DMA_PERIPH_TO_MEMORY for RX, DMA_MEMORY_TO_PERIPH for TX
+ */
+static void initializeDma(UART_HandleTypeDef * usartHandle, DMA_HandleTypeDef * dmaHandle,
+    DMA_Stream_TypeDef * stream, uint32_t channel, uint32_t direction) {
 
-  // start another reception
-  if (HAL_UART_Receive_IT(usartHandle, (uint8_t *)(rxBuffer), RECEIVE_BUFFER_LENGTH) != HAL_OK) {
+  dmaHandle->Instance                 = stream;
+  dmaHandle->Init.Channel             = channel;
+  dmaHandle->Init.Direction           = direction;
+  dmaHandle->Init.PeriphInc           = DMA_PINC_DISABLE;
+  dmaHandle->Init.MemInc              = DMA_MINC_ENABLE;
+  dmaHandle->Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+  dmaHandle->Init.MemDataAlignment    = DMA_MDATAALIGN_BYTE;
+  dmaHandle->Init.Mode                = (direction == DMA_PERIPH_TO_MEMORY) ? DMA_CIRCULAR : DMA_NORMAL;
+  dmaHandle->Init.Priority            = DMA_PRIORITY_HIGH;
+  dmaHandle->Init.FIFOMode            = DMA_FIFOMODE_DISABLE;
+
+  if (HAL_DMA_Init(dmaHandle) != HAL_OK) {
     CommonHal_errorHandler();
   }
+  if (direction == DMA_PERIPH_TO_MEMORY) {
+    __HAL_LINKDMA(usartHandle, hdmarx, *dmaHandle);
+  } else {
+    __HAL_LINKDMA(usartHandle, hdmatx, *dmaHandle);
+  }
 }
+// ********************** HAL UART callbacks and IRQs **********************
 /**
- * @brief Transfer completed callback (called whenever IRQ sends the whole buffer)
+ * @brief Receive half completed callback (DMA filled first half of the buffer)
  * @param uart UART handle
  */
-void HAL_UART_TxCpltCallback(UART_HandleTypeDef * usartHandle) {
-  if (usartHandle == &usart2Handle) {
-    Usart_sendDataIrq(USART_HAL_USART2);
+void HAL_UART_RxHalfCpltCallback(UART_HandleTypeDef * usartHandle) {
+  processReceivedData((UsartInstance*)usartHandle);
+}
+/**
+ * @brief Receive completed callback (DMA filled second half of the buffer)
+ * @param uart UART handle
+ */
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef * usartHandle) {
+  processReceivedData((UsartInstance*)usartHandle);
+}
+/**
+ * @brief UART error callback
+ * @details HAL aborts DMA reception on errors, so pass the data received
+ * so far and restart the circular reception. If the TX DMA failed, the
+ * block wasn't released, so it is sent again. The main loop starts
+ * transfers with interrupts disabled and all IRQs of a USART have the
+ * same priority, so the handle isn't locked here.
+ * @param uart UART handle
+ */
+void HAL_UART_ErrorCallback(UART_HandleTypeDef * usartHandle) {
+  UsartInstance* usart = (UsartInstance*)usartHandle;
+  if (usartHandle->RxState == HAL_UART_STATE_READY) {
+    processReceivedData(usart);
+    startReception(usart);
   }
-  if (usartHandle == &usart6Handle) {
-    Usart_sendDataIrq(USART_HAL_USART6);
+  if (usartHandle->gState == HAL_UART_STATE_READY && usart->isSendingData) {
+    usart->txLength = 0;
+    sendData(usart);
   }
 }
+/**
+ * @brief Transfer completed callback (called whenever DMA sends the whole block)
+ * @param uart UART handle
+ */
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef * usartHandle) {
+  sendData((UsartInstance*)usartHandle);
+}
 /**
  * @brief Initialize low level UART
  * @param uart UART handle pointer
  */
 void HAL_UART_MspInit(UART_HandleTypeDef * usartHandle) {
-  if (usartHandle == &usart2Handle) {
-    USART2_TX_GPIO_CLK_ENABLE();
-    USART2_RX_GPIO_CLK_ENABLE();
-    USART2_CLK_ENABLE();
-    GPIO_InitTypeDef  gpioInitalization;
-    gpioInitalization.Pin       = USART2_TX_PIN;
-    gpioInitalization.Mode      = GPIO_MODE_AF_PP;
-    gpioInitalization.Pull      = GPIO_PULLUP;
-    gpioInitalization.Speed     = GPIO_SPEED_FAST;
-    gpioInitalization.Alternate = USART2_TX_AF;
-    HAL_GPIO_Init(USART2_TX_GPIO_PORT, &gpioInitalization);
-    gpioInitalization.Pin       = USART2_RX_PIN;
-    gpioInitalization.Alternate = USART2_RX_AF;
-    HAL_GPIO_Init(USART2_RX_GPIO_PORT, &gpioInitalization);
-    HAL_NVIC_SetPriority(USART2_IRQ_NUMBER, USART2_IRQ_PRIORITY, 0);
-    HAL_NVIC_EnableIRQ(USART2_IRQ_NUMBER);
-  }
-  if (usartHandle == &usart6Handle) {
-    USART6_TX_GPIO_CLK_ENABLE();
-    USART6_RX_GPIO_CLK_ENABLE();
-    RCC_PeriphCLKInitTypeDef RCC_PeriphClkInit;
-    RCC_PeriphClkInit.PeriphClockSelection = RCC_PERIPHCLK_USART6;
-    RCC_PeriphClkInit.Usart6ClockSelection = RCC_USART6CLKSOURCE_SYSCLK;
-    HAL_RCCEx_PeriphCLKConfig(&RCC_PeriphClkInit);
-    USART6_CLK_ENABLE();
-    GPIO_InitTypeDef  gpioInitalization;
-    gpioInitalization.Pin       = USART6_TX_PIN;
-    gpioInitalization.Mode      = GPIO_MODE_AF_PP;
-    gpioInitalization.Pull      = GPIO_PULLUP;
-    gpioInitalization.Speed     = GPIO_SPEED_FAST;
-    gpioInitalization.Alternate = USART6_TX_AF;
-    HAL_GPIO_Init(USART6_TX_GPIO_PORT, &gpioInitalization);
-    gpioInitalization.Pin       = USART6_RX_PIN;
-    gpioInitalization.Alternate = USART6_RX_AF;
-    HAL_GPIO_Init(USART6_RX_GPIO_PORT, &gpioInitalization);
-    HAL_NVIC_SetPriority(USART6_IRQ_NUMBER, USART6_IRQ_PRIORITY, 0);
-    HAL_NVIC_EnableIRQ(USART6_IRQ_NUMBER);
-  }
+
+  UsartInstance* usart = (UsartInstance*)usartHandle;
+  const UsartHardware* hw = &hardware[usart - usarts];
+
+  enableClocks(usartHandle);
+
+  GPIO_InitTypeDef  gpioInitalization;
+  gpioInitalization.Pin       = hw->txPin;
+  gpioInitalization.Mode      = GPIO_MODE_AF_PP;
+  gpioInitalization.Pull      = GPIO_PULLUP;
+  gpioInitalization.Speed     = GPIO_SPEED_FAST;
+  gpioInitalization.Alternate = hw->txAlternate;
+  HAL_GPIO_Init(hw->txPort, &gpioInitalization);
+  gpioInitalization.Pin       = hw->rxPin;
+  gpioInitalization.Alternate = hw->rxAlternate;
+  HAL_GPIO_Init(hw->rxPort, &gpioInitalization);
+
+  initializeDma(usartHandle, &usart->rxDmaHandle, hw->rxDmaStream,
+      hw->rxDmaChannel, DMA_PERIPH_TO_MEMORY);
+  initializeDma(usartHandle, &usart->txDmaHandle, hw->txDmaStream,
+      hw->txDmaChannel, DMA_MEMORY_TO_PERIPH);
+
+  HAL_NVIC_SetPriority(hw->rxDmaIrq, hw->irqPriority, 0);
+  HAL_NVIC_EnableIRQ(hw->rxDmaIrq);
+  HAL_NVIC_SetPriority(hw->txDmaIrq, hw->irqPriority, 0);
+  HAL_NVIC_EnableIRQ(hw->txDmaIrq);
+  HAL_NVIC_SetPriority(hw->irq, hw->irqPriority, 0);
+  HAL_NVIC_EnableIRQ(hw->irq);
 }
 /**
   * @brief Deinitialize low level UART
   * @param uart UART handle pointer
   */
 void HAL_UART_MspDeInit(UART_HandleTypeDef * usartHandle) {
-  if (usartHandle == &usart2Handle) {
-    USART2_FORCE_RESET();
-    USART2_RELEASE_RESET();
-    HAL_GPIO_DeInit(USART2_TX_GPIO_PORT, USART2_TX_PIN);
-    HAL_GPIO_DeInit(USART2_RX_GPIO_PORT, USART2_RX_PIN);
-    HAL_NVIC_DisableIRQ(USART2_IRQ_NUMBER);
-  }
-  if (usartHandle == &usart6Handle) {
-    USART6_FORCE_RESET();
-    USART6_RELEASE_RESET();
-    HAL_GPIO_DeInit(USART6_TX_GPIO_PORT, USART6_TX_PIN);
-    HAL_GPIO_DeInit(USART6_RX_GPIO_PORT, USART6_RX_PIN);
-    HAL_NVIC_DisableIRQ(USART6_IRQ_NUMBER);
-  }
+
+  UsartInstance* usart = (UsartInstance*)usartHandle;
+  const UsartHardware* hw = &hardware[usart - usarts];
+
+  resetUsart(usartHandle);
+  HAL_GPIO_DeInit(hw->txPort, hw->txPin);
+  HAL_GPIO_DeInit(hw->rxPort, hw->rxPin);
+  HAL_DMA_DeInit(&usart->rxDmaHandle);
+  HAL_DMA_DeInit(&usart->txDmaHandle);
+  HAL_NVIC_DisableIRQ(hw->rxDmaIrq);
+  HAL_NVIC_DisableIRQ(hw->txDmaIrq);
+  HAL_NVIC_DisableIRQ(hw->irq);
 }
+#ifdef USART1_IRQ_NUMBER
+/**
+ * @brief  This function handles UART interrupt request.
+ */
+void USART1_IRQHandler(void) {
+  handleUsartIrq(&usarts[USART1_INDEX]);
+}
+/**
+ * @brief  This function handles UART RX DMA interrupt request.
+ */
+void USART1_RX_DMA_IRQ_HANDLER(void) {
+  HAL_DMA_IRQHandler(&usarts[USART1_INDEX].rxDmaHandle);
+}
+/**
+ * @brief  This function handles UART TX DMA interrupt request.
+ */
+void USART1_TX_DMA_IRQ_HANDLER(void) {
+  HAL_DMA_IRQHandler(&usarts[USART1_INDEX].txDmaHandle);
+}
+#endif
+#ifdef USART2_IRQ_NUMBER
 /**
  * @brief  This function handles UART interrupt request.
  */
 void USART2_IRQHandler(void) {
-  HAL_UART_IRQHandler(&usart2Handle);
+  handleUsartIrq(&usarts[USART2_INDEX]);
+}
+/**
+ * @brief  This function handles UART RX DMA interrupt request.
+ */
+void USART2_RX_DMA_IRQ_HANDLER(void) {
+  HAL_DMA_IRQHandler(&usarts[USART2_INDEX].rxDmaHandle);
 }
+/**
+ * @brief  This function handles UART TX DMA interrupt request.
+ */
+void USART2_TX_DMA_IRQ_HANDLER(void) {
+  HAL_DMA_IRQHandler(&usarts[USART2_INDEX].txDmaHandle);
+}
+#endif
+#ifdef USART6_IRQ_NUMBER
 /**
  * @brief  This function handles UART interrupt request.
  */
 void USART6_IRQHandler(void) {
-  HAL_UART_IRQHandler(&usart6Handle);
+  handleUsartIrq(&usarts[USART6_INDEX]);
 }
+/**
+ * @brief  This function handles UART RX DMA interrupt request.
+ */
+void USART6_RX_DMA_IRQ_HANDLER(void) {
+  HAL_DMA_IRQHandler(&usarts[USART6_INDEX].rxDmaHandle);
+}
+/**
+ * @brief  This function handles UART TX DMA interrupt request.
+ */
+void USART6_TX_DMA_IRQ_HANDLER(void) {
+  HAL_DMA_IRQHandler(&usarts[USART6_INDEX].txDmaHandle);
+}
+#endif
 /**
  * @}
  */
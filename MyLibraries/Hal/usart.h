@@ -39,9 +39,8 @@ typedef enum {
   USART_HAL_USART6,
 } UsartNumber;
 
-#define UART_BUF_LEN_TX 512 ///< Buffer length for UART peripheral
-
-void    Usart_initialize   (UsartNumber usart, int baud, void(*rxCb)(char), int(*txCb)(char*));
+void    Usart_initialize   (UsartNumber usart, int baud, void(*rxCb)(const char*, int),
+    int(*txCb)(int, const char**));
 Boolean Usart_isSendingData(UsartNumber usart);
 void    Usart_sendDataIrq  (UsartNumber usart);
 void    Usart_enableIrq    (UsartNumber usart);
@@ -21,5 +21,37 @@
 #define USART2_RX_AF                     GPIO_AF7_USART2
 #define USART2_IRQ_NUMBER                USART2_IRQn
 #define USART2_IRQ_PRIORITY              15
+#define USART2_DMA_CLK_ENABLE()          __HAL_RCC_DMA1_CLK_ENABLE()
+#define USART2_RX_DMA_STREAM             DMA1_Stream5
+#define USART2_RX_DMA_CHANNEL            DMA_CHANNEL_4
+#define USART2_RX_DMA_IRQ_NUMBER         DMA1_Stream5_IRQn
+#define USART2_RX_DMA_IRQ_HANDLER        DMA1_Stream5_IRQHandler
+#define USART2_TX_DMA_STREAM             DMA1_Stream6
+#define USART2_TX_DMA_CHANNEL            DMA_CHANNEL_4
+#define USART2_TX_DMA_IRQ_NUMBER         DMA1_Stream6_IRQn
+#define USART2_TX_DMA_IRQ_HANDLER        DMA1_Stream6_IRQHandler
+
+#define USART6_CLK_ENABLE()              __HAL_RCC_USART6_CLK_ENABLE()
+#define USART6_RX_GPIO_CLK_ENABLE()      __HAL_RCC_GPIOC_CLK_ENABLE()
+#define USART6_TX_GPIO_CLK_ENABLE()      __HAL_RCC_GPIOC_CLK_ENABLE()
+#define USART6_FORCE_RESET()             __HAL_RCC_USART6_FORCE_RESET()
+#define USART6_RELEASE_RESET()           __HAL_RCC_USART6_RELEASE_RESET()
+#define USART6_TX_PIN                    GPIO_PIN_6
+#define USART6_TX_GPIO_PORT              GPIOC
+#define USART6_TX_AF                     GPIO_AF8_USART6
+#define USART6_RX_PIN                    GPIO_PIN_7
+#define USART6_RX_GPIO_PORT              GPIOC
+#define USART6_RX_AF                     GPIO_AF8_USART6
+#define USART6_IRQ_NUMBER                USART6_IRQn
+#define USART6_IRQ_PRIORITY              15
+#define USART6_DMA_CLK_ENABLE()          __HAL_RCC_DMA2_CLK_ENABLE()
+#define USART6_RX_DMA_STREAM             DMA2_Stream1
+#define USART6_RX_DMA_CHANNEL            DMA_CHANNEL_5
+#define USART6_RX_DMA_IRQ_NUMBER         DMA2_Stream1_IRQn
+#define USART6_RX_DMA_IRQ_HANDLER        DMA2_Stream1_IRQHandler
+#define USART6_TX_DMA_STREAM             DMA2_Stream6
+#define USART6_TX_DMA_CHANNEL            DMA_CHANNEL_5
+#define USART6_TX_DMA_IRQ_NUMBER         DMA2_Stream6_IRQn
+#define USART6_TX_DMA_IRQ_HANDLER        DMA2_Stream6_IRQHandler
 
 #endif /* MYLIBRARIES_HAL_USART_F4_DISCOVERY_DEFS_H_ */
@@ -21,5 +21,38 @@
 #define USART6_RX_AF                     GPIO_AF8_USART6
 #define USART6_IRQ_NUMBER                USART6_IRQn
 #define USART6_IRQ_PRIORITY              15
+#define USART6_DMA_CLK_ENABLE()          __HAL_RCC_DMA2_CLK_ENABLE()
+#define USART6_RX_DMA_STREAM             DMA2_Stream1
+#define USART6_RX_DMA_CHANNEL            DMA_CHANNEL_5
+#define USART6_RX_DMA_IRQ_NUMBER         DMA2_Stream1_IRQn
+#define USART6_RX_DMA_IRQ_HANDLER        DMA2_Stream1_IRQHandler
+#define USART6_TX_DMA_STREAM             DMA2_Stream6
+#define USART6_TX_DMA_CHANNEL            DMA_CHANNEL_5
+#define USART6_TX_DMA_IRQ_NUMBER         DMA2_Stream6_IRQn
+#define USART6_TX_DMA_IRQ_HANDLER        DMA2_Stream6_IRQHandler
+#define USART6_CLOCK_SOURCE              RCC_USART6CLKSOURCE_SYSCLK
+
+#define USART1_CLK_ENABLE()              __HAL_RCC_USART1_CLK_ENABLE()
+#define USART1_RX_GPIO_CLK_ENABLE()      __HAL_RCC_GPIOB_CLK_ENABLE()
+#define USART1_TX_GPIO_CLK_ENABLE()      __HAL_RCC_GPIOA_CLK_ENABLE()
+#define USART1_FORCE_RESET()             __HAL_RCC_USART1_FORCE_RESET()
+#define USART1_RELEASE_RESET()           __HAL_RCC_USART1_RELEASE_RESET()
+#define USART1_TX_PIN                    GPIO_PIN_9
+#define USART1_TX_GPIO_PORT              GPIOA
+#define USART1_TX_AF                     GPIO_AF7_USART1
+#define USART1_RX_PIN                    GPIO_PIN_7
+#define USART1_RX_GPIO_PORT              GPIOB
+#define USART1_RX_AF                     GPIO_AF7_USART1
+#define USART1_IRQ_NUMBER                USART1_IRQn
+#define USART1_IRQ_PRIORITY              15
+#define USART1_DMA_CLK_ENABLE()          __HAL_RCC_DMA2_CLK_ENABLE()
+#define USART1_RX_DMA_STREAM             DMA2_Stream2
+#define USART1_RX_DMA_CHANNEL            DMA_CHANNEL_4
+#define USART1_RX_DMA_IRQ_NUMBER         DMA2_Stream2_IRQn
+#define USART1_RX_DMA_IRQ_HANDLER        DMA2_Stream2_IRQHandler
+#define USART1_TX_DMA_STREAM             DMA2_Stream7
+#define USART1_TX_DMA_CHANNEL            DMA_CHANNEL_4
+#define USART1_TX_DMA_IRQ_NUMBER         DMA2_Stream7_IRQn
+#define USART1_TX_DMA_IRQ_HANDLER        DMA2_Stream7_IRQHandler
 
 #endif /* MYLIBRARIES_HAL_USART_F7_DISCOVERY_DEFS_H_ */
@@ -0,0 +1,288 @@
+/**
+ * @file    usb_cdc.c
+ * @brief   USB virtual COM port (CDC ACM) low level functions.
+ * @date    18.10.2026
+ * @author  Michal Ksiezopolski
+ *
+ * @verbatim
+ * Copyright (c) 2026 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifdef USE_USB_CDC
+
+#include "usb_cdc.h"
+#include "common_hal.h"
+#include "usbd_core.h"
+#include "usbd_cdc.h"
+#include "usbd_desc.h"
+
+/**
+ * @addtogroup USB_CDC
+ * @{
+ */
+
+#define PACKET_LENGTH           CDC_DATA_FS_MAX_PACKET_SIZE ///< Length of full speed bulk packet
+#define RX_BUFFER_COUNT         2                           ///< Number of receive buffers
+#define CONTROL_LINE_STATE_DTR  0x01                        ///< Host has opened the port
+
+static USBD_HandleTypeDef usbDevice;  ///< USB device handle
+static USBD_ClassTypeDef  cdcClass;   ///< CDC class with transfer complete notification
+static uint8_t rxBuffers[RX_BUFFER_COUNT][PACKET_LENGTH] __attribute__((aligned(4))); ///< Buffers for received packets
+static int rxBufferIndex;             ///< Buffer of the next received packet
+static USBD_CDC_LineCodingTypeDef lineCoding = {115200, 0, 0, 8}; ///< Line coding set by host (not used by device)
+static volatile Boolean isPortOpen;   ///< Host has set DTR
+static void (*rxCallback)(const char*, int); ///< Callback function for receiving data
+static int  (*txCallback)(int, const char**);///< Callback function for transmitting data
+static int  txLength;                 ///< Length of the block currently sent
+static volatile Boolean isSendingData;///< Flag saying if transfer is in progress
+
+static void sendData(void);
+static void startTransfer(const char* data, int length);
+static uint8_t classInit(USBD_HandleTypeDef* pdev, uint8_t cfgidx);
+static uint8_t classDeInit(USBD_HandleTypeDef* pdev, uint8_t cfgidx);
+static uint8_t classDataIn(USBD_HandleTypeDef* pdev, uint8_t epnum);
+static int8_t interfaceInit(void);
+static int8_t interfaceDeInit(void);
+static int8_t interfaceControl(uint8_t command, uint8_t* buffer, uint16_t length);
+static int8_t interfaceReceive(uint8_t* buffer, uint32_t* length);
+
+/**
+ * @brief Callbacks of CDC class
+ */
+static USBD_CDC_ItfTypeDef cdcInterface = {
+  interfaceInit,
+  interfaceDeInit,
+  interfaceControl,
+  interfaceReceive,
+};
+
+/**
+ * @brief Initializes USB CDC device and connects it to the bus.
+ * @param rxCb Callback for received data
+ * @param txCb Callback releasing sent data and returning the next block to send
+ */
+void UsbCdc_initialize(void(*rxCb)(const char*, int), int(*txCb)(int, const char**)) {
+
+  rxCallback = rxCb;
+  txCallback = txCb;
+
+  // standard CDC class, but with notifications about configuration and sent data
+  cdcClass = USBD_CDC;
+  cdcClass.Init   = classInit;
+  cdcClass.DeInit = classDeInit;
+  cdcClass.DataIn = classDataIn;
+
+  USBD_Init(&usbDevice, &UsbDescriptors_virtualComPort, 0);
+  USBD_RegisterClass(&usbDevice, &cdcClass);
+  USBD_CDC_RegisterInterface(&usbDevice, &cdcInterface);
+  USBD_Start(&usbDevice);
+}
+/**
+ * @brief Checks if transfer is in progress.
+ * @retval TRUE Transfer in progress
+ * @retval FALSE Not sending
+ */
+Boolean UsbCdc_isSendingData(void) {
+  return isSendingData;
+}
+/**
+ * @brief Starts sending data from upper layer.
+ * @details USB IRQ is disabled, because data may be sent from the IRQ when
+ * the host configures the device.
+ */
+void UsbCdc_sendDataIrq(void) {
+  HAL_NVIC_DisableIRQ(OTG_FS_IRQn);
+  if (!isSendingData) {
+    sendData();
+  }
+  HAL_NVIC_EnableIRQ(OTG_FS_IRQn);
+}
+/**
+ * @brief Checks if host has opened the port (set DTR).
+ * @retval TRUE Port open
+ * @retval FALSE Port closed or device not configured
+ */
+Boolean UsbCdc_isConnected(void) {
+  return isPortOpen;
+}
+/**
+ * @brief Releases sent data and starts the next transfer.
+ * @details A transfer which is a multiple of the packet length is followed by
+ * a zero length packet when there's no more data, so that the host passes
+ * the data to the application. If the device isn't configured (class data
+ * isn't allocated), the upper layer buffer isn't touched and the data is
+ * sent by classInit after configuration.
+ */
+static void sendData(void) {
+
+  if (txCallback == NULL || usbDevice.pClassData == NULL) {
+    return;
+  }
+
+  const char* data;
+  int transmittedLength = txLength;
+  int numberOfBytes = txCallback(transmittedLength, &data);
+  txLength = 0;
+
+  if (numberOfBytes == 0) {
+    if (transmittedLength > 0 && transmittedLength % PACKET_LENGTH == 0) {
+      startTransfer(data, 0);
+      return;
+    }
+    isSendingData = FALSE;
+    MEMORY_BARRIER();
+    // upper layer may have added data after the check, but before it saw the cleared flag
+    numberOfBytes = txCallback(0, &data);
+    if (numberOfBytes == 0) {
+      return;
+    }
+  }
+
+  startTransfer(data, numberOfBytes);
+}
+/**
+ * @brief Starts IN transfer.
+ * @details Called only when the device is configured.
+ * @param data Data to send
+ * @param length Length of data
+ */
+static void startTransfer(const char* data, int length) {
+  // set before starting transfer, because transfer complete IRQ may come right away
+  txLength = length;
+  isSendingData = TRUE;
+
+  USBD_CDC_SetTxBuffer(&usbDevice, (uint8_t*)data, length);
+  if (USBD_CDC_TransmitPacket(&usbDevice) != USBD_OK) {
+    txLength = 0;
+    isSendingData = FALSE;
+  }
+}
+/**
+ * @brief Configures CDC class and sends data waiting for configuration.
+ * @param pdev Device handle
+ * @param cfgidx Configuration index
+ * @return Result of standard CDC class initialization
+ */
+static uint8_t classInit(USBD_HandleTypeDef* pdev, uint8_t cfgidx) {
+  uint8_t result = USBD_CDC.Init(pdev, cfgidx);
+  if (result == USBD_OK && !isSendingData) {
+    sendData();
+  }
+  return result;
+}
+/**
+ * @brief Deconfigures CDC class.
+ * @details Data of an unfinished transfer is not released, so it is sent
+ * again after configuration.
+ * @param pdev Device handle
+ * @param cfgidx Configuration index
+ * @return Result of standard CDC class deinitialization
+ */
+static uint8_t classDeInit(USBD_HandleTypeDef* pdev, uint8_t cfgidx) {
+  txLength = 0;
+  isSendingData = FALSE;
+  isPortOpen = FALSE;
+  return USBD_CDC.DeInit(pdev, cfgidx);
+}
+/**
+ * @brief Handles end of IN transfer.
+ * @param pdev Device handle
+ * @param epnum Endpoint number
+ * @return Result of standard CDC class handler
+ */
+static uint8_t classDataIn(USBD_HandleTypeDef* pdev, uint8_t epnum) {
+  uint8_t result = USBD_CDC.DataIn(pdev, epnum);
+  if (epnum == (CDC_IN_EP & 0x7f)) {
+    sendData();
+  }
+  return result;
+}
+/**
+ * @brief Prepares receive buffer after configuration.
+ * @return USBD_OK
+ */
+static int8_t interfaceInit(void) {
+  rxBufferIndex = 0;
+  USBD_CDC_SetRxBuffer(&usbDevice, rxBuffers[rxBufferIndex]);
+  return USBD_OK;
+}
+/**
+ * @brief Called on deconfiguration.
+ * @return USBD_OK
+ */
+static int8_t interfaceDeInit(void) {
+  return USBD_OK;
+}
+/**
+ * @brief Handles CDC class requests.
+ * @details Line coding is stored only for the host to read back, since the
+ * data doesn't go through a real UART.
+ * @param command Request
+ * @param buffer Request data
+ * @param length Length of data
+ * @return USBD_OK
+ */
+static int8_t interfaceControl(uint8_t command, uint8_t* buffer, uint16_t length) {
+
+  switch (command) {
+  case CDC_SET_LINE_CODING:
+    lineCoding.bitrate    = buffer[0] | (buffer[1] << 8) | (buffer[2] << 16) | ((uint32_t)buffer[3] << 24);
+    lineCoding.format     = buffer[4];
+    lineCoding.paritytype = buffer[5];
+    lineCoding.datatype   = buffer[6];
+    break;
+
+  case CDC_GET_LINE_CODING:
+    buffer[0] = (uint8_t)(lineCoding.bitrate);
+    buffer[1] = (uint8_t)(lineCoding.bitrate >> 8);
+    buffer[2] = (uint8_t)(lineCoding.bitrate >> 16);
+    buffer[3] = (uint8_t)(lineCoding.bitrate >> 24);
+    buffer[4] = lineCoding.format;
+    buffer[5] = lineCoding.paritytype;
+    buffer[6] = lineCoding.datatype;
+    break;
+
+  case CDC_SET_CONTROL_LINE_STATE: {
+    // control line state is in wValue of the setup packet
+    USBD_SetupReqTypedef* request = (USBD_SetupReqTypedef*)buffer;
+    isPortOpen = (request->wValue & CONTROL_LINE_STATE_DTR) ? TRUE : FALSE;
+    break;
+  }
+
+  default:
+    break;
+  }
+
+  return USBD_OK;
+}
+/**
+ * @brief Passes received packet to upper layer.
+ * @details Next packet is received to the other buffer.
+ * @param buffer Received data
+ * @param length Number of received bytes
+ * @return USBD_OK
+ */
+static int8_t interfaceReceive(uint8_t* buffer, uint32_t* length) {
+
+  rxBufferIndex = (rxBufferIndex + 1) % RX_BUFFER_COUNT;
+  USBD_CDC_SetRxBuffer(&usbDevice, rxBuffers[rxBufferIndex]);
+  USBD_CDC_ReceivePacket(&usbDevice);
+
+  if (rxCallback != NULL && *length > 0) {
+    rxCallback((const char*)buffer, (int)*length);
+  }
+  return USBD_OK;
+}
+
+/**
+ * @}
+ */
+
+#endif /* USE_USB_CDC */
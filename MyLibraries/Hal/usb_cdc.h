@@ -0,0 +1,49 @@
+/**
+ * @file    usb_cdc.h
+ * @brief   USB virtual COM port (CDC ACM) low level functions.
+ * @date    18.10.2026
+ * @author  Michal Ksiezopolski
+ *
+ * @verbatim
+ * Copyright (c) 2026 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef USB_CDC_H_
+#define USB_CDC_H_
+
+#include "utils.h"
+
+/**
+ * @defgroup  USB_CDC USB_CDC
+ * @brief     USB virtual COM port low level functions
+ *
+ * @details Full speed CDC device on the OTG FS core, with the same callback
+ * interface as the UART driver. Data is sent directly from the upper layer
+ * buffer in transfers of many 64 byte packets, and received packets are
+ * alternately written to two buffers, so the next packet is accepted while
+ * the previous one is passed to the upper layer. Compiled only with
+ * USE_USB_CDC defined (needs the STM32 USB device library).
+ */
+
+/**
+ * @addtogroup USB_CDC
+ * @{
+ */
+
+void    UsbCdc_initialize   (void(*rxCb)(const char*, int), int(*txCb)(int, const char**));
+Boolean UsbCdc_isSendingData(void);
+void    UsbCdc_sendDataIrq  (void);
+Boolean UsbCdc_isConnected  (void);
+
+/**
+ * @}
+ */
+
+#endif /* USB_CDC_H_ */
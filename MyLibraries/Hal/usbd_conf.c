@@ -0,0 +1,371 @@
+/**
+ * @file    usbd_conf.c
+ * @brief   USB device library low level driver (OTG FS core).
+ * @date    18.10.2026
+ * @author  Michal Ksiezopolski
+ *
+ * @verbatim
+ * Copyright (c) 2026 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifdef USE_USB_CDC
+
+#include "usbd_conf.h"
+#include "usbd_core.h"
+#include "usbd_cdc.h"
+#include "common_hal.h"
+#include "utils.h"
+
+/**
+ * @addtogroup USB_CDC
+ * @{
+ */
+
+#define USB_DM_PIN          GPIO_PIN_11   ///< D- pin (PA11)
+#define USB_DP_PIN          GPIO_PIN_12   ///< D+ pin (PA12)
+#define USB_GPIO_PORT       GPIOA         ///< Port of USB pins
+#define USB_IRQ_PRIORITY    6             ///< Priority of USB IRQ
+
+// FIFO sizes in words (OTG FS has 320 words of FIFO RAM)
+#define USB_RX_FIFO_SIZE    0x80          ///< Shared RX FIFO
+#define USB_EP0_FIFO_SIZE   0x40          ///< Control endpoint TX FIFO
+#define USB_DATA_FIFO_SIZE  0x60          ///< Data IN endpoint TX FIFO (6 packets)
+#define USB_CMD_FIFO_SIZE   0x20          ///< Command IN endpoint TX FIFO
+
+static PCD_HandleTypeDef pcdHandle; ///< Handle for OTG FS core
+static uint32_t classData[(sizeof(USBD_CDC_HandleTypeDef) + 3) / 4]; ///< Memory for CDC class data
+static Boolean isClassDataAllocated; ///< Class data is in use
+
+/**
+ * @brief Allocates memory for class data.
+ * @param size Size of memory
+ * @return Allocated memory or NULL if not available
+ */
+void* USBD_static_malloc(uint32_t size) {
+  if (isClassDataAllocated || size > sizeof(classData)) {
+    return NULL;
+  }
+  isClassDataAllocated = TRUE;
+  return classData;
+}
+/**
+ * @brief Releases memory allocated by USBD_static_malloc.
+ * @param pointer Allocated memory
+ */
+void USBD_static_free(void* pointer) {
+  if (pointer == classData) {
+    isClassDataAllocated = FALSE;
+  }
+}
+/**
+ * @brief Initializes OTG FS core in device mode.
+ * @param pdev Device handle
+ * @retval USBD_OK Initialized
+ */
+USBD_StatusTypeDef USBD_LL_Init(USBD_HandleTypeDef* pdev) {
+
+  pcdHandle.Instance                 = USB_OTG_FS;
+  pcdHandle.Init.dev_endpoints       = 4;
+  pcdHandle.Init.use_dedicated_ep1   = DISABLE;
+  pcdHandle.Init.ep0_mps             = USB_MAX_EP0_SIZE;
+  pcdHandle.Init.dma_enable          = DISABLE;
+  pcdHandle.Init.low_power_enable    = DISABLE;
+  pcdHandle.Init.lpm_enable          = DISABLE;
+  pcdHandle.Init.phy_itface          = PCD_PHY_EMBEDDED;
+  pcdHandle.Init.Sof_enable          = DISABLE;
+  pcdHandle.Init.speed               = PCD_SPEED_FULL;
+  pcdHandle.Init.vbus_sensing_enable = DISABLE; // board is powered from USB
+  pcdHandle.pData = pdev;
+  pdev->pData = &pcdHandle;
+
+  if (HAL_PCD_Init(&pcdHandle) != HAL_OK) {
+    CommonHal_errorHandler();
+  }
+
+  HAL_PCDEx_SetRxFiFo(&pcdHandle, USB_RX_FIFO_SIZE);
+  HAL_PCDEx_SetTxFiFo(&pcdHandle, 0, USB_EP0_FIFO_SIZE);
+  HAL_PCDEx_SetTxFiFo(&pcdHandle, CDC_IN_EP & 0x7f, USB_DATA_FIFO_SIZE);
+  HAL_PCDEx_SetTxFiFo(&pcdHandle, CDC_CMD_EP & 0x7f, USB_CMD_FIFO_SIZE);
+
+  return USBD_OK;
+}
+/**
+ * @brief Deinitializes OTG FS core.
+ * @param pdev Device handle
+ * @retval USBD_OK Deinitialized
+ */
+USBD_StatusTypeDef USBD_LL_DeInit(USBD_HandleTypeDef* pdev) {
+  HAL_PCD_DeInit(pdev->pData);
+  return USBD_OK;
+}
+/**
+ * @brief Connects device to the bus.
+ * @param pdev Device handle
+ * @retval USBD_OK Started
+ */
+USBD_StatusTypeDef USBD_LL_Start(USBD_HandleTypeDef* pdev) {
+  HAL_PCD_Start(pdev->pData);
+  return USBD_OK;
+}
+/**
+ * @brief Disconnects device from the bus.
+ * @param pdev Device handle
+ * @retval USBD_OK Stopped
+ */
+USBD_StatusTypeDef USBD_LL_Stop(USBD_HandleTypeDef* pdev) {
+  HAL_PCD_Stop(pdev->pData);
+  return USBD_OK;
+}
+/**
+ * @brief Opens endpoint.
+ * @param pdev Device handle
+ * @param ep_addr Endpoint address
+ * @param ep_type Endpoint type
+ * @param ep_mps Maximum packet size
+ * @retval USBD_OK Opened
+ */
+USBD_StatusTypeDef USBD_LL_OpenEP(USBD_HandleTypeDef* pdev, uint8_t ep_addr,
+    uint8_t ep_type, uint16_t ep_mps) {
+  HAL_PCD_EP_Open(pdev->pData, ep_addr, ep_mps, ep_type);
+  return USBD_OK;
+}
+/**
+ * @brief Closes endpoint.
+ * @param pdev Device handle
+ * @param ep_addr Endpoint address
+ * @retval USBD_OK Closed
+ */
+USBD_StatusTypeDef USBD_LL_CloseEP(USBD_HandleTypeDef* pdev, uint8_t ep_addr) {
+  HAL_PCD_EP_Close(pdev->pData, ep_addr);
+  return USBD_OK;
+}
+/**
+ * @brief Flushes endpoint.
+ * @param pdev Device handle
+ * @param ep_addr Endpoint address
+ * @retval USBD_OK Flushed
+ */
+USBD_StatusTypeDef USBD_LL_FlushEP(USBD_HandleTypeDef* pdev, uint8_t ep_addr) {
+  HAL_PCD_EP_Flush(pdev->pData, ep_addr);
+  return USBD_OK;
+}
+/**
+ * @brief Stalls endpoint.
+ * @param pdev Device handle
+ * @param ep_addr Endpoint address
+ * @retval USBD_OK Stalled
+ */
+USBD_StatusTypeDef USBD_LL_StallEP(USBD_HandleTypeDef* pdev, uint8_t ep_addr) {
+  HAL_PCD_EP_SetStall(pdev->pData, ep_addr);
+  return USBD_OK;
+}
+/**
+ * @brief Clears stall condition of endpoint.
+ * @param pdev Device handle
+ * @param ep_addr Endpoint address
+ * @retval USBD_OK Cleared
+ */
+USBD_StatusTypeDef USBD_LL_ClearStallEP(USBD_HandleTypeDef* pdev, uint8_t ep_addr) {
+  HAL_PCD_EP_ClrStall(pdev->pData, ep_addr);
+  return USBD_OK;
+}
+/**
+ * @brief Returns stall condition of endpoint.
+ * @param pdev Device handle
+ * @param ep_addr Endpoint address
+ * @return 1 if endpoint is stalled, 0 otherwise
+ */
+uint8_t USBD_LL_IsStallEP(USBD_HandleTypeDef* pdev, uint8_t ep_addr) {
+  PCD_HandleTypeDef* hpcd = pdev->pData;
+
+  if (ep_addr & 0x80) {
+    return hpcd->IN_ep[ep_addr & 0x7f].is_stall;
+  }
+  return hpcd->OUT_ep[ep_addr & 0x7f].is_stall;
+}
+/**
+ * @brief Sets device address.
+ * @param pdev Device handle
+ * @param dev_addr Address assigned by host
+ * @retval USBD_OK Address set
+ */
+USBD_StatusTypeDef USBD_LL_SetUSBAddress(USBD_HandleTypeDef* pdev, uint8_t dev_addr) {
+  HAL_PCD_SetAddress(pdev->pData, dev_addr);
+  return USBD_OK;
+}
+/**
+ * @brief Starts IN transfer.
+ * @details The core splits the transfer into packets.
+ * @param pdev Device handle
+ * @param ep_addr Endpoint address
+ * @param pbuf Data to send
+ * @param size Length of data
+ * @retval USBD_OK Transfer started
+ */
+USBD_StatusTypeDef USBD_LL_Transmit(USBD_HandleTypeDef* pdev, uint8_t ep_addr,
+    uint8_t* pbuf, uint16_t size) {
+  HAL_PCD_EP_Transmit(pdev->pData, ep_addr, pbuf, size);
+  return USBD_OK;
+}
+/**
+ * @brief Prepares endpoint for OUT transfer.
+ * @param pdev Device handle
+ * @param ep_addr Endpoint address
+ * @param pbuf Buffer for received data
+ * @param size Length of buffer
+ * @retval USBD_OK Endpoint prepared
+ */
+USBD_StatusTypeDef USBD_LL_PrepareReceive(USBD_HandleTypeDef* pdev, uint8_t ep_addr,
+    uint8_t* pbuf, uint16_t size) {
+  HAL_PCD_EP_Receive(pdev->pData, ep_addr, pbuf, size);
+  return USBD_OK;
+}
+/**
+ * @brief Returns length of last OUT transfer.
+ * @param pdev Device handle
+ * @param ep_addr Endpoint address
+ * @return Number of received bytes
+ */
+uint32_t USBD_LL_GetRxDataSize(USBD_HandleTypeDef* pdev, uint8_t ep_addr) {
+  return HAL_PCD_EP_GetRxCount(pdev->pData, ep_addr);
+}
+/**
+ * @brief Delay used by USB library.
+ * @param Delay Delay in milliseconds
+ */
+void USBD_LL_Delay(uint32_t Delay) {
+  HAL_Delay(Delay);
+}
+/**
+ * @brief Configures USB pins, clock and IRQ.
+ * @param hpcd Handle for OTG FS core
+ */
+void HAL_PCD_MspInit(PCD_HandleTypeDef* hpcd) {
+
+  GPIO_InitTypeDef gpioInitalization;
+
+  __HAL_RCC_GPIOA_CLK_ENABLE();
+
+  gpioInitalization.Pin       = USB_DM_PIN | USB_DP_PIN;
+  gpioInitalization.Mode      = GPIO_MODE_AF_PP;
+  gpioInitalization.Pull      = GPIO_NOPULL;
+  gpioInitalization.Speed     = GPIO_SPEED_FREQ_VERY_HIGH;
+  gpioInitalization.Alternate = GPIO_AF10_OTG_FS;
+  HAL_GPIO_Init(USB_GPIO_PORT, &gpioInitalization);
+
+  // 48 MHz clock comes from PLLQ (see CommonHal_initialize)
+  __HAL_RCC_USB_OTG_FS_CLK_ENABLE();
+
+  HAL_NVIC_SetPriority(OTG_FS_IRQn, USB_IRQ_PRIORITY, 0);
+  HAL_NVIC_EnableIRQ(OTG_FS_IRQn);
+}
+/**
+ * @brief Releases USB pins, clock and IRQ.
+ * @param hpcd Handle for OTG FS core
+ */
+void HAL_PCD_MspDeInit(PCD_HandleTypeDef* hpcd) {
+  HAL_NVIC_DisableIRQ(OTG_FS_IRQn);
+  __HAL_RCC_USB_OTG_FS_CLK_DISABLE();
+  HAL_GPIO_DeInit(USB_GPIO_PORT, USB_DM_PIN | USB_DP_PIN);
+}
+/**
+ * @brief Handles OTG FS interrupt.
+ */
+void OTG_FS_IRQHandler(void) {
+  HAL_PCD_IRQHandler(&pcdHandle);
+}
+/**
+ * @brief Passes setup stage to USB library.
+ * @param hpcd Handle for OTG FS core
+ */
+void HAL_PCD_SetupStageCallback(PCD_HandleTypeDef* hpcd) {
+  USBD_LL_SetupStage(hpcd->pData, (uint8_t*)hpcd->Setup);
+}
+/**
+ * @brief Passes end of OUT transfer to USB library.
+ * @param hpcd Handle for OTG FS core
+ * @param epnum Endpoint number
+ */
+void HAL_PCD_DataOutStageCallback(PCD_HandleTypeDef* hpcd, uint8_t epnum) {
+  USBD_LL_DataOutStage(hpcd->pData, epnum, hpcd->OUT_ep[epnum].xfer_buff);
+}
+/**
+ * @brief Passes end of IN transfer to USB library.
+ * @param hpcd Handle for OTG FS core
+ * @param epnum Endpoint number
+ */
+void HAL_PCD_DataInStageCallback(PCD_HandleTypeDef* hpcd, uint8_t epnum) {
+  USBD_LL_DataInStage(hpcd->pData, epnum, hpcd->IN_ep[epnum].xfer_buff);
+}
+/**
+ * @brief Passes start of frame to USB library.
+ * @param hpcd Handle for OTG FS core
+ */
+void HAL_PCD_SOFCallback(PCD_HandleTypeDef* hpcd) {
+  USBD_LL_SOF(hpcd->pData);
+}
+/**
+ * @brief Passes bus reset to USB library.
+ * @param hpcd Handle for OTG FS core
+ */
+void HAL_PCD_ResetCallback(PCD_HandleTypeDef* hpcd) {
+  USBD_LL_SetSpeed(hpcd->pData, USBD_SPEED_FULL);
+  USBD_LL_Reset(hpcd->pData);
+}
+/**
+ * @brief Passes suspend to USB library.
+ * @param hpcd Handle for OTG FS core
+ */
+void HAL_PCD_SuspendCallback(PCD_HandleTypeDef* hpcd) {
+  USBD_LL_Suspend(hpcd->pData);
+}
+/**
+ * @brief Passes resume to USB library.
+ * @param hpcd Handle for OTG FS core
+ */
+void HAL_PCD_ResumeCallback(PCD_HandleTypeDef* hpcd) {
+  USBD_LL_Resume(hpcd->pData);
+}
+/**
+ * @brief Passes incomplete isochronous OUT transfer to USB library.
+ * @param hpcd Handle for OTG FS core
+ * @param epnum Endpoint number
+ */
+void HAL_PCD_ISOOUTIncompleteCallback(PCD_HandleTypeDef* hpcd, uint8_t epnum) {
+  USBD_LL_IsoOUTIncomplete(hpcd->pData, epnum);
+}
+/**
+ * @brief Passes incomplete isochronous IN transfer to USB library.
+ * @param hpcd Handle for OTG FS core
+ * @param epnum Endpoint number
+ */
+void HAL_PCD_ISOINIncompleteCallback(PCD_HandleTypeDef* hpcd, uint8_t epnum) {
+  USBD_LL_IsoINIncomplete(hpcd->pData, epnum);
+}
+/**
+ * @brief Passes connection to USB library.
+ * @param hpcd Handle for OTG FS core
+ */
+void HAL_PCD_ConnectCallback(PCD_HandleTypeDef* hpcd) {
+  USBD_LL_DevConnected(hpcd->pData);
+}
+/**
+ * @brief Passes disconnection to USB library.
+ * @param hpcd Handle for OTG FS core
+ */
+void HAL_PCD_DisconnectCallback(PCD_HandleTypeDef* hpcd) {
+  USBD_LL_DevDisconnected(hpcd->pData);
+}
+
+/**
+ * @}
+ */
+
+#endif /* USE_USB_CDC */
@@ -0,0 +1,62 @@
+/**
+ * @file    usbd_conf.h
+ * @brief   Configuration of the USB device library.
+ * @date    18.10.2026
+ * @author  Michal Ksiezopolski
+ *
+ * @verbatim
+ * Copyright (c) 2026 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef USBD_CONF_H_
+#define USBD_CONF_H_
+
+#if defined(USE_F4_DISCOVERY)
+  #include <stm32f4xx_hal.h>
+#elif defined(USE_F7_DISCOVERY)
+  #include <stm32f7xx_hal.h>
+#else
+  #error "No board defined"
+#endif
+#include <string.h>
+
+/**
+ * @addtogroup USB_CDC
+ * @{
+ */
+
+#define USBD_MAX_NUM_INTERFACES     1
+#define USBD_MAX_NUM_CONFIGURATION  1
+#define USBD_MAX_STR_DESC_SIZ       0x100
+#define USBD_SUPPORT_USER_STRING    0
+#define USBD_SELF_POWERED           0
+#define USBD_DEBUG_LEVEL            0
+#define USBD_LPM_ENABLED            0
+
+#define USBD_CDC_INTERVAL           2000 ///< Not used by full speed device
+
+void* USBD_static_malloc(uint32_t size);
+void  USBD_static_free(void* pointer);
+
+// the library allocates only the class data, so it is allocated statically
+#define USBD_malloc   USBD_static_malloc
+#define USBD_free     USBD_static_free
+#define USBD_memset   memset
+#define USBD_memcpy   memcpy
+
+#define USBD_UsrLog(...)
+#define USBD_ErrLog(...)
+#define USBD_DbgLog(...)
+
+/**
+ * @}
+ */
+
+#endif /* USBD_CONF_H_ */
@@ -0,0 +1,183 @@
+/**
+ * @file    usbd_desc.c
+ * @brief   USB device descriptors.
+ * @date    18.10.2026
+ * @author  Michal Ksiezopolski
+ *
+ * @verbatim
+ * Copyright (c) 2026 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifdef USE_USB_CDC
+
+#include "usbd_desc.h"
+#include "usbd_core.h"
+
+/**
+ * @addtogroup USB_CDC
+ * @{
+ */
+
+#define USB_VENDOR_ID         0x0483  ///< STMicroelectronics
+#define USB_PRODUCT_ID        0x5740  ///< Virtual COM port
+#define USB_LANGUAGE_ID       0x0409  ///< English (United States)
+#define USB_MANUFACTURER      "Michal Ksiezopolski"
+#define USB_PRODUCT           "STM32 Virtual COM Port"
+#define USB_CONFIGURATION     "CDC Config"
+#define USB_INTERFACE         "CDC Interface"
+
+#if defined(USE_F7_DISCOVERY)
+  #define DEVICE_ID_ADDRESS   0x1ff0f420  ///< Unique device ID
+#else
+  #define DEVICE_ID_ADDRESS   0x1fff7a10  ///< Unique device ID
+#endif
+
+#define SERIAL_STRING_LENGTH  12  ///< Number of hex digits in serial number
+
+static uint8_t* getDeviceDescriptor(USBD_SpeedTypeDef speed, uint16_t* length);
+static uint8_t* getLanguageIdDescriptor(USBD_SpeedTypeDef speed, uint16_t* length);
+static uint8_t* getManufacturerDescriptor(USBD_SpeedTypeDef speed, uint16_t* length);
+static uint8_t* getProductDescriptor(USBD_SpeedTypeDef speed, uint16_t* length);
+static uint8_t* getSerialDescriptor(USBD_SpeedTypeDef speed, uint16_t* length);
+static uint8_t* getConfigurationDescriptor(USBD_SpeedTypeDef speed, uint16_t* length);
+static uint8_t* getInterfaceDescriptor(USBD_SpeedTypeDef speed, uint16_t* length);
+
+/**
+ * @brief Descriptors of virtual COM port device
+ */
+USBD_DescriptorsTypeDef UsbDescriptors_virtualComPort = {
+  getDeviceDescriptor,
+  getLanguageIdDescriptor,
+  getManufacturerDescriptor,
+  getProductDescriptor,
+  getSerialDescriptor,
+  getConfigurationDescriptor,
+  getInterfaceDescriptor,
+};
+
+/**
+ * @brief Device descriptor
+ */
+__ALIGN_BEGIN static uint8_t deviceDescriptor[USB_LEN_DEV_DESC] __ALIGN_END = {
+  USB_LEN_DEV_DESC,           // bLength
+  USB_DESC_TYPE_DEVICE,       // bDescriptorType
+  0x00, 0x02,                 // bcdUSB 2.00
+  0x02,                       // bDeviceClass CDC
+  0x02,                       // bDeviceSubClass
+  0x00,                       // bDeviceProtocol
+  USB_MAX_EP0_SIZE,           // bMaxPacketSize
+  LOBYTE(USB_VENDOR_ID), HIBYTE(USB_VENDOR_ID),
+  LOBYTE(USB_PRODUCT_ID), HIBYTE(USB_PRODUCT_ID),
+  0x00, 0x02,                 // bcdDevice 2.00
+  USBD_IDX_MFC_STR,           // iManufacturer
+  USBD_IDX_PRODUCT_STR,       // iProduct
+  USBD_IDX_SERIAL_STR,        // iSerialNumber
+  USBD_MAX_NUM_CONFIGURATION, // bNumConfigurations
+};
+
+/**
+ * @brief Language ID descriptor
+ */
+__ALIGN_BEGIN static uint8_t languageIdDescriptor[USB_LEN_LANGID_STR_DESC] __ALIGN_END = {
+  USB_LEN_LANGID_STR_DESC,
+  USB_DESC_TYPE_STRING,
+  LOBYTE(USB_LANGUAGE_ID), HIBYTE(USB_LANGUAGE_ID),
+};
+
+__ALIGN_BEGIN static uint8_t stringDescriptor[USBD_MAX_STR_DESC_SIZ] __ALIGN_END; ///< Buffer for string descriptors
+
+/**
+ * @brief Returns device descriptor.
+ * @param speed Device speed
+ * @param length Length of descriptor
+ * @return Descriptor
+ */
+static uint8_t* getDeviceDescriptor(USBD_SpeedTypeDef speed, uint16_t* length) {
+  *length = sizeof(deviceDescriptor);
+  return deviceDescriptor;
+}
+/**
+ * @brief Returns language ID descriptor.
+ * @param speed Device speed
+ * @param length Length of descriptor
+ * @return Descriptor
+ */
+static uint8_t* getLanguageIdDescriptor(USBD_SpeedTypeDef speed, uint16_t* length) {
+  *length = sizeof(languageIdDescriptor);
+  return languageIdDescriptor;
+}
+/**
+ * @brief Returns manufacturer string descriptor.
+ * @param speed Device speed
+ * @param length Length of descriptor
+ * @return Descriptor
+ */
+static uint8_t* getManufacturerDescriptor(USBD_SpeedTypeDef speed, uint16_t* length) {
+  USBD_GetString((uint8_t*)USB_MANUFACTURER, stringDescriptor, length);
+  return stringDescriptor;
+}
+/**
+ * @brief Returns product string descriptor.
+ * @param speed Device speed
+ * @param length Length of descriptor
+ * @return Descriptor
+ */
+static uint8_t* getProductDescriptor(USBD_SpeedTypeDef speed, uint16_t* length) {
+  USBD_GetString((uint8_t*)USB_PRODUCT, stringDescriptor, length);
+  return stringDescriptor;
+}
+/**
+ * @brief Returns serial number string descriptor.
+ * @details Serial number is made from the unique device ID, so that the
+ * host assigns the same port to the same board.
+ * @param speed Device speed
+ * @param length Length of descriptor
+ * @return Descriptor
+ */
+static uint8_t* getSerialDescriptor(USBD_SpeedTypeDef speed, uint16_t* length) {
+  const uint32_t* deviceId = (const uint32_t*)DEVICE_ID_ADDRESS;
+  uint64_t serial = ((uint64_t)(deviceId[0] + deviceId[2]) << 16) | (deviceId[1] >> 16);
+  char serialString[SERIAL_STRING_LENGTH + 1];
+
+  for (int i = SERIAL_STRING_LENGTH - 1; i >= 0; i--) {
+    serialString[i] = "0123456789ABCDEF"[serial & 0x0f];
+    serial >>= 4;
+  }
+  serialString[SERIAL_STRING_LENGTH] = 0;
+
+  USBD_GetString((uint8_t*)serialString, stringDescriptor, length);
+  return stringDescriptor;
+}
+/**
+ * @brief Returns configuration string descriptor.
+ * @param speed Device speed
+ * @param length Length of descriptor
+ * @return Descriptor
+ */
+static uint8_t* getConfigurationDescriptor(USBD_SpeedTypeDef speed, uint16_t* length) {
+  USBD_GetString((uint8_t*)USB_CONFIGURATION, stringDescriptor, length);
+  return stringDescriptor;
+}
+/**
+ * @brief Returns interface string descriptor.
+ * @param speed Device speed
+ * @param length Length of descriptor
+ * @return Descriptor
+ */
+static uint8_t* getInterfaceDescriptor(USBD_SpeedTypeDef speed, uint16_t* length) {
+  USBD_GetString((uint8_t*)USB_INTERFACE, stringDescriptor, length);
+  return stringDescriptor;
+}
+
+/**
+ * @}
+ */
+
+#endif /* USE_USB_CDC */
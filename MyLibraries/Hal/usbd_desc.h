@@ -0,0 +1,34 @@
+/**
+ * @file    usbd_desc.h
+ * @brief   USB device descriptors.
+ * @date    18.10.2026
+ * @author  Michal Ksiezopolski
+ *
+ * @verbatim
+ * Copyright (c) 2026 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef USBD_DESC_H_
+#define USBD_DESC_H_
+
+#include "usbd_def.h"
+
+/**
+ * @addtogroup USB_CDC
+ * @{
+ */
+
+extern USBD_DescriptorsTypeDef UsbDescriptors_virtualComPort;
+
+/**
+ * @}
+ */
+
+#endif /* USBD_DESC_H_ */
@@ -25,15 +25,9 @@
 #include <math.h>
 #include <stdio.h>
 
-#define DEBUG_HMC5883L
-
-#ifdef DEBUG_HMC5883L
-#define print(str, args...) printf("HMC5883L--> "str"%s",##args,"\r")
-#define println(str, args...) printf("HMC5883L--> "str"%s",##args,"\r\n")
-#else
-#define print(str, args...) (void)0
-#define println(str, args...) (void)0
-#endif
+#define LOG_MODULE_PREFIX "HMC5883L--> "     ///< Prefix of log lines
+#define LOG_MODULE_LEVEL  LOG_LEVEL_HMC5883L ///< Set with -DLOG_LEVEL_HMC5883L=<level>
+#include "log_module.h"
 
 #define HMC5883L_ADDRESS 0x3c ///< Address on I2C bus
 /**
@@ -120,7 +114,7 @@ void Hmc5883l_initialize(void) {
   I2c_initialize(I2C_HAL_I2C1);
   if (readRegister(HMC5883L_IDA) != 'H' || readRegister(HMC5883L_IDB) != '4' ||
       readRegister(HMC5883L_IDC) != '3') {
-    println("Error. Wrong device");
+    logError("Wrong device");
   }
   uint8_t registerValue = readRegister(HMC5883L_STATUS);
   println("Status %02x", registerValue);
@@ -24,15 +24,9 @@
 #include "ili9320_hal.h"
 #include <stdio.h>
 
-#define DEBUG_ILI9320
-
-#ifdef DEBUG_ILI9320
-#define print(str, args...) printf(""str"%s",##args,"")
-#define println(str, args...) printf("ILI9320--> "str"%s",##args,"\r\n")
-#else
-#define print(str, args...) (void)0
-#define println(str, args...) (void)0
-#endif
+#define LOG_MODULE_PREFIX "ILI9320--> "     ///< Prefix of log lines
+#define LOG_MODULE_LEVEL  LOG_LEVEL_ILI9320 ///< Set with -DLOG_LEVEL_ILI9320=<level>
+#include "log_module.h"
 
 /**
  * @addtogroup ILI9320
@@ -119,7 +113,7 @@ void ILI9320_Initializtion(void) {
 
   int id = ILI9320_HAL_ReadReg(ILI9320_READ_ID);
 
-  println("ID TFT LCD = %x", id);
+  logInfo("ID TFT LCD = %x", id);
 
   // Add more LCD init codes here
   if (id == ILI9320_ID) {
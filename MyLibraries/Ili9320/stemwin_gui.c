@@ -19,15 +19,9 @@
   #include <stm32f7xx_hal.h>
 #endif
 
-#define DEBUG_STGUI
-
-#ifdef DEBUG_STGUI
-#define print(str, args...) printf(""str"%s",##args,"")
-#define println(str, args...) printf("MAIN--> "str"%s",##args,"\r\n")
-#else
-#define print(str, args...) (void)0
-#define println(str, args...) (void)0
-#endif
+#define LOG_MODULE_PREFIX "MAIN--> "            ///< Prefix of log lines
+#define LOG_MODULE_LEVEL  LOG_LEVEL_STEMWIN_GUI ///< Set with -DLOG_LEVEL_STEMWIN_GUI=<level>
+#include "log_module.h"
 
 #define EXAMPLE_FRAME_ID (GUI_ID_USER+1) ///< ID of frame
 
@@ -20,17 +20,12 @@
 
 #include "ir_codes.h"
 #include "ir_codes_hal.h"
+#include "deferred.h"
 #include <stdio.h>
 
-#define DEBUG_IR
-
-#ifdef DEBUG_IR
-  #define print(str, args...) printf(""str"%s",##args,"")
-  #define println(str, args...) printf("IR--> "str"%s",##args,"\r\n")
-#else
-  #define print(str, args...) (void)0
-  #define println(str, args...) (void)0
-#endif
+#define LOG_MODULE_PREFIX "IR--> "     ///< Prefix of log lines
+#define LOG_MODULE_LEVEL  LOG_LEVEL_IR ///< Set with -DLOG_LEVEL_IR=<level>
+#include "log_module.h"
 
 /**
  * @defgroup  IR IR
@@ -43,6 +38,14 @@
 
 static void resetFrameCb(void);
 static void receiveDataCb(int pulseWidthMicros, IrPulseState pulse);
+static void decodePulse(void* argument);
+static void frameTimeout(void* argument);
+static void resetFrame(void* argument);
+static void decodeRc5(int pulseWidthMicros, IrPulseState pulse);
+
+#define PULSE_TO_ARGUMENT(width, pulse) ((void*)(((uintptr_t)(width) << 1) | (pulse))) ///< Packs pulse for deferred call
+#define ARGUMENT_TO_PULSE_WIDTH(x)      ((int)((uintptr_t)(x) >> 1))                   ///< Unpacks pulse width
+#define ARGUMENT_TO_PULSE_STATE(x)      ((IrPulseState)((uintptr_t)(x) & 1))           ///< Unpacks pulse state
 
 /**
  * @brief IR coding
@@ -72,6 +75,9 @@ static Boolean frameToggleBit;      ///< Toggle bit
 static int pulseCount;              ///< Counts the number of half bits
 static int bitCount;                ///< Counts the number of bits received
 static int numberOfReceivedFrames;  ///< Received frames counter
+static int numberOfDroppedFrames;   ///< Frames discarded, because their pulses didn't fit in deferred queue
+static volatile unsigned int droppedPulseCount; ///< Pulses which didn't fit in deferred queue (interrupt)
+static unsigned int handledDropCount;           ///< Dropped pulses whose frames were already discarded
 /**
  * @brief RC5 commands
  */
@@ -109,16 +115,87 @@ typedef enum {
 void IrCodes_initialize(void) {
   IrCodesHal_initialize(receiveDataCb, resetFrameCb, RC5_FRAME_TIMEOUT_MICROS);
 }
+/**
+ * @brief Returns number of frames discarded, because some of their pulses
+ * didn't fit in the deferred queue.
+ * @details If the frame timeout reset didn't fit in the queue, the next
+ * frame is discarded and counted too.
+ * @return Number of discarded frames
+ */
+int IrCodes_getDroppedFrameCount(void) {
+  return numberOfDroppedFrames;
+}
+/**
+ * @brief Queues received pulse for decoding
+ * @details This function is called by the lower layer (in interrupt) every
+ * time a transition on the IR data line occurs (rising or falling edge).
+ * Decoding and printing is deferred to the main loop (Deferred_process).
+ * If the queue is full, the pulse is counted as dropped, so the decoder
+ * discards its frame instead of decoding the remaining pulses.
+ * @param pulseWidthMicros Width of the received pulse in us.
+ * @param pulse IR_LOW_PULSE - low pulse (rising edge), IR_HIGH_PULSE - high pulse (falling edge)
+ */
+static void receiveDataCb(int pulseWidthMicros, IrPulseState pulse) {
+  if (!Deferred_call(decodePulse, PULSE_TO_ARGUMENT(pulseWidthMicros, pulse))) {
+    droppedPulseCount++;
+  }
+}
+/**
+ * @brief Queues frame reset after timeout
+ * @details Called by the lower layer in interrupt. The reset is queued
+ * after the pulses received before the timeout, with the number of pulses
+ * dropped until now (all of them belong to frames ended by this timeout).
+ * If the reset doesn't fit in the queue, it is counted as a dropped pulse,
+ * so the next frame is discarded instead of being decoded on top of this one.
+ */
+static void resetFrameCb(void) {
+  if (!Deferred_call(frameTimeout, (void*)(uintptr_t)droppedPulseCount)) {
+    droppedPulseCount++;
+  }
+}
+/**
+ * @brief Decodes pulse queued by receiveDataCb
+ * @details Pulses of a frame which lost a pulse are ignored until the frame
+ * timeout.
+ * @param argument Packed pulse width and state
+ */
+static void decodePulse(void* argument) {
+  if (droppedPulseCount != handledDropCount) {
+    resetFrame(NULL);
+    return;
+  }
+  decodeRc5(ARGUMENT_TO_PULSE_WIDTH(argument), ARGUMENT_TO_PULSE_STATE(argument));
+}
+/**
+ * @brief Resets frame after timeout and counts frame discarded because of
+ * dropped pulses.
+ * @param argument Number of pulses dropped before the timeout
+ */
+static void frameTimeout(void* argument) {
+  unsigned int dropCount = (unsigned int)(uintptr_t)argument;
+  if (dropCount != handledDropCount) {
+    handledDropCount = dropCount;
+    numberOfDroppedFrames++;
+    logWarning("Frame dropped - deferred queue full");
+  }
+  resetFrame(NULL);
+}
+/**
+ * @brief Resets frame after timeout.
+ * @param argument Not used
+ */
+static void resetFrame(void* argument) {
+  bitCount = RC5_NUMBER_OF_BITS_IN_FRAME;
+  pulseCount = 0;
+}
 /**
  * @brief Decode RC5 data
- * @details This function is called by the lower layer every time
- * a transition on the IR data line occurs (rising or falling edge).
- * The period is the time between two falling edges (the IR data
+ * @details The period is the time between two falling edges (the IR data
  * line is pulled up in idle state).
  * @param pulseWidthMicros Width of the received pulse in us.
  * @param pulse IR_LOW_PULSE - low pulse (rising edge), IR_HIGH_PULSE - high pulse (falling edge)
  */
-void receiveDataCb(int pulseWidthMicros, IrPulseState pulse) {
+static void decodeRc5(int pulseWidthMicros, IrPulseState pulse) {
 
   const int START_BIT1_POSITION = 13;
   const int START_BIT2_POSITION = 12;
@@ -132,7 +209,7 @@ void receiveDataCb(int pulseWidthMicros, IrPulseState pulse) {
     return;
   } else if (pulseCount == 0 && pulse == IR_LOW_PULSE) {
     // frame should start with falling edge
-    resetFrameCb();
+    resetFrame(NULL);
     return;
   }
 
@@ -140,16 +217,16 @@ void receiveDataCb(int pulseWidthMicros, IrPulseState pulse) {
   // It is relevant for all following edges
   if ((pulseWidthMicros > RC5_MAX_BIT_LENGTH_MICROS) ||
       (pulseWidthMicros < RC5_MIN_HALFBIT_LENGTH_MICROS)) {
-    println("Frame error - wrong pulse width");
-    resetFrameCb();
+    logWarning("Frame error - wrong pulse width");
+    resetFrame(NULL);
     return;
   }
 
   if (bitCount == START_BIT1_POSITION) {
     // pulse width has to be 800 us - first two bits are a one
     if (pulseWidthMicros > RC5_MAX_HALFBIT_LENGTH_MICROS) {
-      println("Frame error - wrong start bits, probably not RC5");
-      resetFrameCb();
+      logWarning("Frame error - wrong start bits, probably not RC5");
+      resetFrame(NULL);
       return;
     }
     receivedFrame |= (TRUE<<bitCount--); // First bit (put as MSB) is a one
@@ -157,8 +234,8 @@ void receiveDataCb(int pulseWidthMicros, IrPulseState pulse) {
   } else if (bitCount == START_BIT2_POSITION) {
     // pulseWidth has to be 800 us - first two bits are a one
     if (pulseWidthMicros > RC5_MAX_HALFBIT_LENGTH_MICROS) {
-      println("Frame error - wrong start bits, probably not RC5");
-      resetFrameCb();
+      logWarning("Frame error - wrong start bits, probably not RC5");
+      resetFrame(NULL);
       return;
     }
     receivedFrame |= (TRUE<<bitCount--); // Second bit is a one
@@ -181,25 +258,18 @@ void receiveDataCb(int pulseWidthMicros, IrPulseState pulse) {
     }
     // when bit zero is written, bitCount is -1
     if (bitCount < 0) {
-      resetFrameCb(); // reset frame
+      resetFrame(NULL); // reset frame
       numberOfReceivedFrames++; // add received frame
       frameToggleBit = (receivedFrame>>RC5_TOGGLE_BIT_POSITION) & (RC5_TOGGLE_BIT_MASK);
       frameAddress = (receivedFrame>>RC5_ADDRESS_POSITION) & (RC5_ADDRESS_MASK);
       frameCommand = (receivedFrame>>RC5_COMMAND_POSITION) & (RC5_COMMAND_MASK);
-      println("Frame received: %04x. Toggle = %d Command = %d Address = %d",
+      logInfo("Frame received: %04x. Toggle = %d Command = %d Address = %d",
           receivedFrame, frameToggleBit, frameCommand, frameAddress);
       return;
     }
     pulseCount++;
   }
 }
-/**
- * @brief Resets frame after timeout.
- */
-void resetFrameCb(void) {
-  bitCount = RC5_NUMBER_OF_BITS_IN_FRAME;
-  pulseCount = 0;
-}
 
 /**
  * @}
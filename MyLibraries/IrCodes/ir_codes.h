@@ -30,7 +30,8 @@
  * @{
  */
 
-void IrCodes_initialize(void);
+void IrCodes_initialize           (void);
+int  IrCodes_getDroppedFrameCount (void);
 
 /**
  * @}
@@ -20,17 +20,9 @@
 #include <stdio.h>
 #include <keys_hal.h>
 
-#ifndef DEBUG
-  #define DEBUG
-#endif
-
-#ifdef DEBUG
-  #define print(str, args...) printf("KEYS--> "str"%s",##args,"\r")
-  #define println(str, args...) printf("KEYS--> "str"%s",##args,"\r\n")
-#else
-  #define print(str, args...) (void)0
-  #define println(str, args...) (void)0
-#endif
+#define LOG_MODULE_PREFIX "KEYS--> "     ///< Prefix of log lines
+#define LOG_MODULE_LEVEL  LOG_LEVEL_KEYS ///< Set with -DLOG_LEVEL_KEYS=<level>
+#include "log_module.h"
 
 /**
  * @addtogroup KEYS
@@ -78,15 +70,15 @@ uint8_t KEYS_Update(void) {
   uint8_t currentKey      = KEY_NONE; // stores temporary key received from HAL (may be glitch)
 
   static uint8_t repeatFlag = 0; // repeat flag
-  static uint32_t debounceTimer = 0; // timer for counting debounce time
-  static uint32_t repeatTimer = 0;
+  static uint64_t debounceDeadline = 0; // end of debounce time
+  static uint64_t repeatDeadline = 0;   // end of repeat time
 
   int8_t row = KEYS_HAL_ReadRow();
 
   // if a key press has been recognized
   if (row != -1) {
     currentKey = (currentColumn << 4) | row;
-  } else if (Timer_delayTimer(REPEAT_TIME, repeatTimer)) { // repeat timeout
+  } else if (Timer_isDeadlineReached(repeatDeadline)) { // repeat timeout
     repeatFlag = 0;
     lastKey = KEY_NONE;
   }
@@ -95,12 +87,12 @@ uint8_t KEYS_Update(void) {
   if (keyId != currentKey && currentKey != KEY_NONE) {
 
     if (lastKey == currentKey &&
-        !Timer_delayTimer(REPEAT_TIME, repeatTimer)) { // if last key still pressed
+        !Timer_isDeadlineReached(repeatDeadline)) { // if last key still pressed
       repeatFlag = 1;
-      repeatTimer = Timer_getTimeMillis();
+      repeatDeadline = Timer_getDeadlineMillis(REPEAT_TIME);
     } else { // new key
       keyId = currentKey; // store the new key
-      debounceTimer = Timer_getTimeMillis(); // start debounce timer
+      debounceDeadline = Timer_getDeadlineMillis(DEBOUNCE_TIME); // start debounce timer
       lastKey = KEY_NONE;
       repeatFlag = 0;
     }
@@ -108,12 +100,12 @@ uint8_t KEYS_Update(void) {
   }
   // if debounce finished, the key is valid
   if (!repeatFlag && keyId != KEY_NONE &&
-      Timer_delayTimer(DEBOUNCE_TIME, debounceTimer)) {
+      Timer_isDeadlineReached(debounceDeadline)) {
     keyValid = keyId;
     println("You pressed a key 0x%02x.", keyValid);
     lastKey = keyId; // store new last pressed key
     keyId = KEY_NONE;
-    repeatTimer = Timer_getTimeMillis(); // start repeatTimer
+    repeatDeadline = Timer_getDeadlineMillis(REPEAT_TIME); // start repeat timer
   } else if (repeatFlag) {
     keyValid = lastKey;
   }
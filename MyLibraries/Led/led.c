@@ -25,6 +25,7 @@
  */
 
 #include <stdio.h>
+#include <string.h>
 #include "led.h"
 #include "led_hal.h"
 
@@ -88,6 +89,31 @@ LedResultCode Led_toggle(LedNumber led) {
   }
   return LED_OK;
 }
+/**
+ * @brief Controls LEDs from terminal (:LED <number> ON|OFF).
+ * @details Has the signature of a command handler, so it can be
+ * registered with SerialCommand_register(":LED", Led_command).
+ * @param argc Number of arguments (including command name)
+ * @param argv Arguments
+ */
+void Led_command(int argc, char* argv[]) {
+
+  if (argc != 3) {
+    return;
+  }
+
+  // single digit LED number
+  if (argv[1][0] < '0' || argv[1][0] > '9' || argv[1][1] != 0) {
+    return;
+  }
+  LedNumber led = (LedNumber)(argv[1][0] - '0');
+
+  if (!strcmp(argv[2], "ON")) {
+    Led_changeState(led, LED_ON);
+  } else if (!strcmp(argv[2], "OFF")) {
+    Led_changeState(led, LED_OFF);
+  }
+}
 /**
  * @}
  */
@@ -62,6 +62,7 @@ typedef enum {
 LedResultCode Led_addNewLed   (LedNumber led);
 LedResultCode Led_toggle      (LedNumber led);
 LedResultCode Led_changeState (LedNumber led, LedState state);
+void          Led_command     (int argc, char* argv[]);
 
 /**
  * @}
@@ -19,17 +19,15 @@
 #include "mfrc522.h"
 #include "spi_hal.h"
 #include <stdio.h>
+#include <string.h>
 
-#define DEBUG
+#define LOG_MODULE_PREFIX "RFID--> "        ///< Prefix of log lines
+#define LOG_MODULE_LEVEL  LOG_LEVEL_MFRC522 ///< Set with -DLOG_LEVEL_MFRC522=<level>
+#include "log_module.h"
 
-#ifdef DEBUG
-#define print(str, args...) printf(""str"%s",##args,"")
-#define println(str, args...) printf("RFID--> "str"%s",##args,"\r\n")
-#else
-#define print(str, args...) (void)0
-#define println(str, args...) (void)0
-#endif
 
+#define WRITE_ADDRESS(address) (((address) << 1) & 0x7e)          ///< Address byte for write (MSB = 0)
+#define READ_ADDRESS(address)  ((((address) << 1) & 0x7e) | 0x80) ///< Address byte for read (MSB = 1)
 
 typedef enum {
   MFRC522_COMMAND_REG     = 0x01, ///< Starts and stops commands execution
@@ -105,72 +103,213 @@ typedef enum {
   CMD_SOFT_RESET          = 15,//!< CMD_SOFT_RESET
 } Mfrc522Commands;
 
-static uint8_t readRegister(uint8_t address);
-static void writeRegister(uint8_t address, uint8_t data);
-static void softReset(void);
+static int spiDevice = -1; ///< ID of reader on SPI bus
+
+static Mfrc522ResultCode acquireBus(void);
+static Mfrc522ResultCode readRegister(uint8_t address, uint8_t* data);
+static Mfrc522ResultCode readBuffer(uint8_t address, uint8_t* data, int length);
+static Mfrc522ResultCode writeRegister(uint8_t address, uint8_t data);
+static Mfrc522ResultCode writeBuffer(uint8_t address, const uint8_t* data, int length);
+static Mfrc522ResultCode softReset(void);
 
 /**
  * @brief Initialize communication with RFID reader
+ * @retval MFRC522_OK Reader found
+ * @retval MFRC522_BUS_BUSY SPI bus taken by another device
+ * @retval MFRC522_WRONG_DEVICE Version of reader not recognized
  */
-void Mfrc522_initialize(void) {
-  SpiHal_initialize(SPI_HAL_SPI1);
-  for (int i = 0; i < 20; i++) {
-    SpiHal_transmitByte(SPI_HAL_SPI1, 0x00);
+Mfrc522ResultCode Mfrc522_initialize(void) {
+  if (spiDevice < 0) {
+    // shares SPI1 with the SD card, so it has its own chip select
+    const SpiDeviceConfig MFRC522_SPI_CONFIG = {
+        .spi = SPI_HAL_SPI1,
+        .chipSelect = SPI_HAL_CS_SPI1_AUX,
+        .prescaler = SPI_HAL_CLOCK_DIV_256,
+        .mode = SPI_HAL_MODE_0,
+    };
+    spiDevice = SpiHal_addDevice(&MFRC522_SPI_CONFIG);
+  }
+  Mfrc522ResultCode result = softReset();
+  if (result != MFRC522_OK) {
+    return result;
   }
-  softReset();
   uint8_t registerValue;
-  registerValue = readRegister(MFRC522_COMMAND_REG);
+  result = readRegister(MFRC522_COMMAND_REG, &registerValue);
+  if (result != MFRC522_OK) {
+    return result;
+  }
   println("Command reg 0x%02x", registerValue);
-  registerValue = readRegister(MFRC522_VERSION_REG);
+  result = readRegister(MFRC522_VERSION_REG, &registerValue);
+  if (result != MFRC522_OK) {
+    return result;
+  }
   println("Version 0x%02x", registerValue);
   if (registerValue != 0x91 && registerValue != 0x92) {
-    println("Wrong device");
+    logError("Wrong device");
+    return MFRC522_WRONG_DEVICE;
+  }
+  return MFRC522_OK;
+}
+/**
+ * @brief Writes data to the FIFO of the reader.
+ * @details All bytes are sent in one SPI burst.
+ * @param data Data to write
+ * @param length Number of bytes (up to MFRC522_FIFO_SIZE)
+ * @return Number of bytes written or error code
+ * @retval MFRC522_INVALID_LENGTH Data doesn't fit the FIFO
+ * @retval MFRC522_BUS_BUSY SPI bus taken by another device
+ */
+int Mfrc522_writeFifo(const uint8_t* data, int length) {
+  if (length < 0 || length > MFRC522_FIFO_SIZE) {
+    return MFRC522_INVALID_LENGTH;
+  }
+  Mfrc522ResultCode result = writeBuffer(MFRC522_FIFODATA_REG, data, length);
+  if (result != MFRC522_OK) {
+    return result;
   }
+  return length;
+}
+/**
+ * @brief Reads data stored in the FIFO of the reader.
+ * @details The FIFO level is read first, then the data is
+ * read in one SPI burst.
+ * @param data Buffer for data
+ * @param maxLength Size of buffer
+ * @return Number of bytes read or error code
+ * @retval MFRC522_BUS_BUSY SPI bus taken by another device
+ */
+int Mfrc522_readFifo(uint8_t* data, int maxLength) {
+  const uint8_t FIFO_LEVEL_MASK = 0x7f;
+  uint8_t level;
+  Mfrc522ResultCode result = readRegister(MFRC522_FIFOLEVEL_REG, &level);
+  if (result != MFRC522_OK) {
+    return result;
+  }
+  int length = level & FIFO_LEVEL_MASK;
+  if (length > maxLength) {
+    length = maxLength;
+  }
+  if (length <= 0) {
+    return 0;
+  }
+  result = readBuffer(MFRC522_FIFODATA_REG, data, length);
+  if (result != MFRC522_OK) {
+    return result;
+  }
+  return length;
+}
+/**
+ * @brief Clears the FIFO of the reader.
+ * @retval MFRC522_OK FIFO cleared
+ * @retval MFRC522_BUS_BUSY SPI bus taken by another device
+ */
+Mfrc522ResultCode Mfrc522_flushFifo(void) {
+  const uint8_t FLUSH_BUFFER = 0x80;
+  return writeRegister(MFRC522_FIFOLEVEL_REG, FLUSH_BUFFER);
+}
+/**
+ * @brief Takes the SPI bus and selects the reader.
+ * @details The bus is shared with the SD card. Like the SD card driver,
+ * the function doesn't wait for the bus: its holder can't release it while
+ * this function spins (same context or a preempted thread).
+ * @retval MFRC522_OK Bus taken
+ * @retval MFRC522_BUS_BUSY Bus taken by another device
+ */
+Mfrc522ResultCode acquireBus(void) {
+  if (SpiHal_acquire(spiDevice) != 0) {
+    logWarning("SPI bus busy");
+    return MFRC522_BUS_BUSY;
+  }
+  return MFRC522_OK;
 }
 /**
  * @brief Write to a register
  * @param address
  * @param data
+ * @retval MFRC522_OK Register written
+ * @retval MFRC522_BUS_BUSY SPI bus taken by another device
  */
-void writeRegister(uint8_t address, uint8_t data) {
-  SpiHal_select(SPI_HAL_SPI1);
-  // MSB = 0 for write
-  SpiHal_transmitByte(SPI_HAL_SPI1, (address << 1) & 0x7f);
-  SpiHal_transmitByte(SPI_HAL_SPI1, data);
-  SpiHal_deselect(SPI_HAL_SPI1);
+Mfrc522ResultCode writeRegister(uint8_t address, uint8_t data) {
+  uint8_t transmitBuffer[2] = {WRITE_ADDRESS(address), data};
+  if (acquireBus() != MFRC522_OK) {
+    return MFRC522_BUS_BUSY;
+  }
+  SpiHal_sendBuffer(SPI_HAL_SPI1, transmitBuffer, sizeof(transmitBuffer));
+  SpiHal_release(spiDevice);
+  return MFRC522_OK;
 }
 /**
  * @brief Write buffer to a register
+ * @details The address is sent once, all following bytes
+ * are written to the same register (chip select is held).
  * @param address
  * @param data
  * @param len
+ * @retval MFRC522_OK Data written
+ * @retval MFRC522_BUS_BUSY SPI bus taken by another device
  */
-void writeBuffer(uint8_t address, uint8_t* data, uint8_t length) {
-  SpiHal_select(SPI_HAL_SPI1);
-  // MSB = 0 for write
-  // send register address
-  SpiHal_transmitByte(SPI_HAL_SPI1,(address << 1) & 0x7f);
-  for (int i = 0; i < length; i++) {
-    SpiHal_transmitByte(SPI_HAL_SPI1, data[i]);
-  }
-  SpiHal_deselect(SPI_HAL_SPI1);
+Mfrc522ResultCode writeBuffer(uint8_t address, const uint8_t* data, int length) {
+  if (acquireBus() != MFRC522_OK) {
+    return MFRC522_BUS_BUSY;
+  }
+  SpiHal_transmitByte(SPI_HAL_SPI1, WRITE_ADDRESS(address));
+  SpiHal_sendBuffer(SPI_HAL_SPI1, (uint8_t*)data, length);
+  SpiHal_release(spiDevice);
+  return MFRC522_OK;
 }
 /**
  * @brief Read a register
  * @param address
- * @return
+ * @param data Read value
+ * @retval MFRC522_OK Register read
+ * @retval MFRC522_BUS_BUSY SPI bus taken by another device
  */
-uint8_t readRegister(uint8_t address) {
-  SpiHal_select(SPI_HAL_SPI1);
-  // MSB = 1 for read
-  SpiHal_transmitByte(SPI_HAL_SPI1, ((address << 1) & 0x7f) | 0x80);
-  uint8_t registerValue = SpiHal_transmitByte(SPI_HAL_SPI1, 0x00);
-  SpiHal_deselect(SPI_HAL_SPI1);
-  return registerValue;
+Mfrc522ResultCode readRegister(uint8_t address, uint8_t* data) {
+  uint8_t transmitBuffer[2] = {READ_ADDRESS(address), 0x00};
+  uint8_t receiveBuffer[2];
+  if (acquireBus() != MFRC522_OK) {
+    return MFRC522_BUS_BUSY;
+  }
+  SpiHal_transmitBuffer(SPI_HAL_SPI1, receiveBuffer, transmitBuffer,
+      sizeof(transmitBuffer));
+  SpiHal_release(spiDevice);
+  *data = receiveBuffer[1];
+  return MFRC522_OK;
+}
+/**
+ * @brief Read a register multiple times (e.g. the FIFO)
+ * @details Every byte sent is the address of the next read, the
+ * read data comes one byte later. The last sent byte is 0x00.
+ * @param address
+ * @param data Buffer for data
+ * @param length Number of reads (up to MFRC522_FIFO_SIZE)
+ * @retval MFRC522_OK Data read
+ * @retval MFRC522_INVALID_LENGTH Length out of range
+ * @retval MFRC522_BUS_BUSY SPI bus taken by another device
+ */
+Mfrc522ResultCode readBuffer(uint8_t address, uint8_t* data, int length) {
+
+  uint8_t transmitBuffer[MFRC522_FIFO_SIZE];
+
+  if (length <= 0 || length > MFRC522_FIFO_SIZE) {
+    return MFRC522_INVALID_LENGTH;
+  }
+  memset(transmitBuffer, READ_ADDRESS(address), length - 1);
+  transmitBuffer[length - 1] = 0x00;
+
+  if (acquireBus() != MFRC522_OK) {
+    return MFRC522_BUS_BUSY;
+  }
+  SpiHal_transmitByte(SPI_HAL_SPI1, READ_ADDRESS(address));
+  SpiHal_transmitBuffer(SPI_HAL_SPI1, data, transmitBuffer, length);
+  SpiHal_release(spiDevice);
+  return MFRC522_OK;
 }
 /**
  * @brief Execute soft reset
+ * @retval MFRC522_OK Reset command sent
+ * @retval MFRC522_BUS_BUSY SPI bus taken by another device
  */
-void softReset(void) {
-  writeRegister(MFRC522_COMMAND_REG, CMD_SOFT_RESET);
+Mfrc522ResultCode softReset(void) {
+  return writeRegister(MFRC522_COMMAND_REG, CMD_SOFT_RESET);
 }
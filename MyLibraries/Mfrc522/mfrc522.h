@@ -19,7 +19,23 @@
 #define APP_INC_MFRC522_H_
 
 #include "utils.h"
+#include <inttypes.h>
 
-void Mfrc522_initialize(void);
+#define MFRC522_FIFO_SIZE 64 ///< Size of the FIFO of the reader
+
+/**
+ * @brief MFRC522 errors
+ */
+typedef enum {
+  MFRC522_OK = 0,                   //!< MFRC522_OK
+  MFRC522_BUS_BUSY = -100,          //!< SPI bus taken by another device
+  MFRC522_WRONG_DEVICE = -101,      //!< Version register doesn't match MFRC522
+  MFRC522_INVALID_LENGTH = -102,    //!< Data doesn't fit the FIFO
+} Mfrc522ResultCode;
+
+Mfrc522ResultCode Mfrc522_initialize(void);
+int               Mfrc522_writeFifo (const uint8_t* data, int length);
+int               Mfrc522_readFifo  (uint8_t* data, int maxLength);
+Mfrc522ResultCode Mfrc522_flushFifo (void);
 
 #endif /* APP_INC_MFRC522_H_ */
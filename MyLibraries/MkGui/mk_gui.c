@@ -23,15 +23,9 @@
 #include "ili9320.h"
 #include <stdio.h>
 
-#define DEBUG
-
-#ifdef DEBUG
-#define print(str, args...) printf(""str"%s",##args,"")
-#define println(str, args...) printf("GUI--> "str"%s",##args,"\r\n")
-#else
-#define print(str, args...) (void)0
-#define println(str, args...) (void)0
-#endif
+#define LOG_MODULE_PREFIX "GUI--> "     ///< Prefix of log lines
+#define LOG_MODULE_LEVEL  LOG_LEVEL_GUI ///< Set with -DLOG_LEVEL_GUI=<level>
+#include "log_module.h"
 
 /**
  * @addtogroup GUI
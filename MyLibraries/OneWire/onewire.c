@@ -24,15 +24,9 @@
 #include "timers.h"
 #include <stdio.h>
 
-#define DEBUG_ONEWIRE
-
-#ifdef DEBUG_ONEWIRE
-#define print(str, args...) printf("ONEWIRE--> "str"%s",##args,"")
-#define println(str, args...) printf("ONEWIRE--> "str"%s",##args,"\r\n")
-#else
-#define print(str, args...) (void)0
-#define println(str, args...) (void)0
-#endif
+#define LOG_MODULE_PREFIX "ONEWIRE--> "     ///< Prefix of log lines
+#define LOG_MODULE_LEVEL  LOG_LEVEL_ONEWIRE ///< Set with -DLOG_LEVEL_ONEWIRE=<level>
+#include "log_module.h"
 
 #define ONEWIRE_MAX_DEVICES     16  ///< Maximum number of devices on the bus
 #define ROM_LENGTH_WITHOUT_CRC  8   ///< Length of ROM without CRC
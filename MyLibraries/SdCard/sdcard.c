@@ -26,17 +26,9 @@
  * @{
  */
 
-#ifndef DEBUG
-  #define DEBUG
-#endif
-
-#ifdef DEBUG
-  #define print(str, args...) printf(""str"%s",##args,"")
-  #define println(str, args...) printf("SD--> "str"%s",##args,"\r\n")
-#else
-  #define print(str, args...) (void)0
-  #define println(str, args...) (void)0
-#endif
+#define LOG_MODULE_PREFIX "SD--> "         ///< Prefix of log lines
+#define LOG_MODULE_LEVEL  LOG_LEVEL_SDCARD ///< Set with -DLOG_LEVEL_SDCARD=<level>
+#include "log_module.h"
 
 /**
  * @brief SD commands (SPI command subset) as per SanDisk Secure Digital Card
@@ -90,11 +82,44 @@ typedef enum {
 #define SD_TOKEN_DATA_ACCEPTED  0x05 ///< Data accepted
 #define SD_TOKEN_DATA_CRC       0x0b ///< Data rejected due to CRC error
 #define SD_TOKEN_DATA_WRITE_ERR 0x0d ///< Data rejected due to write error
+#define SD_DATA_RESPONSE_MASK   0x1f ///< Bits of data response token holding the status
 
 static Boolean isSDHC;            ///< Is the card SDHC?
-static uint64_t cardCapacity;     ///< Capacity of SD card in bytes
+static uint64_t cardSectorCount;  ///< Capacity of SD card in 512 byte sectors
 static Boolean isCardInIdleState; ///< Is card in IDLE state
 static Boolean isCardInitalized;  ///< Is the card initalized
+static Boolean isCrcEnabled;      ///< Are data CRCs sent and checked (CMD59)
+static int spiDevice = -1;        ///< ID of card on SPI bus
+
+#define SD_MAX_CRC_RETRIES 3 ///< Number of times a transfer is repeated after a CRC error
+#define SD_REGISTER_LENGTH 16 ///< Length of CSD and CID registers
+#define SD_SECTOR_SIZE_BITS 9 ///< log2 of sector size (512 bytes)
+#define SD_INITIALIZATION_CLOCK SPI_HAL_CLOCK_DIV_256 ///< Below 400 kHz during initialization
+#define SD_TRANSFER_CLOCK       SPI_HAL_CLOCK_DIV_8   ///< Below 25 MHz after initialization
+
+/**
+ * @brief Lookup table for CRC7 (polynomial 0x09) used by SD commands.
+ * @details Values are already shifted left by one bit, the way
+ * the CRC is placed in the last command byte.
+ */
+static const uint8_t crc7Table[256] = {
+  0x00, 0x12, 0x24, 0x36, 0x48, 0x5a, 0x6c, 0x7e, 0x90, 0x82, 0xb4, 0xa6, 0xd8, 0xca, 0xfc, 0xee,
+  0x32, 0x20, 0x16, 0x04, 0x7a, 0x68, 0x5e, 0x4c, 0xa2, 0xb0, 0x86, 0x94, 0xea, 0xf8, 0xce, 0xdc,
+  0x64, 0x76, 0x40, 0x52, 0x2c, 0x3e, 0x08, 0x1a, 0xf4, 0xe6, 0xd0, 0xc2, 0xbc, 0xae, 0x98, 0x8a,
+  0x56, 0x44, 0x72, 0x60, 0x1e, 0x0c, 0x3a, 0x28, 0xc6, 0xd4, 0xe2, 0xf0, 0x8e, 0x9c, 0xaa, 0xb8,
+  0xc8, 0xda, 0xec, 0xfe, 0x80, 0x92, 0xa4, 0xb6, 0x58, 0x4a, 0x7c, 0x6e, 0x10, 0x02, 0x34, 0x26,
+  0xfa, 0xe8, 0xde, 0xcc, 0xb2, 0xa0, 0x96, 0x84, 0x6a, 0x78, 0x4e, 0x5c, 0x22, 0x30, 0x06, 0x14,
+  0xac, 0xbe, 0x88, 0x9a, 0xe4, 0xf6, 0xc0, 0xd2, 0x3c, 0x2e, 0x18, 0x0a, 0x74, 0x66, 0x50, 0x42,
+  0x9e, 0x8c, 0xba, 0xa8, 0xd6, 0xc4, 0xf2, 0xe0, 0x0e, 0x1c, 0x2a, 0x38, 0x46, 0x54, 0x62, 0x70,
+  0x82, 0x90, 0xa6, 0xb4, 0xca, 0xd8, 0xee, 0xfc, 0x12, 0x00, 0x36, 0x24, 0x5a, 0x48, 0x7e, 0x6c,
+  0xb0, 0xa2, 0x94, 0x86, 0xf8, 0xea, 0xdc, 0xce, 0x20, 0x32, 0x04, 0x16, 0x68, 0x7a, 0x4c, 0x5e,
+  0xe6, 0xf4, 0xc2, 0xd0, 0xae, 0xbc, 0x8a, 0x98, 0x76, 0x64, 0x52, 0x40, 0x3e, 0x2c, 0x1a, 0x08,
+  0xd4, 0xc6, 0xf0, 0xe2, 0x9c, 0x8e, 0xb8, 0xaa, 0x44, 0x56, 0x60, 0x72, 0x0c, 0x1e, 0x28, 0x3a,
+  0x4a, 0x58, 0x6e, 0x7c, 0x02, 0x10, 0x26, 0x34, 0xda, 0xc8, 0xfe, 0xec, 0x92, 0x80, 0xb6, 0xa4,
+  0x78, 0x6a, 0x5c, 0x4e, 0x30, 0x22, 0x14, 0x06, 0xe8, 0xfa, 0xcc, 0xde, 0xa0, 0xb2, 0x84, 0x96,
+  0x2e, 0x3c, 0x0a, 0x18, 0x66, 0x74, 0x42, 0x50, 0xbe, 0xac, 0x9a, 0x88, 0xf6, 0xe4, 0xd2, 0xc0,
+  0x1c, 0x0e, 0x38, 0x2a, 0x54, 0x46, 0x70, 0x62, 0x8c, 0x9e, 0xa8, 0xba, 0xc4, 0xd6, 0xe0, 0xf2,
+};
 
 /**
  * @brief SD Card R1 response structure
@@ -185,61 +210,43 @@ typedef struct {
 } __attribute((packed)) SD_CID;
 /**
  * @brief Card specific data register
- * @details The data comes MSB first. In C in a bit array corresponds
- * to the least significant bit.
- *
- * TODO Add version of this register for SDSC cards
+ * @details The register comes MSB first (bit 127 is the first bit of
+ * the first byte). Its layout depends on the CSD version, so the fields
+ * needed by the driver are decoded from the raw bytes.
  */
 typedef struct {
-
-  // fourth uint32_t
-    uint32_t reserved1   :1;
-    uint32_t crc :7;
-    uint32_t reserved2 :2;
-    uint32_t fileFormat :2;
-    uint32_t tmpWrtProtect :1;
-    uint32_t permWrtProtect :1;
-    uint32_t copyFlag :1;
-    uint32_t fileFmtGrp :1;
-
-    uint32_t reserved3 :5;
-    uint32_t partialBlkWrt :1;
-    uint32_t maxWrtBlkLen :4;
-    uint32_t wrtSpeed :3;
-    uint32_t reserved4 :2;
-    uint32_t wrtProtectEna :1;
-
-  // third uint32_t
-    uint32_t wrtProtectSize :7;
-    uint32_t sectorSize :7;
-    uint32_t eraseSingleBlkEna :1;
-    uint32_t reserved5 :1;
-    uint32_t deviceSize :22; ///< Capacity of the card
-
-  // second uint32_t
-    uint32_t reserved6 : 6;
-    uint32_t DSR :1;
-    uint32_t rdBlkMisalign :1;
-    uint32_t wrtBlkMisalign :1;
-    uint32_t rdBlkPartial :1;
-
-    uint32_t maxReadLen :4;
-    uint32_t cardCommandClass :12;
-
-  // first uint32_t
-    uint32_t maxDataRate :8;
-    uint32_t dataRdCycles:8;
-    uint32_t dataRdTime :8;
-    uint32_t reserved7 :6;
-    uint32_t csdType :2;  ///< Type of the structure
-
-} __attribute((packed)) SD_CSD;
+  uint8_t  raw[SD_REGISTER_LENGTH]; ///< Register as sent by the card
+  uint8_t  csdType;                 ///< Type of the structure
+  uint8_t  readBlockLength;         ///< READ_BL_LEN - log2 of maximum read block length
+  uint32_t deviceSize;              ///< C_SIZE - capacity of the card
+  uint8_t  deviceSizeMultiplier;    ///< C_SIZE_MULT - used only by CSD version 1.0
+  uint64_t sectorCount;             ///< Capacity of the card in 512 byte sectors
+} SD_CSD;
+/**
+ * @brief CSD structure versions
+ */
+typedef enum {
+  SD_CSD_VERSION_1 = 0, ///< SDSC cards
+  SD_CSD_VERSION_2 = 1, ///< SDHC and SDXC cards
+  SD_CSD_VERSION_3 = 2, ///< SDUC cards
+} SD_CsdVersionTypedef;
 
 static SD_CardErrorsTypedef sendCommand(uint8_t cmd, uint32_t args);
+static SD_CardErrorsTypedef sendAppCommand(uint8_t cmd, uint32_t args);
+static SD_ResponseR1 transmitCommand(uint8_t cmd, uint32_t args);
+static Boolean isCommandCrcError(SD_ResponseR1 response);
+static SD_CardErrorsTypedef checkResponse(SD_ResponseR1 response);
 static void getResponseR3orR7(uint8_t* responseBuffer);
 static SD_CardErrorsTypedef readOcr(SD_OCR* asUint32);
 static SD_CardErrorsTypedef readCid(SD_CID* cid);
 static SD_CardErrorsTypedef readCsd(SD_CSD* csd);
+static uint32_t getRegisterBits(const uint8_t* registerValue, int msb, int lsb);
+static SD_CardErrorsTypedef readBlocks(uint8_t* readDataBuffer,
+    uint32_t startSector, uint32_t sectorsToRead, uint32_t* sectorsRead);
+static SD_CardErrorsTypedef writeBlocks(uint8_t* writeDataBuffer,
+    uint32_t startSector, uint32_t sectorsToWrite, uint32_t* sectorsWritten);
+static uint8_t calculateCrc7(const uint8_t* data, int length);
+static Boolean isSectorRangeValid(uint32_t startSector, uint32_t count);
 
 #define DUMMY_BYTE 0xff ///< Dummy byte for reading data
 #define NO_ERRORS_IN_IDLE_STATE   0x01
@@ -248,7 +255,8 @@ static SD_CardErrorsTypedef readCsd(SD_CSD* csd);
 /**
  * @brief Initialize the SD card.
  * @details This function initializes both SDSC and SDHC cards.
- * It uses low-level SPI functions.
+ * It uses low-level SPI functions. CMD0 turns CRC checking of the card
+ * off, so SD_EnableCrc has to be called again after every initialization.
  */
 int SD_Initialize(void) {
 
@@ -256,8 +264,19 @@ int SD_Initialize(void) {
   uint8_t sdCommandsBuffer[BUFFER_LENGTH];
   SD_CardErrorsTypedef result;
 
-  SpiHal_initialize(SPI_HAL_SPI1);
-  SpiHal_select(SPI_HAL_SPI1);
+  if (spiDevice < 0) {
+    const SpiDeviceConfig SD_SPI_CONFIG = {
+        .spi = SPI_HAL_SPI1,
+        .chipSelect = SPI_HAL_CS_SPI1,
+        .prescaler = SD_INITIALIZATION_CLOCK,
+        .mode = SPI_HAL_MODE_0,
+    };
+    spiDevice = SpiHal_addDevice(&SD_SPI_CONFIG);
+  }
+  SpiHal_setClock(spiDevice, SD_INITIALIZATION_CLOCK);
+  if (SpiHal_acquire(spiDevice) != 0) {
+    return SD_BUS_BUSY;
+  }
 
   // Synchronize card with SPI
   const int SYNCHRONIZATION_BYTES = 20;
@@ -266,6 +285,7 @@ int SD_Initialize(void) {
   }
 
   isCardInIdleState = TRUE;
+  isCrcEnabled = FALSE; // CMD0 turns CRC checking off
 
   // send CMD0
   sendCommand(SD_GO_IDLE_STATE, 0);
@@ -278,12 +298,8 @@ int SD_Initialize(void) {
   // Check if card supports given voltage range
   if ((sdCommandsBuffer[3] != SD_IF_COND_CHECK) ||
       (sdCommandsBuffer[2] != (SD_IF_COND_VOLT>>8))) {
-    println("SEND_IF_COND error");
-    for (int i=0; i<4; i++) {
-      print("%02x ", sdCommandsBuffer[i]);
-    }
-    print("\r\n");
-
+    logWarning("SEND_IF_COND error %02x %02x %02x %02x", sdCommandsBuffer[0],
+        sdCommandsBuffer[1], sdCommandsBuffer[2], sdCommandsBuffer[3]);
   }
 
   // CMD58
@@ -295,8 +311,7 @@ int SD_Initialize(void) {
   const int SD_INITIAL_DELAY = 20;
   isCardInIdleState = FALSE;
   for (int i = 0; i < MAXIMUM_ACMD41_TRIES; i++) {
-    result = sendCommand(SD_APP_CMD, 0);
-    result = sendCommand(SD_ACMD_SEND_OP_COND, SD_ACMD41_HCS);
+    result = sendAppCommand(SD_ACMD_SEND_OP_COND, SD_ACMD41_HCS);
     // Without this delay card wouldn't initialize the first time after
     // power was connected.
     Timer_delayMillis(SD_INITIAL_DELAY);
@@ -306,7 +321,8 @@ int SD_Initialize(void) {
     }
 
     if (i == MAXIMUM_ACMD41_TRIES - 1) {
-      println("Failed to initialize SD card");
+      logError("Failed to initialize SD card");
+      SpiHal_release(spiDevice);
       return SD_INIT_FAILED;
     }
   }
@@ -314,20 +330,25 @@ int SD_Initialize(void) {
   SD_CID cid;
   readCid(&cid);
   SD_CSD csd;
-  readCsd(&csd);
+  if (readCsd(&csd) != SD_NO_ERROR) {
+    logError("Failed to read CSD");
+    SpiHal_release(spiDevice);
+    return SD_INIT_FAILED;
+  }
   // Read Card Capacity Status - SDSC or SDHC?
   readOcr(&ocr);
 
   // check capacity
   if (ocr.bits.cardCapacityStatus == TRUE) {
-    println("SDHC card connected");
+    logInfo("SDHC card connected");
     isSDHC = TRUE;
   } else {
-    println("SDSC card connected");
+    logInfo("SDSC card connected");
     isSDHC = FALSE;
   }
 
-  SpiHal_deselect(SPI_HAL_SPI1);
+  SpiHal_release(spiDevice);
+  SpiHal_setClock(spiDevice, SD_TRANSFER_CLOCK);
   isCardInitalized = TRUE;
   return SD_NO_ERROR;
 
@@ -337,7 +358,44 @@ int SD_Initialize(void) {
  * @return Card capacity in bytes.
  */
 uint64_t SD_ReadCapacity(void) {
-  return cardCapacity;
+  return cardSectorCount << SD_SECTOR_SIZE_BITS;
+}
+/**
+ * @brief Gets the number of sectors on the card.
+ * @return Card capacity in 512 byte sectors.
+ */
+uint64_t SD_ReadSectorCount(void) {
+  return cardSectorCount;
+}
+/**
+ * @brief Enables or disables CRC checking of SD transfers (CMD59).
+ *
+ * @details With CRC enabled, the CRC16 of every data block is sent
+ * to the card on writes and checked on reads. Blocks with CRC errors
+ * are transferred again (up to SD_MAX_CRC_RETRIES times).
+ *
+ * @param enable TRUE to enable CRC, FALSE to disable it
+ * @retval SD_NO_ERROR CRC mode changed
+ * @retval SD_CMD_ERROR Card rejected the command
+ */
+int SD_EnableCrc(Boolean enable) {
+
+  if (!isCardInitalized) {
+    return SD_CARD_NOT_INITALIZED;
+  }
+
+  if (SpiHal_acquire(spiDevice) != 0) {
+    return SD_BUS_BUSY;
+  }
+  SD_CardErrorsTypedef result = sendCommand(SD_CRC_ON_OFF, enable ? 1 : 0);
+  SpiHal_release(spiDevice);
+
+  if (result != SD_NO_ERROR) {
+    logError("SD_CRC_ON_OFF error");
+    return SD_CMD_ERROR;
+  }
+  isCrcEnabled = enable;
+  return SD_NO_ERROR;
 }
 /**
  * @brief Read sectors from SD card
@@ -354,31 +412,178 @@ int SD_ReadSectors(uint8_t* readDataBuffer, uint32_t startSector,
     return SD_CARD_NOT_INITALIZED;
   }
 
+  if (!isSectorRangeValid(startSector, sectorsToRead)) {
+    return SD_ADDRESS_ERROR;
+  }
+
   const int NUMBER_OF_BYTES_IN_SECTOR = 512;
-  SD_CardErrorsTypedef result;
+  int retries = 0;
+
+  while (TRUE) {
+    uint32_t sectorsRead = 0;
+    SD_CardErrorsTypedef result = readBlocks(readDataBuffer, startSector,
+        sectorsToRead, &sectorsRead);
+
+    if (result == SD_NO_ERROR) {
+      return SD_NO_ERROR;
+    }
+    if ((result != SD_CRC_ERROR) || (retries++ >= SD_MAX_CRC_RETRIES)) {
+      return SD_BLOCK_READ_ERROR;
+    }
+    // continue from the block which was corrupted
+    readDataBuffer += sectorsRead * NUMBER_OF_BYTES_IN_SECTOR;
+    startSector += sectorsRead;
+    sectorsToRead -= sectorsRead;
+    logWarning("CRC error, reading again from sector %u", (unsigned int)startSector);
+  }
+}
+/**
+ * @brief Write sectors to SD card
+ * @param buf Data buffer
+ * @param sector First sector to write
+ * @param count Number of sectors to write
+ * @retval 0 Read was successful
+ * @retval 1 Error occurred
+ */
+int SD_WriteSectors(uint8_t* writeDataBuffer, uint32_t startSector,
+    uint32_t sectorsToWrite) {
+
+  if (!isCardInitalized) {
+    return SD_CARD_NOT_INITALIZED;
+  }
+
+  if (!isSectorRangeValid(startSector, sectorsToWrite)) {
+    return SD_ADDRESS_ERROR;
+  }
+
+  const int NUMBER_OF_BYTES_IN_SECTOR = 512;
+  int retries = 0;
+
+  while (TRUE) {
+    uint32_t sectorsWritten = 0;
+    SD_CardErrorsTypedef result = writeBlocks(writeDataBuffer, startSector,
+        sectorsToWrite, &sectorsWritten);
+
+    if (result == SD_NO_ERROR) {
+      return SD_NO_ERROR;
+    }
+    if ((result != SD_CRC_ERROR) || (retries++ >= SD_MAX_CRC_RETRIES)) {
+      return SD_BLOCK_WRITE_ERROR;
+    }
+    // continue from the block which was rejected
+    writeDataBuffer += sectorsWritten * NUMBER_OF_BYTES_IN_SECTOR;
+    startSector += sectorsWritten;
+    sectorsToWrite -= sectorsWritten;
+    logWarning("CRC error, writing again from sector %u", (unsigned int)startSector);
+  }
+}
+/**
+ * @brief Erase sectors on SD card
+ *
+ * @details Tells the card that the given sectors no longer hold
+ * valid data (CMD32, CMD33, CMD38), so the card can reclaim them
+ * in the background instead of during later writes.
+ *
+ * @param startSector First sector to erase
+ * @param sectorsToErase Number of sectors to erase
+ * @retval SD_NO_ERROR Erase was successful
+ * @retval SD_ERASE_ERROR Error occurred
+ */
+int SD_EraseSectors(uint32_t startSector, uint32_t sectorsToErase) {
+
+  if (!isCardInitalized) {
+    return SD_CARD_NOT_INITALIZED;
+  }
+
+  if (!isSectorRangeValid(startSector, sectorsToErase)) {
+    return SD_ADDRESS_ERROR;
+  }
+
+  if (sectorsToErase == 0) {
+    return SD_NO_ERROR;
+  }
+
+  const int NUMBER_OF_BYTES_IN_SECTOR = 512;
+  const unsigned int ERASE_TIMEOUT_MILLIS = 5000;
+  uint32_t endSector = startSector + sectorsToErase - 1;
 
   // SDSC cards use byte addressing, SDHC use block addressing
   if (!isSDHC) {
     startSector *= NUMBER_OF_BYTES_IN_SECTOR;
+    endSector *= NUMBER_OF_BYTES_IN_SECTOR;
   }
 
-  SpiHal_select(SPI_HAL_SPI1);
+  if (SpiHal_acquire(spiDevice) != 0) {
+    return SD_BUS_BUSY;
+  }
 
-  result = sendCommand(SD_READ_MULTIPLE_BLOCK, startSector);
+  if ((sendCommand(SD_ERASE_WR_BLK_START_ADDR, startSector) != SD_NO_ERROR) ||
+      (sendCommand(SD_ERASE_WR_BLK_END_ADDR, endSector) != SD_NO_ERROR) ||
+      (sendCommand(SD_ERASE, 0) != SD_NO_ERROR)) {
+    logError("SD_ERASE error");
+    SpiHal_release(spiDevice);
+    return SD_ERASE_ERROR;
+  }
 
-  if (result != SD_NO_ERROR) {
-    println("SD_READ_MULTIPLE_BLOCK error");
-    SpiHal_deselect(SPI_HAL_SPI1);
+  // R1b response - erasing may take a while, so don't wait forever
+  unsigned int startTimeMillis = Timer_getTimeMillis();
+  while(!SpiHal_transmitByte(SPI_HAL_SPI1, DUMMY_BYTE)) {
+    if (Timer_delayTimer(ERASE_TIMEOUT_MILLIS, startTimeMillis)) {
+      logError("SD_ERASE timeout");
+      SpiHal_release(spiDevice);
+      return SD_ERASE_ERROR;
+    }
+  }
+
+  SpiHal_release(spiDevice);
+
+  return SD_NO_ERROR;
+}
+/**
+ * @brief Reads blocks with a single READ_MULTIPLE_BLOCK command.
+ * @param readDataBuffer Data buffer
+ * @param startSector Start sector
+ * @param sectorsToRead Number of sectors to read
+ * @param sectorsRead Number of sectors read correctly (function writes this)
+ * @retval SD_NO_ERROR All blocks were read
+ * @retval SD_CRC_ERROR Block sectorsRead had an invalid CRC
+ * @retval SD_BLOCK_READ_ERROR Card rejected the command
+ */
+SD_CardErrorsTypedef readBlocks(uint8_t* readDataBuffer, uint32_t startSector,
+    uint32_t sectorsToRead, uint32_t* sectorsRead) {
+
+  const int NUMBER_OF_BYTES_IN_SECTOR = 512;
+  SD_CardErrorsTypedef result = SD_NO_ERROR;
+
+  // SDSC cards use byte addressing, SDHC use block addressing
+  if (!isSDHC) {
+    startSector *= NUMBER_OF_BYTES_IN_SECTOR;
+  }
+
+  if (SpiHal_acquire(spiDevice) != 0) {
+    return SD_BUS_BUSY;
+  }
+
+  if (sendCommand(SD_READ_MULTIPLE_BLOCK, startSector) != SD_NO_ERROR) {
+    logError("SD_READ_MULTIPLE_BLOCK error");
+    SpiHal_release(spiDevice);
     return SD_BLOCK_READ_ERROR;
   }
 
-  while (sectorsToRead) {
+  while (*sectorsRead < sectorsToRead) {
     // wait for data token
     while (SpiHal_transmitByte(SPI_HAL_SPI1, DUMMY_BYTE) != SD_TOKEN_SBR_MBR_SBW);
     SpiHal_readBuffer(SPI_HAL_SPI1, readDataBuffer, NUMBER_OF_BYTES_IN_SECTOR);
-    SpiHal_transmitByte(SPI_HAL_SPI1, DUMMY_BYTE);
-    SpiHal_transmitByte(SPI_HAL_SPI1, DUMMY_BYTE); // two bytes CRC
-    sectorsToRead--;
+    // two bytes CRC, MSB first
+    uint16_t receivedCrc = SpiHal_transmitByte(SPI_HAL_SPI1, DUMMY_BYTE) << 8;
+    receivedCrc |= SpiHal_transmitByte(SPI_HAL_SPI1, DUMMY_BYTE);
+
+    if (isCrcEnabled && (receivedCrc !=
+        Utils_crc16(0, readDataBuffer, NUMBER_OF_BYTES_IN_SECTOR))) {
+      result = SD_CRC_ERROR;
+      break;
+    }
+    (*sectorsRead)++;
     readDataBuffer += NUMBER_OF_BYTES_IN_SECTOR; // move buffer pointer forward
   }
 
@@ -387,64 +592,76 @@ int SD_ReadSectors(uint8_t* readDataBuffer, uint32_t startSector,
   // R1b response - check busy flag
   while(!SpiHal_transmitByte(SPI_HAL_SPI1, DUMMY_BYTE));
 
-  SpiHal_deselect(SPI_HAL_SPI1);
+  SpiHal_release(spiDevice);
 
-  return SD_NO_ERROR;
+  return result;
 }
 /**
- * @brief Write sectors to SD card
- * @param buf Data buffer
- * @param sector First sector to write
- * @param count Number of sectors to write
- * @retval 0 Read was successful
- * @retval 1 Error occurred
+ * @brief Writes blocks with a single WRITE_MULTIPLE_BLOCK command.
+ * @param writeDataBuffer Data buffer
+ * @param startSector First sector to write
+ * @param sectorsToWrite Number of sectors to write
+ * @param sectorsWritten Number of sectors accepted by the card (function writes this)
+ * @retval SD_NO_ERROR All blocks were written
+ * @retval SD_CRC_ERROR Card rejected block sectorsWritten due to invalid CRC
+ * @retval SD_BLOCK_WRITE_ERROR Write error occurred
  */
-int SD_WriteSectors(uint8_t* writeDataBuffer, uint32_t startSector,
-    uint32_t sectorsToWrite) {
-
-  if (!isCardInitalized) {
-    return SD_CARD_NOT_INITALIZED;
-  }
+SD_CardErrorsTypedef writeBlocks(uint8_t* writeDataBuffer, uint32_t startSector,
+    uint32_t sectorsToWrite, uint32_t* sectorsWritten) {
 
   const int NUMBER_OF_BYTES_IN_SECTOR = 512;
-  const uint8_t START_BLOCK_TOKEN = 0xfc;
-  const uint8_t STOP_TRANSMISSION_TOKEN = 0xfd;
-  SD_CardErrorsTypedef result;
+  SD_CardErrorsTypedef result = SD_NO_ERROR;
 
   // SDSC cards use byte addressing, SDHC use block addressing
   if (!isSDHC) {
     startSector *= NUMBER_OF_BYTES_IN_SECTOR;
   }
 
-  SpiHal_select(SPI_HAL_SPI1);
-
-  result = sendCommand(SD_WRITE_MULTIPLE_BLOCK, startSector);
+  if (SpiHal_acquire(spiDevice) != 0) {
+    return SD_BUS_BUSY;
+  }
 
-  if (result != SD_NO_ERROR) {
-    println("SD_WRITE_MULTIPLE_BLOCK error");
-    SpiHal_deselect(SPI_HAL_SPI1);
+  if (sendCommand(SD_WRITE_MULTIPLE_BLOCK, startSector) != SD_NO_ERROR) {
+    logError("SD_WRITE_MULTIPLE_BLOCK error");
+    SpiHal_release(spiDevice);
     return SD_BLOCK_WRITE_ERROR;
   }
 
-  while (sectorsToWrite) {
-    SpiHal_transmitByte(SPI_HAL_SPI1, START_BLOCK_TOKEN);
+  while (*sectorsWritten < sectorsToWrite) {
+    uint16_t crc = 0xffff; // CRC is ignored by the card when CRC is disabled
+    if (isCrcEnabled) {
+      crc = Utils_crc16(0, writeDataBuffer, NUMBER_OF_BYTES_IN_SECTOR);
+    }
+    SpiHal_transmitByte(SPI_HAL_SPI1, SD_TOKEN_MBW_START);
     SpiHal_sendBuffer(SPI_HAL_SPI1, writeDataBuffer, NUMBER_OF_BYTES_IN_SECTOR);
-    SpiHal_transmitByte(SPI_HAL_SPI1, DUMMY_BYTE);
-    SpiHal_transmitByte(SPI_HAL_SPI1, DUMMY_BYTE); // two bytes CRC
-    sectorsToWrite--;
-    writeDataBuffer += NUMBER_OF_BYTES_IN_SECTOR; // move buffer pointer forward
+    SpiHal_transmitByte(SPI_HAL_SPI1, crc >> 8);
+    SpiHal_transmitByte(SPI_HAL_SPI1, crc); // two bytes CRC
     // data response
-    SpiHal_transmitByte(SPI_HAL_SPI1, DUMMY_BYTE);
+    uint8_t dataResponse = SpiHal_transmitByte(SPI_HAL_SPI1, DUMMY_BYTE) &
+        SD_DATA_RESPONSE_MASK;
     while(!SpiHal_transmitByte(SPI_HAL_SPI1, DUMMY_BYTE)); // wait while card is busy
+
+    if (dataResponse != SD_TOKEN_DATA_ACCEPTED) {
+      result = (dataResponse == SD_TOKEN_DATA_CRC) ?
+          SD_CRC_ERROR : SD_BLOCK_WRITE_ERROR;
+      break;
+    }
+    (*sectorsWritten)++;
+    writeDataBuffer += NUMBER_OF_BYTES_IN_SECTOR; // move buffer pointer forward
   }
 
-  SpiHal_transmitByte(SPI_HAL_SPI1, STOP_TRANSMISSION_TOKEN); // stop transmission token
-  SpiHal_transmitByte(SPI_HAL_SPI1, DUMMY_BYTE);
+  if (result == SD_NO_ERROR) {
+    SpiHal_transmitByte(SPI_HAL_SPI1, SD_TOKEN_MBW_STOP); // stop transmission token
+    SpiHal_transmitByte(SPI_HAL_SPI1, DUMMY_BYTE);
+  } else {
+    // rejected block - stop transmission with a command
+    sendCommand(SD_STOP_TRANSMISSION, 0);
+  }
   while(!SpiHal_transmitByte(SPI_HAL_SPI1, DUMMY_BYTE)); // wait while card is busy
 
-  SpiHal_deselect(SPI_HAL_SPI1);
+  SpiHal_release(spiDevice);
 
-  return SD_NO_ERROR;
+  return result;
 }
 /**
  * @brief Reads OCR register
@@ -512,52 +729,123 @@ SD_CardErrorsTypedef readCid(SD_CID* cid) {
 /**
  * @brief Read CSD register of SD card
  *
- * @details This function also sets the cardCapacity
- * variable holding the capacity of the card in bytes.
+ * @details This function also sets the cardSectorCount
+ * variable holding the capacity of the card in sectors.
  *
  * @param csd Structure for filling CSD register.
+ * @retval SD_NO_ERROR Register read and decoded
+ * @retval SD_CRC_ERROR Register was corrupted
+ * @retval SD_RESPONSE_ERROR Unknown CSD structure version
  */
 SD_CardErrorsTypedef readCsd(SD_CSD* csd) {
-  const int CSD_LENGTH = 16;
-  const int CSD_LENGTH_WORDS = 4;
-  const int BLOCK_SIZE = 512 * 1024;
-  uint8_t csdBuffer[CSD_LENGTH];
 
   sendCommand(SD_SEND_CSD, 0);
 
-  // Read CID implemented as read block
+  // Read CSD implemented as read block
   // So do the same as for read block
   // wait for data token
   while (SpiHal_transmitByte(SPI_HAL_SPI1, DUMMY_BYTE) != SD_TOKEN_SBR_MBR_SBW);
-  SpiHal_readBuffer(SPI_HAL_SPI1, csdBuffer, CSD_LENGTH);
-  SpiHal_transmitByte(SPI_HAL_SPI1, DUMMY_BYTE);
-  SpiHal_transmitByte(SPI_HAL_SPI1, DUMMY_BYTE); // two bytes CRC
+  SpiHal_readBuffer(SPI_HAL_SPI1, csd->raw, SD_REGISTER_LENGTH);
+  uint16_t receivedCrc = SpiHal_transmitByte(SPI_HAL_SPI1, DUMMY_BYTE) << 8;
+  receivedCrc |= SpiHal_transmitByte(SPI_HAL_SPI1, DUMMY_BYTE);
 
-  uint32_t* ptr = (uint32_t*)csd;
-  uint32_t* ptrBuf = (uint32_t*)csdBuffer;
+  // R1b response - check busy flag
+  while(!SpiHal_transmitByte(SPI_HAL_SPI1, DUMMY_BYTE));
 
-  for (int i = 0; i < CSD_LENGTH_WORDS; i++) {
-    ptr[i] = Utils_convertUnsignedIntToHostEndianness(ptrBuf[3-i]);
+  // the capacity depends on this register, so always check it
+  if (receivedCrc != Utils_crc16(0, csd->raw, SD_REGISTER_LENGTH)) {
+    logError("CSD CRC error");
+    return SD_CRC_ERROR;
   }
 
-//  UTILS_HexdumpWithCharacters(csdBuffer, CSD_LENGTH);
+  csd->csdType = getRegisterBits(csd->raw, 127, 126);
+  csd->readBlockLength = getRegisterBits(csd->raw, 83, 80);
+  csd->deviceSizeMultiplier = 0;
+
+  switch (csd->csdType) {
+  case SD_CSD_VERSION_1:
+    // capacity = (C_SIZE + 1) * 2^(C_SIZE_MULT + 2) * 2^READ_BL_LEN
+    csd->deviceSize = getRegisterBits(csd->raw, 73, 62);
+    csd->deviceSizeMultiplier = getRegisterBits(csd->raw, 49, 47);
+    csd->sectorCount = ((uint64_t)(csd->deviceSize + 1) <<
+        (csd->deviceSizeMultiplier + 2 + csd->readBlockLength)) >>
+        SD_SECTOR_SIZE_BITS;
+    break;
+  case SD_CSD_VERSION_2:
+    // capacity = (C_SIZE + 1) * 512K
+    csd->deviceSize = getRegisterBits(csd->raw, 69, 48);
+    csd->sectorCount = (uint64_t)(csd->deviceSize + 1) * 1024;
+    break;
+  case SD_CSD_VERSION_3:
+    // same as version 2, C_SIZE is 28 bits long
+    csd->deviceSize = getRegisterBits(csd->raw, 75, 48);
+    csd->sectorCount = (uint64_t)(csd->deviceSize + 1) * 1024;
+    break;
+  default:
+    logError("Unknown CSD type: 0x%02x", (unsigned int) csd->csdType);
+    return SD_RESPONSE_ERROR;
+  }
 
   println("CSD type: 0x%02x", (unsigned int) csd->csdType);
   println("CSD device size: %u", (unsigned int) csd->deviceSize);
 
-  // size counted in blocks of 512K
-  cardCapacity = csd->deviceSize * BLOCK_SIZE;
-  println("Card capacity: %u", (unsigned int)cardCapacity);
+  cardSectorCount = csd->sectorCount;
+  // print in MB, capacity in bytes may not fit 32 bits
+  logInfo("Card capacity: %u MB", (unsigned int)(cardSectorCount >>
+      (20 - SD_SECTOR_SIZE_BITS)));
 
-  // R1b response - check busy flag
-  while(!SpiHal_transmitByte(SPI_HAL_SPI1, DUMMY_BYTE));
   return SD_NO_ERROR;
 }
+/**
+ * @brief Gets a bit field of a 128 bit card register.
+ * @details Registers are sent MSB first, so bit 127 is the
+ * most significant bit of the first byte.
+ * @param registerValue Register bytes
+ * @param msb Most significant bit of field
+ * @param lsb Least significant bit of field
+ * @return Value of field
+ */
+uint32_t getRegisterBits(const uint8_t* registerValue, int msb, int lsb) {
+  const int REGISTER_BITS = SD_REGISTER_LENGTH * NUMBER_OF_BITS_IN_BYTE;
+  uint32_t value = 0;
+  for (int bit = msb; bit >= lsb; bit--) {
+    int byteIndex = (REGISTER_BITS - 1 - bit) / NUMBER_OF_BITS_IN_BYTE;
+    value = (value << 1) |
+        ((registerValue[byteIndex] >> (bit % NUMBER_OF_BITS_IN_BYTE)) & 0x01);
+  }
+  return value;
+}
+/**
+ * @brief Checks if sectors are on the card.
+ * @details Command arguments are 32 bit long, so SDSC cards
+ * (byte addressing) must also have the byte address in range.
+ * @param startSector First sector
+ * @param count Number of sectors
+ * @retval TRUE All sectors are on the card
+ * @retval FALSE Range exceeds card capacity
+ */
+Boolean isSectorRangeValid(uint32_t startSector, uint32_t count) {
+  const uint64_t MAX_BYTE_ADDRESS = 0xffffffff;
+  uint64_t endSector = (uint64_t)startSector + count;
+
+  if (endSector > cardSectorCount) {
+    logError("Sectors %u-%u out of range", (unsigned int)startSector,
+        (unsigned int)(endSector - 1));
+    return FALSE;
+  }
+  if (!isSDHC && ((endSector << SD_SECTOR_SIZE_BITS) > MAX_BYTE_ADDRESS + 1)) {
+    return FALSE;
+  }
+  return TRUE;
+}
 /**
  * @brief Sends a command to the SD card.
  *
  * @details This function works for commands which return 1 byte
  * response - R1 response token. These commands are in the majority.
+ * Every command is sent with a valid CRC7, so the command is also
+ * accepted after CRC checking is turned on with CMD59. If the card
+ * reports a command CRC error, the command is sent again.
  *
  * @param cmd Command to send
  * @param args Command arguments: 4 bytes as a 32-bit number
@@ -565,32 +853,93 @@ SD_CardErrorsTypedef readCsd(SD_CSD* csd) {
  */
 SD_CardErrorsTypedef sendCommand(uint8_t cmd, uint32_t args) {
 
-  SpiHal_transmitByte(SPI_HAL_SPI1, 0x40 | cmd);
-  SpiHal_transmitByte(SPI_HAL_SPI1, args >> 24); // MSB first
-  SpiHal_transmitByte(SPI_HAL_SPI1, args >> 16);
-  SpiHal_transmitByte(SPI_HAL_SPI1, args >> 8);
-  SpiHal_transmitByte(SPI_HAL_SPI1, args);
+  SD_ResponseR1 commandResponse;
 
-  // CRC is irrelevant while using SPI interface - only checked for some commands.
-  switch (cmd) {
-  case SD_GO_IDLE_STATE:
-    SpiHal_transmitByte(SPI_HAL_SPI1, 0x95);
-    break;
-  case SD_SEND_IF_COND:
-    SpiHal_transmitByte(SPI_HAL_SPI1, 0x87);
-    break;
-  default:
-    SpiHal_transmitByte(SPI_HAL_SPI1, DUMMY_BYTE);
+  for (int i = 0; i <= SD_MAX_CRC_RETRIES; i++) {
+    commandResponse = transmitCommand(cmd, args);
+    if (!isCommandCrcError(commandResponse)) {
+      break;
+    }
+  }
+
+  return checkResponse(commandResponse);
+}
+/**
+ * @brief Sends an application specific command (ACMD) to the SD card.
+ * @details The card treats a command as ACMD only right after APP_CMD
+ * (CMD55), so after a command CRC error both commands are sent again.
+ * @param cmd ACMD to send
+ * @param args Command arguments: 4 bytes as a 32-bit number
+ * @return Returns R1 response token of ACMD
+ */
+SD_CardErrorsTypedef sendAppCommand(uint8_t cmd, uint32_t args) {
+
+  SD_ResponseR1 commandResponse;
+
+  for (int i = 0; i <= SD_MAX_CRC_RETRIES; i++) {
+    commandResponse = transmitCommand(SD_APP_CMD, 0);
+    if (isCommandCrcError(commandResponse)) {
+      continue;
+    }
+    commandResponse = transmitCommand(cmd, args);
+    if (!isCommandCrcError(commandResponse)) {
+      break;
+    }
   }
+
+  return checkResponse(commandResponse);
+}
+/**
+ * @brief Sends a command once and reads its R1 response token.
+ * @param cmd Command to send
+ * @param args Command arguments: 4 bytes as a 32-bit number
+ * @return R1 response token
+ */
+SD_ResponseR1 transmitCommand(uint8_t cmd, uint32_t args) {
+
+  const int COMMAND_LENGTH = 5;
+  uint8_t command[COMMAND_LENGTH];
+  SD_ResponseR1 commandResponse;
+
+  command[0] = 0x40 | cmd;
+  command[1] = args >> 24; // MSB first
+  command[2] = args >> 16;
+  command[3] = args >> 8;
+  command[4] = args;
+
+  SpiHal_sendBuffer(SPI_HAL_SPI1, command, COMMAND_LENGTH);
+  SpiHal_transmitByte(SPI_HAL_SPI1, calculateCrc7(command, COMMAND_LENGTH));
+
   // Practice has shown that a valid response token
   // is sent as the second byte by the card.
   // So, we send a dummy byte first.
   SpiHal_transmitByte(SPI_HAL_SPI1, DUMMY_BYTE);
-  SD_ResponseR1 commandResponse;
   commandResponse.asUint8 = SpiHal_transmitByte(SPI_HAL_SPI1, DUMMY_BYTE);
-//  println("Response to cmd %d is %02x", cmd, commandResponse.asUint8);
+//    println("Response to cmd %d is %02x", cmd, commandResponse.asUint8);
+
+  return commandResponse;
+}
+/**
+ * @brief Checks if the card rejected a command because of its CRC.
+ * @details Only a valid response token (start bit cleared) is checked,
+ * so a missing response (0xff) isn't taken for a CRC error.
+ * @param response R1 response token
+ * @retval TRUE Command should be sent again
+ * @retval FALSE Command wasn't rejected because of CRC
+ */
+Boolean isCommandCrcError(SD_ResponseR1 response) {
+  const uint8_t RESPONSE_START_BIT = 0x80;
+  return ((response.asUint8 & RESPONSE_START_BIT) == 0) &&
+      response.flags.commErrorCRC;
+}
+/**
+ * @brief Checks R1 response token for errors.
+ * @param response R1 response token
+ * @retval SD_NO_ERROR No errors
+ * @retval SD_RESPONSE_ERROR Error bits set or wrong IDLE state
+ */
+SD_CardErrorsTypedef checkResponse(SD_ResponseR1 response) {
 
-  // Check response errors
   uint8_t okResponse;
   if (isCardInIdleState) {
     okResponse = NO_ERRORS_IN_IDLE_STATE;
@@ -598,13 +947,26 @@ SD_CardErrorsTypedef sendCommand(uint8_t cmd, uint32_t args) {
     okResponse = NO_ERRORS_LEFT_IDLE_STATE;
   }
 
-  if (commandResponse.asUint8 != okResponse) {
-//    println("Commands %d error", cmd);
+  if (response.asUint8 != okResponse) {
     return SD_RESPONSE_ERROR;
   }
 
   return SD_NO_ERROR;
 }
+/**
+ * @brief Calculates CRC7 of an SD command.
+ * @param data Command bytes
+ * @param length Number of command bytes
+ * @return Last byte of command: CRC7 followed by end bit
+ */
+uint8_t calculateCrc7(const uint8_t* data, int length) {
+  const uint8_t END_BIT = 0x01;
+  uint8_t crc = 0;
+  while (length--) {
+    crc = crc7Table[crc ^ *data++];
+  }
+  return crc | END_BIT;
+}
 /**
  * @brief Get R3 or R7 response from card
  * @details R3 response is for READ_OCR command (it is actually five bytes R1
@@ -18,6 +18,7 @@
 #ifndef SDCARD_H_
 #define SDCARD_H_
 
+#include "utils.h"
 #include <inttypes.h>
 
 /**
@@ -38,12 +39,19 @@ typedef enum {
   SD_BLOCK_READ_ERROR,
   SD_BLOCK_WRITE_ERROR,
   SD_CARD_NOT_INITALIZED,
+  SD_ERASE_ERROR,
+  SD_CRC_ERROR,
+  SD_ADDRESS_ERROR,
+  SD_BUS_BUSY,
 } SD_CardErrorsTypedef;
 
 int SD_Initialize   (void);
 int SD_ReadSectors  (uint8_t* buf, uint32_t sector, uint32_t count);
 int SD_WriteSectors (uint8_t* buf, uint32_t sector, uint32_t count);
+int SD_EraseSectors (uint32_t sector, uint32_t count);
+int SD_EnableCrc    (Boolean enable);
 uint64_t SD_ReadCapacity(void);
+uint64_t SD_ReadSectorCount(void);
 
 /**
  * @}
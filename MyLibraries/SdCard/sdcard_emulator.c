@@ -0,0 +1,876 @@
+/**
+ * @file    sdcard_emulator.c
+ * @brief   Host side SD card emulator behind the SPI HAL.
+ * @date    18.10.2026
+ * @author  Michal Ksiezopolski
+ *
+ * @verbatim
+ * Copyright (c) 2026 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifdef USE_SD_EMULATOR
+
+#include "sdcard_emulator.h"
+#include "spi_hal.h"
+#include "timers.h"
+#include "utils.h"
+#include <stdio.h>
+#include <string.h>
+#include <sys/types.h>
+
+/**
+ * @addtogroup SD_EMULATOR
+ * @{
+ */
+
+#define SECTOR_SIZE           512   ///< Size of data block
+#define CRC_SIZE              2     ///< Size of data block CRC
+#define REGISTER_SIZE         16    ///< Size of CSD and CID registers
+#define COMMAND_LENGTH        6     ///< Command with arguments and CRC
+#define RESPONSE_QUEUE_LENGTH 32    ///< Maximum length of queued response
+#define DUMMY_BYTE            0xff  ///< Byte sent by card when it has nothing to send
+#define BUSY_BYTE             0x00  ///< Byte sent by card when it is busy
+#define NANOSECONDS_IN_SECOND 1000000000ULL
+
+#define R1_IN_IDLE_STATE      0x01
+#define R1_COMMAND_CRC_ERROR  0x08
+#define R1_ILLEGAL_COMMAND    0x04
+#define R1_PARAMETER_ERROR    0x40
+
+#define TOKEN_SINGLE_BLOCK    0xfe  ///< Start token for read and single block write
+#define TOKEN_MULTIPLE_WRITE  0xfc  ///< Start token for multiple block write
+#define TOKEN_STOP_WRITE      0xfd  ///< Stop token for multiple block write
+#define DATA_RESPONSE_PREFIX  0xe0  ///< Undefined bits of data response token
+#define DATA_ACCEPTED         0x05
+#define DATA_CRC_ERROR        0x0b
+#define DATA_WRITE_ERROR      0x0d
+
+#define OCR_POWER_UP_STATUS   0x80000000
+#define OCR_CAPACITY_STATUS   0x40000000
+#define OCR_VOLTAGE_WINDOW    0x00ff8000
+
+/**
+ * @brief State of the data lines of the card
+ */
+typedef enum {
+  CARD_STATE_COMMANDS,      ///< Waiting for commands
+  CARD_STATE_READ_BLOCKS,   ///< Sending data blocks to host
+  CARD_STATE_WRITE_BLOCKS,  ///< Waiting for data tokens from host
+  CARD_STATE_RECEIVE_BLOCK, ///< Receiving a data block from host
+} CardState;
+
+static FILE* image;                     ///< Image file with card contents
+static uint32_t sectorCount;            ///< Number of sectors in image
+static SdEmulatorConfig configuration;  ///< Emulator configuration
+static SdEmulatorStatistics statistics; ///< Emulator statistics
+static uint64_t timeNanos;              ///< Emulated time
+static uint64_t busTimeNanos;           ///< Emulated time spent transferring bytes
+
+static SpiDeviceConfig devices[SPI_HAL_MAX_DEVICES]; ///< Registered SPI devices
+static int numberOfDevices;             ///< Number of registered SPI devices
+static Boolean isBusTaken;              ///< Is SPI bus acquired
+
+static CardState state;                 ///< State of the card
+static Boolean isSelected;              ///< Is card selected by chip select
+static Boolean isInIdleState;           ///< Is card in IDLE state
+static Boolean isAppCommand;            ///< Next command is ACMD
+static Boolean isCrcEnabled;            ///< Is CRC checking enabled (CMD59)
+static int initializationCount;         ///< Number of received ACMD41
+
+static uint8_t command[COMMAND_LENGTH]; ///< Currently received command
+static int commandIndex;                ///< Number of received command bytes
+
+static uint8_t responseQueue[RESPONSE_QUEUE_LENGTH]; ///< Bytes to send
+static int responseHead;                ///< Next byte to send from queue
+static int responseCount;               ///< Number of bytes in queue
+static int busyBytes;                   ///< Busy bytes to send after queue
+
+static uint8_t block[SECTOR_SIZE + CRC_SIZE]; ///< Block being sent or received
+static int blockLength;                 ///< Length of block without CRC
+static int blockIndex;                  ///< Current byte in block
+static int readLatency;                 ///< Bytes left before data token
+static Boolean isTokenSent;             ///< Was data token of current block sent
+static Boolean isMultipleTransfer;      ///< Is it a multiple block transfer
+static uint32_t currentSector;          ///< Sector being transferred
+static uint32_t eraseStartSector;       ///< First sector to erase
+static uint32_t eraseEndSector;         ///< Last sector to erase
+
+static uint8_t cid[REGISTER_SIZE];      ///< Card identification register
+static uint8_t csd[REGISTER_SIZE];      ///< Card specific data register
+
+static uint8_t transferByte(uint8_t receivedByte);
+static uint8_t nextOutputByte(void);
+static void    receiveCommandByte(uint8_t receivedByte);
+static void    receiveBlockByte(uint8_t receivedByte);
+static void    executeCommand(void);
+static void    queueByte(uint8_t data);
+static void    queueResponseR1(uint8_t response);
+static void    startReadBlock(void);
+static void    startReadRegister(const uint8_t* registerValue);
+static Boolean readImageSector(uint32_t sector, uint8_t* buffer);
+static Boolean writeImageSector(uint32_t sector, const uint8_t* buffer);
+static uint32_t convertAddressToSector(uint32_t address);
+static void    buildRegisters(void);
+static void    setRegisterBits(uint8_t* registerValue, int msb, int lsb, uint32_t value);
+static uint8_t calculateCrc7(const uint8_t* data, int length);
+static void    advanceTime(uint64_t nanos);
+
+/**
+ * @brief Fills configuration structure with default values.
+ * @details The defaults emulate a well behaved SDHC card.
+ * @param config Configuration to fill
+ */
+void SdEmulator_getDefaultConfig(SdEmulatorConfig* config) {
+  memset(config, 0, sizeof(SdEmulatorConfig));
+  config->isSDHC              = TRUE;
+  config->initializationTries = 2;
+  config->commandLatency      = 1;
+  config->readLatency         = 4;
+  config->writeBusyBytes      = 16;
+  config->eraseBusyBytes      = 64;
+  config->spiClockHz          = 25000000;
+}
+/**
+ * @brief Initializes the emulator with a card image.
+ * @param imagePath Path of image file. Its size has to be a multiple of 512 bytes.
+ * @param config Emulator configuration or NULL for default values
+ * @retval 0 Emulator initialized
+ * @retval -1 Image could not be opened
+ */
+int SdEmulator_initialize(const char* imagePath, const SdEmulatorConfig* config) {
+
+  if (config != NULL) {
+    configuration = *config;
+  } else {
+    SdEmulator_getDefaultConfig(&configuration);
+  }
+
+  SdEmulator_close();
+  image = fopen(imagePath, "r+b");
+  if (image == NULL) {
+    return -1;
+  }
+  fseeko(image, 0, SEEK_END);
+  sectorCount = (uint32_t)(ftello(image) / SECTOR_SIZE);
+
+  state = CARD_STATE_COMMANDS;
+  isSelected = FALSE;
+  isBusTaken = FALSE;
+  isInIdleState = TRUE;
+  isAppCommand = FALSE;
+  isCrcEnabled = FALSE;
+  initializationCount = 0;
+  commandIndex = 0;
+  responseCount = 0;
+  busyBytes = 0;
+
+  buildRegisters();
+  SdEmulator_resetStatistics();
+  return 0;
+}
+/**
+ * @brief Closes the card image.
+ */
+void SdEmulator_close(void) {
+  if (image != NULL) {
+    fclose(image);
+    image = NULL;
+  }
+}
+/**
+ * @brief Gets the configuration of the emulator.
+ * @details The configuration can be changed while the emulator runs,
+ * e.g. to inject errors before an operation.
+ * @return Pointer to current configuration
+ */
+SdEmulatorConfig* SdEmulator_getConfig(void) {
+  return &configuration;
+}
+/**
+ * @brief Gets the emulator statistics.
+ * @param stats Structure to fill
+ */
+void SdEmulator_getStatistics(SdEmulatorStatistics* stats) {
+  statistics.busTimeMicros = busTimeNanos / 1000;
+  *stats = statistics;
+}
+/**
+ * @brief Zeroes out the emulator statistics.
+ */
+void SdEmulator_resetStatistics(void) {
+  memset(&statistics, 0, sizeof(SdEmulatorStatistics));
+  busTimeNanos = 0;
+}
+/**
+ * @brief Prints statistics gathered since the last reset.
+ * @param operation Name of the measured operation
+ */
+void SdEmulator_printStatistics(const char* operation) {
+
+  SdEmulatorStatistics stats;
+  SdEmulator_getStatistics(&stats);
+
+  printf("SDEMU--> %s: %lu bytes, %lu blocks read, %lu blocks written, "
+      "%lu sectors erased, %lu CRC errors, %llu us on bus\r\n", operation,
+      stats.bytesTransferred, stats.blocksRead, stats.blocksWritten,
+      stats.sectorsErased, stats.crcErrors,
+      (unsigned long long)stats.busTimeMicros);
+
+  for (int i = 0; i < SD_EMULATOR_MAX_COMMANDS; i++) {
+    if (stats.commands[i]) {
+      printf("SDEMU-->   CMD%d: %lu\r\n", i, stats.commands[i]);
+    }
+    if (stats.appCommands[i]) {
+      printf("SDEMU-->   ACMD%d: %lu\r\n", i, stats.appCommands[i]);
+    }
+  }
+}
+// ********************** SPI HAL interface **********************
+/**
+ * @brief Initialize SPI (nothing to do for emulator).
+ */
+void SpiHal_initialize(SpiNumber spi) {
+  (void)spi;
+}
+/**
+ * @brief Registers a device on the emulated bus.
+ * @details Only the device on SPI_HAL_CS_SPI1 is connected to the card.
+ * @param config Configuration of the device
+ * @return Device ID or -1 if there is no space for new devices
+ */
+int SpiHal_addDevice(const SpiDeviceConfig* config) {
+  if (numberOfDevices >= SPI_HAL_MAX_DEVICES) {
+    return -1;
+  }
+  devices[numberOfDevices] = *config;
+  return numberOfDevices++;
+}
+/**
+ * @brief Changes the clock of a device.
+ * @details The emulator uses spiClockHz from its configuration.
+ */
+void SpiHal_setClock(int device, SpiClockPrescaler prescaler) {
+  if (device >= 0 && device < numberOfDevices) {
+    devices[device].prescaler = prescaler;
+  }
+}
+/**
+ * @brief Takes the bus and selects the device.
+ * @param device Device ID
+ * @retval 0 Bus acquired
+ * @retval -1 Bus is taken or invalid device
+ */
+int SpiHal_acquire(int device) {
+  if (device < 0 || device >= numberOfDevices || isBusTaken) {
+    return -1;
+  }
+  isBusTaken = TRUE;
+  isSelected = (devices[device].chipSelect == SPI_HAL_CS_SPI1);
+  return 0;
+}
+/**
+ * @brief Deselects the device and frees the bus.
+ * @param device Device ID
+ */
+void SpiHal_release(int device) {
+  (void)device;
+  isSelected = FALSE;
+  isBusTaken = FALSE;
+}
+/**
+ * @brief Runs a transaction immediately.
+ * @details There are no interrupts on the host, so the bus
+ * is never taken when a transaction is submitted.
+ * @param transaction Transaction to run
+ */
+void SpiHal_submit(SpiTransaction* transaction) {
+
+  if (SpiHal_acquire(transaction->device) != 0) {
+    return;
+  }
+  SpiNumber spi = devices[transaction->device].spi;
+  for (int i = 0; i < transaction->commandLength; i++) {
+    SpiHal_transmitByte(spi, transaction->command[i]);
+  }
+  for (int i = 0; i < transaction->dataLength; i++) {
+    uint8_t data = SpiHal_transmitByte(spi, transaction->transmitData ?
+        transaction->transmitData[i] : DUMMY_BYTE);
+    if (transaction->receiveData) {
+      transaction->receiveData[i] = data;
+    }
+  }
+  SpiHal_release(transaction->device);
+
+  if (transaction->callback) {
+    transaction->callback(transaction);
+  }
+}
+/**
+ * @brief Sends and receives one byte to the emulated card
+ * @param spi SPI to send data on
+ * @param dataToSend Data to send
+ * @return Received data
+ */
+uint8_t SpiHal_transmitByte(SpiNumber spi, uint8_t dataToSend) {
+  if (spi != SPI_HAL_SPI1) {
+    return DUMMY_BYTE;
+  }
+  return transferByte(dataToSend);
+}
+/**
+ * @brief Send multiple data to the emulated card.
+ */
+void SpiHal_sendBuffer(SpiNumber spi, uint8_t* transmitBuffer, int length) {
+  while (length--) {
+    SpiHal_transmitByte(spi, *transmitBuffer++);
+  }
+}
+/**
+ * @brief Read multiple data from the emulated card.
+ */
+void SpiHal_readBuffer(SpiNumber spi, uint8_t* receiveBuffer, int length) {
+  while (length--) {
+    *receiveBuffer++ = SpiHal_transmitByte(spi, DUMMY_BYTE);
+  }
+}
+/**
+ * @brief Transmit multiple data to and from the emulated card.
+ */
+void SpiHal_transmitBuffer(SpiNumber spi, uint8_t* receiveBuffer,
+    uint8_t* transmitBuffer, int length) {
+  while (length--) {
+    *receiveBuffer++ = SpiHal_transmitByte(spi, *transmitBuffer++);
+  }
+}
+// ********************** Emulated time **********************
+/**
+ * @brief Returns the emulated system time.
+ * @details Time advances with every byte clocked on the bus and
+ * with every delay.
+ * @return System time
+ */
+unsigned int Timer_getTimeMillis(void) {
+  return (unsigned int)(timeNanos / 1000000);
+}
+/**
+ * @brief Delay function - only advances emulated time.
+ * @param millis Milliseconds to delay.
+ */
+void Timer_delayMillis(unsigned int millis) {
+  advanceTime((uint64_t)millis * 1000000);
+}
+/**
+ * @brief Nonblocking delay function
+ * @param millis Delay time
+ * @param startTimeMillis System time at start of delay
+ * @retval FALSE Delay value has not been reached (wait longer)
+ * @retval TRUE Delay value has been reached
+ */
+Boolean Timer_delayTimer(unsigned int millis, unsigned int startTimeMillis) {
+  return (Timer_getTimeMillis() - startTimeMillis) > millis;
+}
+// ********************** Card emulation **********************
+/**
+ * @brief Clocks one byte in both directions.
+ * @param receivedByte Byte sent by host
+ * @return Byte sent by card
+ */
+uint8_t transferByte(uint8_t receivedByte) {
+
+  uint64_t byteTimeNanos = 8 * NANOSECONDS_IN_SECOND / configuration.spiClockHz;
+  advanceTime(byteTimeNanos);
+  busTimeNanos += byteTimeNanos;
+
+  if (!isSelected || image == NULL) {
+    return DUMMY_BYTE;
+  }
+  statistics.bytesTransferred++;
+
+  // the card shifts out its byte while the host byte is shifted in
+  uint8_t sentByte = nextOutputByte();
+
+  if (state == CARD_STATE_RECEIVE_BLOCK) {
+    receiveBlockByte(receivedByte);
+  } else if ((state == CARD_STATE_WRITE_BLOCKS) && (commandIndex == 0) &&
+      ((receivedByte == TOKEN_SINGLE_BLOCK) ||
+       (receivedByte == TOKEN_MULTIPLE_WRITE))) {
+    state = CARD_STATE_RECEIVE_BLOCK;
+    blockIndex = 0;
+  } else if ((state == CARD_STATE_WRITE_BLOCKS) && (commandIndex == 0) &&
+      (receivedByte == TOKEN_STOP_WRITE) && isMultipleTransfer) {
+    state = CARD_STATE_COMMANDS;
+    queueByte(DUMMY_BYTE);
+    busyBytes = configuration.writeBusyBytes;
+  } else {
+    receiveCommandByte(receivedByte);
+  }
+  return sentByte;
+}
+/**
+ * @brief Gets the next byte the card sends.
+ * @return Byte sent by card
+ */
+uint8_t nextOutputByte(void) {
+
+  if (responseCount) {
+    uint8_t data = responseQueue[responseHead];
+    responseHead = (responseHead + 1) % RESPONSE_QUEUE_LENGTH;
+    responseCount--;
+    return data;
+  }
+  if (busyBytes) {
+    busyBytes--;
+    return BUSY_BYTE;
+  }
+  if (state != CARD_STATE_READ_BLOCKS) {
+    return DUMMY_BYTE;
+  }
+  if (readLatency) {
+    readLatency--;
+    return DUMMY_BYTE;
+  }
+  if (!isTokenSent) {
+    isTokenSent = TRUE;
+    return TOKEN_SINGLE_BLOCK;
+  }
+
+  uint8_t data = block[blockIndex++];
+
+  if (blockIndex == blockLength + CRC_SIZE) {
+    if (blockLength == SECTOR_SIZE) {
+      statistics.blocksRead++;
+    }
+    if (isMultipleTransfer) {
+      currentSector++;
+      startReadBlock();
+    } else {
+      state = CARD_STATE_COMMANDS;
+    }
+  }
+  return data;
+}
+/**
+ * @brief Collects command bytes and executes complete commands.
+ * @param receivedByte Byte sent by host
+ */
+void receiveCommandByte(uint8_t receivedByte) {
+
+  const uint8_t START_BITS_MASK = 0xc0;
+  const uint8_t START_BITS = 0x40;
+
+  // wait for start and transmission bits
+  if ((commandIndex == 0) && ((receivedByte & START_BITS_MASK) != START_BITS)) {
+    return;
+  }
+  command[commandIndex++] = receivedByte;
+
+  if (commandIndex == COMMAND_LENGTH) {
+    commandIndex = 0;
+    executeCommand();
+  }
+}
+/**
+ * @brief Receives data block bytes and writes complete blocks.
+ * @param receivedByte Byte sent by host
+ */
+void receiveBlockByte(uint8_t receivedByte) {
+
+  block[blockIndex++] = receivedByte;
+
+  if (blockIndex < SECTOR_SIZE + CRC_SIZE) {
+    return;
+  }
+
+  uint16_t receivedCrc = (block[SECTOR_SIZE] << 8) | block[SECTOR_SIZE + 1];
+  uint8_t dataResponse = DATA_ACCEPTED;
+
+  if (configuration.writeErrors > 0) {
+    configuration.writeErrors--;
+    dataResponse = DATA_WRITE_ERROR;
+  } else if (configuration.writeCrcErrors > 0) {
+    configuration.writeCrcErrors--;
+    dataResponse = DATA_CRC_ERROR;
+  } else if (isCrcEnabled &&
+      (receivedCrc != Utils_crc16(0, block, SECTOR_SIZE))) {
+    dataResponse = DATA_CRC_ERROR;
+  } else if (!writeImageSector(currentSector, block)) {
+    dataResponse = DATA_WRITE_ERROR;
+  }
+
+  if (dataResponse == DATA_CRC_ERROR) {
+    statistics.crcErrors++;
+  }
+  if (dataResponse == DATA_ACCEPTED) {
+    statistics.blocksWritten++;
+    currentSector++;
+  }
+
+  queueByte(DATA_RESPONSE_PREFIX | dataResponse);
+  busyBytes = configuration.writeBusyBytes;
+
+  // after an error the card waits for STOP_TRANSMISSION
+  if (isMultipleTransfer) {
+    state = CARD_STATE_WRITE_BLOCKS;
+  } else {
+    state = CARD_STATE_COMMANDS;
+  }
+}
+/**
+ * @brief Executes a received command.
+ */
+void executeCommand(void) {
+
+  const int CMD_GO_IDLE_STATE = 0;
+  const int CMD_SEND_IF_COND = 8;
+  uint8_t index = command[0] & 0x3f;
+  uint32_t argument = ((uint32_t)command[1] << 24) | (command[2] << 16) |
+      (command[3] << 8) | command[4];
+  uint8_t r1 = isInIdleState ? R1_IN_IDLE_STATE : 0;
+  Boolean isApp = isAppCommand;
+
+  isAppCommand = FALSE;
+  if (isApp) {
+    statistics.appCommands[index]++;
+  } else {
+    statistics.commands[index]++;
+  }
+
+  // CMD0 and CMD8 are always checked, other commands only in CRC mode
+  Boolean isCrcChecked = isCrcEnabled || (index == CMD_GO_IDLE_STATE) ||
+      (index == CMD_SEND_IF_COND);
+  if ((configuration.commandCrcErrors > 0) || (isCrcChecked &&
+      (command[5] != calculateCrc7(command, COMMAND_LENGTH - 1)))) {
+    if (configuration.commandCrcErrors > 0) {
+      configuration.commandCrcErrors--;
+    }
+    statistics.crcErrors++;
+    queueResponseR1(r1 | R1_COMMAND_CRC_ERROR);
+    return;
+  }
+
+  // any command stops sending data
+  if (state == CARD_STATE_READ_BLOCKS) {
+    state = CARD_STATE_COMMANDS;
+  }
+
+  if (isApp) {
+    switch (index) {
+    case 41: // SD_SEND_OP_COND
+      if (++initializationCount > configuration.initializationTries) {
+        isInIdleState = FALSE;
+      }
+      queueResponseR1(isInIdleState ? R1_IN_IDLE_STATE : 0);
+      return;
+    case 22: // SEND_NUM_WR_BLOCKS
+    case 51: // SEND_SCR
+    default:
+      queueResponseR1(r1 | R1_ILLEGAL_COMMAND);
+      return;
+    }
+  }
+
+  switch (index) {
+  case 0: // GO_IDLE_STATE
+    isInIdleState = TRUE;
+    isCrcEnabled = FALSE;
+    initializationCount = 0;
+    state = CARD_STATE_COMMANDS;
+    queueResponseR1(R1_IN_IDLE_STATE);
+    break;
+  case 8: // SEND_IF_COND
+    queueResponseR1(r1);
+    queueByte(0x00);
+    queueByte(0x00);
+    queueByte((argument >> 8) & 0x0f);
+    queueByte(argument & 0xff);
+    break;
+  case 9: // SEND_CSD
+    queueResponseR1(r1);
+    startReadRegister(csd);
+    break;
+  case 10: // SEND_CID
+    queueResponseR1(r1);
+    startReadRegister(cid);
+    break;
+  case 12: // STOP_TRANSMISSION
+    state = CARD_STATE_COMMANDS;
+    queueResponseR1(r1);
+    break;
+  case 13: // SEND_STATUS
+    queueResponseR1(r1);
+    queueByte(0x00);
+    break;
+  case 16: // SET_BLOCKLEN
+    queueResponseR1((argument == SECTOR_SIZE) ? r1 : r1 | R1_PARAMETER_ERROR);
+    break;
+  case 17: // READ_SINGLE_BLOCK
+  case 18: // READ_MULTIPLE_BLOCK
+    currentSector = convertAddressToSector(argument);
+    if (currentSector >= sectorCount) {
+      queueResponseR1(r1 | R1_PARAMETER_ERROR);
+      break;
+    }
+    queueResponseR1(r1);
+    isMultipleTransfer = (index == 18);
+    state = CARD_STATE_READ_BLOCKS;
+    startReadBlock();
+    break;
+  case 24: // WRITE_BLOCK
+  case 25: // WRITE_MULTIPLE_BLOCK
+    currentSector = convertAddressToSector(argument);
+    if (currentSector >= sectorCount) {
+      queueResponseR1(r1 | R1_PARAMETER_ERROR);
+      break;
+    }
+    queueResponseR1(r1);
+    isMultipleTransfer = (index == 25);
+    state = CARD_STATE_WRITE_BLOCKS;
+    break;
+  case 32: // ERASE_WR_BLK_START_ADDR
+    eraseStartSector = convertAddressToSector(argument);
+    queueResponseR1(r1);
+    break;
+  case 33: // ERASE_WR_BLK_END_ADDR
+    eraseEndSector = convertAddressToSector(argument);
+    queueResponseR1(r1);
+    break;
+  case 38: // ERASE
+    if ((eraseStartSector > eraseEndSector) || (eraseEndSector >= sectorCount)) {
+      queueResponseR1(r1 | R1_PARAMETER_ERROR);
+      break;
+    }
+    memset(block, 0, SECTOR_SIZE);
+    for (uint32_t i = eraseStartSector; i <= eraseEndSector; i++) {
+      writeImageSector(i, block);
+      statistics.sectorsErased++;
+    }
+    queueResponseR1(r1);
+    busyBytes = configuration.eraseBusyBytes;
+    break;
+  case 55: // APP_CMD
+    isAppCommand = TRUE;
+    queueResponseR1(r1);
+    break;
+  case 58: { // READ_OCR
+    uint32_t ocr = OCR_VOLTAGE_WINDOW;
+    if (!isInIdleState) {
+      ocr |= OCR_POWER_UP_STATUS;
+      if (configuration.isSDHC) {
+        ocr |= OCR_CAPACITY_STATUS;
+      }
+    }
+    queueResponseR1(r1);
+    queueByte(ocr >> 24);
+    queueByte(ocr >> 16);
+    queueByte(ocr >> 8);
+    queueByte(ocr);
+    break;
+  }
+  case 59: // CRC_ON_OFF
+    isCrcEnabled = (argument & 0x01) ? TRUE : FALSE;
+    queueResponseR1(r1);
+    break;
+  default:
+    queueResponseR1(r1 | R1_ILLEGAL_COMMAND);
+    break;
+  }
+}
+/**
+ * @brief Adds a byte to the response queue.
+ * @param data Byte to send
+ */
+void queueByte(uint8_t data) {
+  if (responseCount == RESPONSE_QUEUE_LENGTH) {
+    return;
+  }
+  responseQueue[(responseHead + responseCount) % RESPONSE_QUEUE_LENGTH] = data;
+  responseCount++;
+}
+/**
+ * @brief Replaces the response queue with an R1 response.
+ * @details The response is preceded by the configured command latency.
+ * @param response R1 response
+ */
+void queueResponseR1(uint8_t response) {
+  responseCount = 0;
+  busyBytes = 0;
+  for (int i = 0; i < configuration.commandLatency; i++) {
+    queueByte(DUMMY_BYTE);
+  }
+  queueByte(response);
+}
+/**
+ * @brief Prepares the current sector for sending.
+ */
+void startReadBlock(void) {
+
+  if (currentSector >= sectorCount) {
+    state = CARD_STATE_COMMANDS;
+    return;
+  }
+  readImageSector(currentSector, block);
+  blockLength = SECTOR_SIZE;
+
+  uint16_t crc = Utils_crc16(0, block, SECTOR_SIZE);
+  if (configuration.readCrcErrors > 0) {
+    configuration.readCrcErrors--;
+    crc = ~crc;
+  }
+  block[SECTOR_SIZE] = crc >> 8;
+  block[SECTOR_SIZE + 1] = crc;
+
+  blockIndex = 0;
+  readLatency = configuration.readLatency;
+  isTokenSent = FALSE;
+}
+/**
+ * @brief Prepares a register for sending as a data block.
+ * @param registerValue CSD or CID register
+ */
+void startReadRegister(const uint8_t* registerValue) {
+
+  memcpy(block, registerValue, REGISTER_SIZE);
+  blockLength = REGISTER_SIZE;
+
+  uint16_t crc = Utils_crc16(0, block, REGISTER_SIZE);
+  block[REGISTER_SIZE] = crc >> 8;
+  block[REGISTER_SIZE + 1] = crc;
+
+  blockIndex = 0;
+  readLatency = configuration.readLatency;
+  isTokenSent = FALSE;
+  isMultipleTransfer = FALSE;
+  state = CARD_STATE_READ_BLOCKS;
+}
+/**
+ * @brief Reads a sector from the image.
+ * @param sector Sector number
+ * @param buffer Buffer for data
+ * @retval TRUE Sector read
+ * @retval FALSE Sector outside of image
+ */
+Boolean readImageSector(uint32_t sector, uint8_t* buffer) {
+  if (sector >= sectorCount) {
+    return FALSE;
+  }
+  fseeko(image, (off_t)sector * SECTOR_SIZE, SEEK_SET);
+  return fread(buffer, SECTOR_SIZE, 1, image) == 1;
+}
+/**
+ * @brief Writes a sector to the image.
+ * @param sector Sector number
+ * @param buffer Data to write
+ * @retval TRUE Sector written
+ * @retval FALSE Sector outside of image
+ */
+Boolean writeImageSector(uint32_t sector, const uint8_t* buffer) {
+  if (sector >= sectorCount) {
+    return FALSE;
+  }
+  fseeko(image, (off_t)sector * SECTOR_SIZE, SEEK_SET);
+  return fwrite(buffer, SECTOR_SIZE, 1, image) == 1;
+}
+/**
+ * @brief Converts command address to sector number.
+ * @details SDSC cards use byte addressing, SDHC use block addressing.
+ * @param address Command argument
+ * @return Sector number
+ */
+uint32_t convertAddressToSector(uint32_t address) {
+  if (configuration.isSDHC) {
+    return address;
+  }
+  return address / SECTOR_SIZE;
+}
+/**
+ * @brief Builds CID and CSD registers for the card image.
+ */
+void buildRegisters(void) {
+
+  const uint8_t CID_VALUE[REGISTER_SIZE - 1] = {
+      0x03, 'S', 'D', 'E', 'M', 'U', 'L', '0', 0x10, 0x12, 0x34, 0x56, 0x78, 0x01, 0xa8
+  };
+  memcpy(cid, CID_VALUE, sizeof(CID_VALUE));
+  cid[REGISTER_SIZE - 1] = calculateCrc7(cid, REGISTER_SIZE - 1);
+
+  memset(csd, 0, REGISTER_SIZE);
+  setRegisterBits(csd, 119, 112, 0x0e); // TAAC
+  setRegisterBits(csd, 103,  96, 0x32); // TRAN_SPEED - 25 MHz
+  setRegisterBits(csd,  95,  84, 0x5b5);// CCC
+  setRegisterBits(csd,  83,  80, 9);    // READ_BL_LEN - 512 bytes
+  setRegisterBits(csd,  46,  46, 1);    // ERASE_BLK_EN
+  setRegisterBits(csd,  45,  39, 0x7f); // SECTOR_SIZE
+  setRegisterBits(csd,  25,  22, 9);    // WRITE_BL_LEN - 512 bytes
+
+  if (configuration.isSDHC) {
+    const uint32_t SECTORS_PER_UNIT = 1024;
+    uint32_t deviceSize = sectorCount / SECTORS_PER_UNIT;
+    setRegisterBits(csd, 127, 126, 1);  // CSD version 2.0
+    setRegisterBits(csd,  69,  48, deviceSize ? deviceSize - 1 : 0); // C_SIZE
+  } else {
+    // capacity = (C_SIZE + 1) * 2^(C_SIZE_MULT + 2) * 2^READ_BL_LEN
+    const int SIZE_MULTIPLIER = 7;
+    const uint32_t SECTORS_PER_UNIT = 1 << (SIZE_MULTIPLIER + 2);
+    uint32_t deviceSize = sectorCount / SECTORS_PER_UNIT;
+    setRegisterBits(csd, 127, 126, 0);  // CSD version 1.0
+    setRegisterBits(csd,  73,  62, deviceSize ? deviceSize - 1 : 0); // C_SIZE
+    setRegisterBits(csd,  49,  47, SIZE_MULTIPLIER); // C_SIZE_MULT
+  }
+  csd[REGISTER_SIZE - 1] = calculateCrc7(csd, REGISTER_SIZE - 1);
+}
+/**
+ * @brief Sets a bit field of a 128 bit register (bit 127 is sent first).
+ * @param registerValue Register bytes
+ * @param msb Most significant bit of field
+ * @param lsb Least significant bit of field
+ * @param value Value of field
+ */
+void setRegisterBits(uint8_t* registerValue, int msb, int lsb, uint32_t value) {
+  const int REGISTER_BITS = REGISTER_SIZE * NUMBER_OF_BITS_IN_BYTE;
+  for (int bit = lsb; bit <= msb; bit++, value >>= 1) {
+    int byteIndex = (REGISTER_BITS - 1 - bit) / NUMBER_OF_BITS_IN_BYTE;
+    uint8_t mask = 1 << (bit % NUMBER_OF_BITS_IN_BYTE);
+    if (value & 0x01) {
+      registerValue[byteIndex] |= mask;
+    } else {
+      registerValue[byteIndex] &= ~mask;
+    }
+  }
+}
+/**
+ * @brief Calculates CRC7 the way it is placed in commands and registers.
+ * @param data Data bytes
+ * @param length Number of bytes
+ * @return CRC7 followed by end bit
+ */
+uint8_t calculateCrc7(const uint8_t* data, int length) {
+  const uint8_t POLYNOMIAL = 0x09 << 1;
+  uint8_t crc = 0;
+  while (length--) {
+    crc ^= *data++;
+    for (int i = 0; i < NUMBER_OF_BITS_IN_BYTE; i++) {
+      crc = (crc & 0x80) ? (crc << 1) ^ POLYNOMIAL : (crc << 1);
+    }
+  }
+  return crc | 0x01;
+}
+/**
+ * @brief Advances emulated time.
+ * @param nanos Nanoseconds
+ */
+void advanceTime(uint64_t nanos) {
+  timeNanos += nanos;
+}
+
+/**
+ * @}
+ */
+
+#endif /* USE_SD_EMULATOR */
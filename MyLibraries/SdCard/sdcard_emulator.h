@@ -0,0 +1,84 @@
+/**
+ * @file    sdcard_emulator.h
+ * @brief   Host side SD card emulator behind the SPI HAL.
+ * @date    18.10.2026
+ * @author  Michal Ksiezopolski
+ *
+ * @verbatim
+ * Copyright (c) 2026 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef SDCARD_EMULATOR_H_
+#define SDCARD_EMULATOR_H_
+
+#include "utils.h"
+#include <inttypes.h>
+
+/**
+ * @defgroup  SD_EMULATOR SD EMULATOR
+ * @brief     Emulated SD card for running the SD and FAT libraries on a PC.
+ *
+ * @details The emulator implements the SpiHal_* and timing functions used
+ * by the SD card driver, so it replaces spi_hal.c and timers.c in a host
+ * build. The card is emulated byte by byte in SPI mode and stores its data
+ * in an image file. Compile with USE_SD_EMULATOR defined.
+ */
+
+/**
+ * @addtogroup SD_EMULATOR
+ * @{
+ */
+
+/**
+ * @brief Emulator configuration
+ */
+typedef struct {
+  Boolean  isSDHC;              ///< Emulate SDHC (block addressing) or SDSC card
+  int      initializationTries; ///< Number of ACMD41 commands answered with IDLE state
+  int      commandLatency;      ///< Bytes between end of command and response (NCR)
+  int      readLatency;         ///< Bytes between response and data token (NAC)
+  int      writeBusyBytes;      ///< Busy bytes after every written block
+  int      eraseBusyBytes;      ///< Busy bytes after erase command
+  uint32_t spiClockHz;          ///< SPI clock used for calculating transfer time
+  int      commandCrcErrors;    ///< Number of next commands reported as CRC errors
+  int      readCrcErrors;       ///< Number of next read blocks sent with corrupted CRC
+  int      writeCrcErrors;      ///< Number of next written blocks rejected with CRC error
+  int      writeErrors;         ///< Number of next written blocks rejected with write error
+} SdEmulatorConfig;
+
+#define SD_EMULATOR_MAX_COMMANDS 64 ///< Number of SD commands (CMD0 - CMD63)
+
+/**
+ * @brief Emulator statistics
+ */
+typedef struct {
+  unsigned long commands[SD_EMULATOR_MAX_COMMANDS]; ///< Number of received commands by index
+  unsigned long appCommands[SD_EMULATOR_MAX_COMMANDS]; ///< Number of received ACMD by index
+  unsigned long bytesTransferred; ///< Bytes clocked on SPI while card was selected
+  unsigned long blocksRead;       ///< Data blocks sent by the card
+  unsigned long blocksWritten;    ///< Data blocks written to the card
+  unsigned long sectorsErased;    ///< Sectors erased by the card
+  unsigned long crcErrors;        ///< CRC errors detected by the card
+  uint64_t      busTimeMicros;    ///< Time the SPI bus was busy at spiClockHz
+} SdEmulatorStatistics;
+
+int  SdEmulator_initialize       (const char* imagePath, const SdEmulatorConfig* config);
+void SdEmulator_close            (void);
+void SdEmulator_getDefaultConfig (SdEmulatorConfig* config);
+SdEmulatorConfig* SdEmulator_getConfig(void);
+void SdEmulator_getStatistics    (SdEmulatorStatistics* statistics);
+void SdEmulator_resetStatistics  (void);
+void SdEmulator_printStatistics  (const char* operation);
+
+/**
+ * @}
+ */
+
+#endif /* SDCARD_EMULATOR_H_ */
@@ -0,0 +1,192 @@
+/**
+ * @file    serial_command.c
+ * @brief   Dispatching commands received from PC.
+ * @date    18.10.2026
+ * @author  Michal Ksiezopolski
+ *
+ * @verbatim
+ * Copyright (c) 2026 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include "serial_command.h"
+#include "serial_port.h"
+#include <string.h>
+#include <stdio.h>
+
+#define LOG_MODULE_PREFIX "CMD--> "                ///< Prefix of log lines
+#define LOG_MODULE_LEVEL  LOG_LEVEL_SERIAL_COMMAND ///< Set with -DLOG_LEVEL_SERIAL_COMMAND=<level>
+#define LOG_MODULE_DEFAULT_LEVEL LOG_LEVEL_NONE    ///< Logging off by default
+#include "log_module.h"
+
+/**
+ * @addtogroup SERIAL_COMMAND
+ * @{
+ */
+
+#define ARGUMENT_SEPARATOR ' ' ///< Separates command arguments
+
+/**
+ * @brief Registered command
+ */
+typedef struct {
+  const char*          name;    ///< Command name (first argument of frame)
+  SerialCommandHandler handler; ///< Function called for the command
+} SerialCommand;
+
+static SerialCommand commands[SERIAL_COMMAND_MAX_COMMANDS]; ///< Commands sorted by name
+static int numberOfCommands;                                ///< Number of registered commands
+
+static int  findCommand(const char* name);
+static int  splitArguments(char* frame, char* argv[]);
+
+/**
+ * @brief Registers a command.
+ * @details The table is kept sorted, so registration costs O(n),
+ * but finding a command only O(log n). Registering an existing name
+ * replaces its handler.
+ * @param name Command name (has to stay valid - it isn't copied)
+ * @param handler Function called for the command
+ * @return Number of registered commands or -1 if the table is full
+ */
+int SerialCommand_register(const char* name, SerialCommandHandler handler) {
+
+  int index = findCommand(name);
+
+  if (index >= 0) {
+    commands[index].handler = handler;
+    return numberOfCommands;
+  }
+
+  if (numberOfCommands >= SERIAL_COMMAND_MAX_COMMANDS) {
+    logError("Too many commands");
+    return -1;
+  }
+
+  // move greater names one place up
+  int i = numberOfCommands;
+  while (i > 0 && strcmp(commands[i - 1].name, name) > 0) {
+    commands[i] = commands[i - 1];
+    i--;
+  }
+  commands[i].name    = name;
+  commands[i].handler = handler;
+
+  return ++numberOfCommands;
+}
+/**
+ * @brief Executes a command frame.
+ * @param frame Null terminated frame (is modified - arguments are terminated in place)
+ * @retval SERIAL_COMMAND_OK Handler was called
+ * @retval SERIAL_COMMAND_NO_COMMAND Frame is empty
+ * @retval SERIAL_COMMAND_UNKNOWN No command with that name
+ * @retval SERIAL_COMMAND_TOO_MANY_ARGUMENTS Frame has more than SERIAL_COMMAND_MAX_ARGUMENTS arguments
+ */
+SerialCommandResultCode SerialCommand_execute(char* frame) {
+
+  char* argv[SERIAL_COMMAND_MAX_ARGUMENTS + 1];
+  int argc = splitArguments(frame, argv);
+
+  if (argc == 0) {
+    return SERIAL_COMMAND_NO_COMMAND;
+  }
+  if (argc < 0) {
+    logWarning("Too many arguments");
+    return SERIAL_COMMAND_TOO_MANY_ARGUMENTS;
+  }
+
+  int index = findCommand(argv[0]);
+
+  if (index < 0) {
+    logWarning("Unknown command %s", argv[0]);
+    return SERIAL_COMMAND_UNKNOWN;
+  }
+
+  commands[index].handler(argc, argv);
+
+  return SERIAL_COMMAND_OK;
+}
+/**
+ * @brief Gets a frame from SERIAL_PORT (nonblocking) and executes it.
+ * @retval SERIAL_COMMAND_NO_COMMAND No frame received
+ * @retval SERIAL_COMMAND_FRAME_ERROR Received invalid frame
+ * @return Other values as in SerialCommand_execute
+ */
+SerialCommandResultCode SerialCommand_process(void) {
+
+  char frame[SERIAL_COMMAND_MAX_LENGTH];
+  int length;
+
+  switch (SerialPort_getFrame(frame, &length, SERIAL_COMMAND_MAX_LENGTH)) {
+  case SERIAL_PORT_GOT_FRAME:
+    println("Got frame of length %d: %s", length, frame);
+    return SerialCommand_execute(frame);
+  case SERIAL_PORT_NO_FRAME_READY:
+    return SERIAL_COMMAND_NO_COMMAND;
+  default:
+    return SERIAL_COMMAND_FRAME_ERROR;
+  }
+}
+/**
+ * @brief Finds command by binary search.
+ * @param name Command name
+ * @return Index of command or -1 if not found
+ */
+static int findCommand(const char* name) {
+
+  int low = 0;
+  int high = numberOfCommands - 1;
+
+  while (low <= high) {
+    int middle = (low + high) / 2;
+    int result = strcmp(name, commands[middle].name);
+    if (result == 0) {
+      return middle;
+    } else if (result < 0) {
+      high = middle - 1;
+    } else {
+      low = middle + 1;
+    }
+  }
+  return -1;
+}
+/**
+ * @brief Splits frame on separators into arguments.
+ * @param frame Null terminated frame (separators are replaced by null terminators)
+ * @param argv Buffer for SERIAL_COMMAND_MAX_ARGUMENTS + 1 pointers (terminated with NULL)
+ * @return Number of arguments or -1 if there are too many
+ */
+static int splitArguments(char* frame, char* argv[]) {
+
+  int argc = 0;
+
+  while (*frame) {
+    // skip separators
+    while (*frame == ARGUMENT_SEPARATOR) {
+      *frame++ = '\0';
+    }
+    if (*frame == '\0') {
+      break;
+    }
+    if (argc == SERIAL_COMMAND_MAX_ARGUMENTS) {
+      return -1;
+    }
+    argv[argc++] = frame;
+    // find end of argument
+    while (*frame && *frame != ARGUMENT_SEPARATOR) {
+      frame++;
+    }
+  }
+  argv[argc] = NULL;
+
+  return argc;
+}
+/**
+ * @}
+ */
@@ -0,0 +1,77 @@
+/**
+ * @file    serial_command.h
+ * @brief   Dispatching commands received from PC.
+ * @date    18.10.2026
+ * @author  Michal Ksiezopolski
+ *
+ * @verbatim
+ * Copyright (c) 2026 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef SERIAL_COMMAND_H_
+#define SERIAL_COMMAND_H_
+
+#include "utils.h"
+
+/**
+ * @defgroup  SERIAL_COMMAND SERIAL_COMMAND
+ * @brief     Table driven dispatcher for commands received by SERIAL_PORT.
+ *
+ * @details A frame is split on spaces into arguments, the first of which
+ * is the command name. Commands are kept sorted by name, so the handler
+ * is found by binary search (O(log n) string compares) and gets the
+ * arguments like main. For example frame ":LED 0 ON" calls the handler
+ * registered for ":LED" with argc = 3.
+ */
+
+/**
+ * @addtogroup SERIAL_COMMAND
+ * @{
+ */
+
+#ifndef SERIAL_COMMAND_MAX_COMMANDS
+  #define SERIAL_COMMAND_MAX_COMMANDS   32 ///< Maximum number of registered commands
+#endif
+
+#ifndef SERIAL_COMMAND_MAX_ARGUMENTS
+  #define SERIAL_COMMAND_MAX_ARGUMENTS  8  ///< Maximum number of arguments (including command name)
+#endif
+
+#ifndef SERIAL_COMMAND_MAX_LENGTH
+  #define SERIAL_COMMAND_MAX_LENGTH     64 ///< Maximum length of a command frame
+#endif
+
+/**
+ * @brief Command results
+ */
+typedef enum {
+  SERIAL_COMMAND_OK,                 //!< SERIAL_COMMAND_OK
+  SERIAL_COMMAND_NO_COMMAND,         //!< SERIAL_COMMAND_NO_COMMAND
+  SERIAL_COMMAND_UNKNOWN,            //!< SERIAL_COMMAND_UNKNOWN
+  SERIAL_COMMAND_TOO_MANY_ARGUMENTS, //!< SERIAL_COMMAND_TOO_MANY_ARGUMENTS
+  SERIAL_COMMAND_FRAME_ERROR,        //!< SERIAL_COMMAND_FRAME_ERROR
+} SerialCommandResultCode;
+
+/**
+ * @brief Command handler
+ * @param argc Number of arguments (including command name)
+ * @param argv Arguments
+ */
+typedef void (*SerialCommandHandler)(int argc, char* argv[]);
+
+int                     SerialCommand_register (const char* name, SerialCommandHandler handler);
+SerialCommandResultCode SerialCommand_execute  (char* frame);
+SerialCommandResultCode SerialCommand_process  (void);
+
+/**
+ * @}
+ */
+
+#endif /* SERIAL_COMMAND_H_ */
@@ -0,0 +1,377 @@
+/**
+ * @file    serial_frame.c
+ * @brief   Framed binary protocol over UART (COBS + CRC16).
+ * @date    18.10.2026
+ * @author  Michal Ksiezopolski
+ *
+ * @verbatim
+ * Copyright (c) 2026 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include "serial_frame.h"
+#include "fifo.h"
+#include "serial_transport.h"
+#include "common_hal.h"
+#include <string.h>
+#include <stdio.h>
+
+#define LOG_MODULE_PREFIX "FRAME--> "            ///< Prefix of log lines
+#define LOG_MODULE_LEVEL  LOG_LEVEL_SERIAL_FRAME ///< Set with -DLOG_LEVEL_SERIAL_FRAME=<level>
+#define LOG_MODULE_DEFAULT_LEVEL LOG_LEVEL_NONE  ///< Logging off by default
+#include "log_module.h"
+
+/**
+ * @addtogroup SERIAL_FRAME
+ * @{
+ */
+
+#define FRAME_DELIMITER        0x00  ///< Ends every encoded frame
+#define FRAME_HEADER_LENGTH    1     ///< Sequence number
+#define FRAME_CRC_LENGTH       2     ///< CRC16
+#define FRAME_CRC_INITIAL      0xffff///< Initial value of frame CRC
+#define COBS_MAX_CODE          0xff  ///< Code of a block with 254 non zero bytes and no zero after it
+#define RAW_FRAME_LENGTH       (FRAME_HEADER_LENGTH + SERIAL_FRAME_MAX_PAYLOAD + FRAME_CRC_LENGTH)
+#define ENCODED_FRAME_LENGTH   (RAW_FRAME_LENGTH + RAW_FRAME_LENGTH / 254 + 2) ///< With overhead and delimiter
+#define TRANSMIT_BUFFER_LENGTH 1024  ///< Transmit FIFO length (power of two)
+
+/**
+ * @brief Slot for a received frame
+ */
+typedef struct {
+  uint8_t data[RAW_FRAME_LENGTH]; ///< Decoded frame (sequence number, payload, CRC)
+  int     length;                 ///< Length of decoded frame
+  unsigned int skippedFrames;     ///< Frames dropped or with framing errors since previous slot
+} FrameSlot;
+
+/**
+ * @brief State of COBS decoder
+ */
+typedef struct {
+  FrameSlot* slot;      ///< Slot the current frame is decoded to (NULL if frame is dropped)
+  Boolean    isStarted; ///< Got first byte of the current frame
+  uint8_t    code;      ///< Code of the current block (0 before the first block)
+  uint8_t    remaining; ///< Bytes remaining in the current block
+} FrameDecoder;
+
+/**
+ * @brief State of COBS encoder
+ */
+typedef struct {
+  uint8_t* buffer;      ///< Output buffer
+  int      length;      ///< Number of bytes in output buffer
+  int      codeIndex;   ///< Position of code of the current block
+  uint8_t  code;        ///< Code of the current block
+} FrameEncoder;
+
+static FrameSlot slots[SERIAL_FRAME_SLOTS];     ///< Received frames
+static volatile unsigned int slotHead;          ///< Number of received frames (written by ISR)
+static volatile unsigned int slotTail;          ///< Number of released frames (written by main loop)
+static FrameDecoder decoder;                    ///< Receive decoder state
+static unsigned int skippedFrames;              ///< Frames not passed to main loop since last slot (ISR)
+static unsigned int rejectedFrames;             ///< Frames with CRC error since last valid frame (main loop)
+static Boolean isFrameTaken;                    ///< Frame at slotTail was returned by getFrame
+static int takenFrameLength;                    ///< Payload length of the taken frame
+
+static char transmitBuffer[TRANSMIT_BUFFER_LENGTH]; ///< Buffer for transmit FIFO
+static Fifo transmitFifo;                       ///< Encoded frames waiting for UART
+static uint8_t encodedFrame[ENCODED_FRAME_LENGTH]; ///< Frame encoded by SerialFrame_send
+static uint8_t transmitSequence;                ///< Sequence number of next sent frame
+static uint8_t expectedSequence;                ///< Sequence number of next received frame
+static Boolean isSequenceKnown;                 ///< Got the first frame
+static SerialFrameStatistics statistics;        ///< Protocol statistics (every counter is written by one context)
+
+static void receiveCb(const char* receivedData, int length);
+static int  transmitCb(int transmittedLength, const char** dataToTransmit);
+static void decodeByte(uint8_t byte);
+static void endFrame(void);
+static void encoderStart(FrameEncoder* encoder, uint8_t* buffer);
+static void encoderPut(FrameEncoder* encoder, const uint8_t* data, int length);
+static int  encoderFinish(FrameEncoder* encoder);
+
+/**
+ * @brief Initialize binary frame interface.
+ * @param baudRate Required baud rate
+ */
+void SerialFrame_initialize(int baudRate) {
+  Fifo_addNewFifo(&transmitFifo, transmitBuffer, TRANSMIT_BUFFER_LENGTH);
+  memset(&decoder, 0, sizeof(decoder));
+  memset(&statistics, 0, sizeof(statistics));
+  slotHead = 0;
+  slotTail = 0;
+  skippedFrames = 0;
+  rejectedFrames = 0;
+  isFrameTaken = FALSE;
+  isSequenceKnown = FALSE;
+  transmitSequence = 0;
+  SERIAL_FRAME_TRANSPORT.initialize(baudRate, receiveCb, transmitCb);
+}
+/**
+ * @brief Sends a frame.
+ * @details The whole frame is queued or none of it, so a full transmit
+ * buffer doesn't corrupt the stream.
+ * @param data Payload
+ * @param length Payload length
+ * @retval SERIAL_FRAME_OK Frame queued for sending
+ * @retval SERIAL_FRAME_TOO_LONG Payload is longer than SERIAL_FRAME_MAX_PAYLOAD
+ * @retval SERIAL_FRAME_TRANSMIT_FULL Not enough space in transmit buffer
+ */
+SerialFrameResultCode SerialFrame_send(const uint8_t* data, int length) {
+
+  if (length > SERIAL_FRAME_MAX_PAYLOAD) {
+    return SERIAL_FRAME_TOO_LONG;
+  }
+
+  uint8_t sequence = transmitSequence;
+  uint16_t crc = Utils_crc16(FRAME_CRC_INITIAL, &sequence, FRAME_HEADER_LENGTH);
+  crc = Utils_crc16(crc, data, length);
+  uint8_t crcBytes[FRAME_CRC_LENGTH] = { crc >> 8, crc & 0xff };
+
+  FrameEncoder encoder;
+  encoderStart(&encoder, encodedFrame);
+  encoderPut(&encoder, &sequence, FRAME_HEADER_LENGTH);
+  encoderPut(&encoder, data, length);
+  encoderPut(&encoder, crcBytes, FRAME_CRC_LENGTH);
+  int encodedLength = encoderFinish(&encoder);
+
+  if (Fifo_getFreeSpace(&transmitFifo) < encodedLength) {
+    return SERIAL_FRAME_TRANSMIT_FULL;
+  }
+
+  Fifo_write(&transmitFifo, (const char*)encodedFrame, encodedLength);
+  transmitSequence++;
+  statistics.framesSent++;
+
+  // enable transmitter if inactive
+  if (!SERIAL_FRAME_TRANSPORT.isSendingData()) {
+    SERIAL_FRAME_TRANSPORT.sendData();
+  }
+
+  return SERIAL_FRAME_OK;
+}
+/**
+ * @brief Gets the oldest received frame (nonblocking).
+ * @details The payload is not copied - data points to the frame slot and
+ * stays valid until SerialFrame_releaseFrame is called. Until then the same
+ * frame is returned. Frames with invalid CRC are dropped.
+ * @param data Pointer to payload
+ * @param length Payload length
+ * @retval SERIAL_FRAME_OK Got frame
+ * @retval SERIAL_FRAME_NO_FRAME No frame received
+ * @retval SERIAL_FRAME_CRC_ERROR Frame had invalid CRC and was dropped
+ */
+SerialFrameResultCode SerialFrame_getFrame(const uint8_t** data, int* length) {
+
+  if (slotHead == slotTail) {
+    return SERIAL_FRAME_NO_FRAME;
+  }
+
+  MEMORY_BARRIER(); // read slot only after seeing the head
+  FrameSlot* slot = &slots[slotTail & (SERIAL_FRAME_SLOTS - 1)];
+
+  if (!isFrameTaken) {
+    int crcPosition = slot->length - FRAME_CRC_LENGTH;
+    uint16_t crc = Utils_crc16(FRAME_CRC_INITIAL, slot->data, crcPosition);
+
+    if (crc != ((slot->data[crcPosition] << 8) | slot->data[crcPosition + 1])) {
+      statistics.crcErrors++;
+      rejectedFrames += slot->skippedFrames + 1;
+      logWarning("CRC error");
+      SerialFrame_releaseFrame();
+      return SERIAL_FRAME_CRC_ERROR;
+    }
+
+    // frames already counted as dropped or erroneous aren't counted as lost
+    uint8_t sequence = slot->data[0];
+    unsigned int missingFrames = (uint8_t)(sequence - expectedSequence);
+    unsigned int countedFrames = rejectedFrames + slot->skippedFrames;
+    if (isSequenceKnown && missingFrames > countedFrames) {
+      statistics.lostFrames += missingFrames - countedFrames;
+    }
+    rejectedFrames = 0;
+    expectedSequence = sequence + 1;
+    isSequenceKnown = TRUE;
+
+    statistics.framesReceived++;
+    takenFrameLength = crcPosition - FRAME_HEADER_LENGTH;
+    isFrameTaken = TRUE;
+  }
+
+  *data = slot->data + FRAME_HEADER_LENGTH;
+  *length = takenFrameLength;
+
+  return SERIAL_FRAME_OK;
+}
+/**
+ * @brief Releases frame returned by SerialFrame_getFrame, so that its slot can be reused.
+ */
+void SerialFrame_releaseFrame(void) {
+
+  if (slotHead == slotTail) {
+    return;
+  }
+
+  isFrameTaken = FALSE;
+  MEMORY_BARRIER(); // slot has to be read before ISR sees it free
+  slotTail++;
+}
+/**
+ * @brief Gets protocol statistics.
+ * @details Dropped frames and framing errors are counted by the receive
+ * interrupt, so the statistics are copied with interrupts disabled.
+ * @param stats Buffer for statistics
+ */
+void SerialFrame_getStatistics(SerialFrameStatistics* stats) {
+  uint32_t interruptState = CommonHal_disableInterrupts();
+  *stats = statistics;
+  CommonHal_restoreInterrupts(interruptState);
+}
+/**
+ * @brief Callback for receiving data from PC.
+ * @param receivedData Data sent from lower layer software.
+ * @param length Number of received bytes.
+ */
+static void receiveCb(const char* receivedData, int length) {
+  for (int i = 0; i < length; i++) {
+    decodeByte((uint8_t)receivedData[i]);
+  }
+}
+/**
+ * @brief Callback for transmitting data to lower layer
+ * @param transmittedLength Number of bytes sent since the last call
+ * @param dataToTransmit Pointer to the next block of data to transmit
+ * @return Number of bytes to be transmitted
+ */
+static int transmitCb(int transmittedLength, const char** dataToTransmit) {
+  char* data;
+  Fifo_commitRead(&transmitFifo, transmittedLength);
+  int length = Fifo_peekRead(&transmitFifo, &data);
+  *dataToTransmit = data;
+  return length;
+}
+/**
+ * @brief Decodes one received byte.
+ * @details Every non zero byte is either a block code or a data byte written
+ * to the frame slot, and the zero delimiter ends the frame.
+ * @param byte Received byte
+ */
+static void decodeByte(uint8_t byte) {
+
+  if (byte == FRAME_DELIMITER) {
+    endFrame();
+    return;
+  }
+
+  if (!decoder.isStarted) {
+    decoder.isStarted = TRUE;
+    if (slotHead - slotTail < SERIAL_FRAME_SLOTS) {
+      decoder.slot = &slots[slotHead & (SERIAL_FRAME_SLOTS - 1)];
+      decoder.slot->length = 0;
+    } else {
+      decoder.slot = NULL; // no free slot - drop frame
+      statistics.droppedFrames++;
+      skippedFrames++;
+    }
+  }
+
+  if (decoder.slot == NULL) {
+    return;
+  }
+
+  uint8_t dataByte = byte;
+
+  if (decoder.remaining == 0) {
+    // code byte - previous block ends with a zero unless it was the first or a full block
+    Boolean isZeroAppended = (decoder.code != 0 && decoder.code != COBS_MAX_CODE);
+    decoder.code = byte;
+    decoder.remaining = byte - 1;
+    if (!isZeroAppended) {
+      return;
+    }
+    dataByte = 0;
+  } else {
+    decoder.remaining--;
+  }
+
+  if (decoder.slot->length >= RAW_FRAME_LENGTH) {
+    decoder.slot = NULL; // frame too long - drop it
+    statistics.framingErrors++;
+    skippedFrames++;
+    return;
+  }
+
+  decoder.slot->data[decoder.slot->length++] = dataByte;
+}
+/**
+ * @brief Ends the decoded frame and passes it to the main loop.
+ */
+static void endFrame(void) {
+
+  if (decoder.isStarted && decoder.slot != NULL) {
+    if (decoder.remaining != 0 ||
+        decoder.slot->length < FRAME_HEADER_LENGTH + FRAME_CRC_LENGTH) {
+      statistics.framingErrors++;
+      skippedFrames++;
+    } else {
+      decoder.slot->skippedFrames = skippedFrames;
+      skippedFrames = 0;
+      MEMORY_BARRIER(); // slot has to be written before main loop sees the head
+      slotHead++;
+    }
+  }
+
+  decoder.slot      = NULL;
+  decoder.isStarted = FALSE;
+  decoder.code      = 0;
+  decoder.remaining = 0;
+}
+/**
+ * @brief Starts COBS encoding of a frame.
+ * @param encoder Encoder state
+ * @param buffer Output buffer (at least ENCODED_FRAME_LENGTH bytes)
+ */
+static void encoderStart(FrameEncoder* encoder, uint8_t* buffer) {
+  encoder->buffer    = buffer;
+  encoder->codeIndex = 0;
+  encoder->length    = 1;
+  encoder->code      = 1;
+}
+/**
+ * @brief Encodes data.
+ * @param encoder Encoder state
+ * @param data Data to encode
+ * @param length Length of data
+ */
+static void encoderPut(FrameEncoder* encoder, const uint8_t* data, int length) {
+  for (int i = 0; i < length; i++) {
+    if (data[i] != 0) {
+      encoder->buffer[encoder->length++] = data[i];
+      encoder->code++;
+    }
+    if (data[i] == 0 || encoder->code == COBS_MAX_CODE) {
+      // close the block and reserve place for code of the next one
+      encoder->buffer[encoder->codeIndex] = encoder->code;
+      encoder->codeIndex = encoder->length++;
+      encoder->code = 1;
+    }
+  }
+}
+/**
+ * @brief Finishes encoding and appends frame delimiter.
+ * @param encoder Encoder state
+ * @return Length of encoded frame
+ */
+static int encoderFinish(FrameEncoder* encoder) {
+  encoder->buffer[encoder->codeIndex] = encoder->code;
+  encoder->buffer[encoder->length++] = FRAME_DELIMITER;
+  return encoder->length;
+}
+/**
+ * @}
+ */
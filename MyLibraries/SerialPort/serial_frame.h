@@ -0,0 +1,97 @@
+/**
+ * @file    serial_frame.h
+ * @brief   Framed binary protocol over UART (COBS + CRC16).
+ * @date    18.10.2026
+ * @author  Michal Ksiezopolski
+ *
+ * @verbatim
+ * Copyright (c) 2026 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef SERIAL_FRAME_H_
+#define SERIAL_FRAME_H_
+
+#include "utils.h"
+#include <inttypes.h>
+
+/**
+ * @defgroup  SERIAL_FRAME SERIAL_FRAME
+ * @brief     Binary frames for streaming data to and from PC.
+ *
+ * @details Every frame is sent as COBS encoded sequence number, payload
+ * and CRC16-CCITT (initial value 0xffff, big endian) of sequence number
+ * and payload, followed by a zero delimiter. COBS guarantees there are no
+ * zeros inside the frame, so the receiver resynchronizes on the next
+ * delimiter after any error.
+ *
+ * Received bytes are decoded in the UART receive interrupt straight into
+ * frame slots, at constant cost per byte. SerialFrame_getFrame returns a
+ * pointer to the payload in the slot, which has to be released with
+ * SerialFrame_releaseFrame. The CRC is checked in SerialFrame_getFrame,
+ * so not in interrupt context.
+ *
+ * Frames go through a transport selected at compile time with
+ * SERIAL_FRAME_TRANSPORT: its own UART (default) or loopback for testing
+ * on host.
+ */
+
+/**
+ * @addtogroup SERIAL_FRAME
+ * @{
+ */
+
+#ifndef SERIAL_FRAME_MAX_PAYLOAD
+  #define SERIAL_FRAME_MAX_PAYLOAD 254 ///< Maximum payload length of a frame
+#endif
+
+#ifndef SERIAL_FRAME_TRANSPORT
+  #define SERIAL_FRAME_TRANSPORT   SerialTransport_frameUart ///< Lower layer (see serial_transport.h)
+#endif
+
+#ifndef SERIAL_FRAME_SLOTS
+  #define SERIAL_FRAME_SLOTS       4   ///< Number of received frames that can wait for processing (power of two)
+#endif
+
+/**
+ * @brief Frame results
+ */
+typedef enum {
+  SERIAL_FRAME_OK,            //!< SERIAL_FRAME_OK
+  SERIAL_FRAME_NO_FRAME,      //!< SERIAL_FRAME_NO_FRAME
+  SERIAL_FRAME_CRC_ERROR,     //!< SERIAL_FRAME_CRC_ERROR
+  SERIAL_FRAME_TOO_LONG,      //!< SERIAL_FRAME_TOO_LONG
+  SERIAL_FRAME_TRANSMIT_FULL, //!< SERIAL_FRAME_TRANSMIT_FULL
+} SerialFrameResultCode;
+
+/**
+ * @brief Protocol statistics
+ * @details Every missing frame is counted once: frames counted as CRC
+ * errors, framing errors or dropped aren't counted as lost.
+ */
+typedef struct {
+  unsigned long framesReceived; ///< Frames received with valid CRC
+  unsigned long framesSent;     ///< Frames queued for sending
+  unsigned long crcErrors;      ///< Frames received with invalid CRC
+  unsigned long framingErrors;  ///< Frames too short or too long
+  unsigned long droppedFrames;  ///< Frames dropped because all slots were busy
+  unsigned long lostFrames;     ///< Other frames missing according to sequence numbers
+} SerialFrameStatistics;
+
+void                  SerialFrame_initialize    (int baudRate);
+SerialFrameResultCode SerialFrame_send          (const uint8_t* data, int length);
+SerialFrameResultCode SerialFrame_getFrame      (const uint8_t** data, int* length);
+void                  SerialFrame_releaseFrame  (void);
+void                  SerialFrame_getStatistics (SerialFrameStatistics* statistics);
+
+/**
+ * @}
+ */
+
+#endif /* SERIAL_FRAME_H_ */
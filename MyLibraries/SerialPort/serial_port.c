@@ -17,85 +17,101 @@
 
 #include "serial_port.h"
 #include "fifo.h"
-#include "usart.h"
+#include "ring_buffer.h"
+#include "serial_transport.h"
+#include "common_hal.h"
 #include <string.h>
 #include <stdio.h>
 
-#ifndef COMM_DEBUG
-  #define COMM_DEBUG
-#endif
-
-#ifdef COMM_DEBUG
-  #define print(str, args...) printf("COMM--> "str"%s",##args,"\r")
-  #define println(str, args...) printf("COMM--> "str"%s",##args,"\r\n")
-#else
-  #define print(str, args...) (void)0
-  #define println(str, args...) (void)0
-#endif
+#define LOG_MODULE_PREFIX "COMM--> "            ///< Prefix of log lines
+#define LOG_MODULE_LEVEL  LOG_LEVEL_SERIAL_PORT ///< Set with -DLOG_LEVEL_SERIAL_PORT=<level>
+#include "log_module.h"
 
 /**
  * @addtogroup SERIAL_PORT
  * @{
  */
 
-#define TRANSMIT_BUFFER_LENGTH  UART_BUF_LEN_TX ///< Transmit buffer length
-#define RECEIVE_BUFFER_LENGTH   32              ///< Receive buffer length
 #define TERMINATOR_CHARACTER    '\r'            ///< Frame terminator character
 
-static char receiveBuffer[RECEIVE_BUFFER_LENGTH];    ///< Buffer for received data.
-static char transmitBuffer[TRANSMIT_BUFFER_LENGTH];  ///< Buffer for transmitted data.
+/**
+ * @brief Position of a received frame in the RX FIFO
+ */
+typedef struct {
+  unsigned int offset;       ///< Number of bytes received before the frame
+  int          length;       ///< Frame length without terminator (bytes stored in FIFO if overflowed)
+  Boolean      isOverflowed; ///< Part of frame didn't fit in RX FIFO
+} FrameDescriptor;
+
+RING_BUFFER_DEFINE(FrameQueue, FrameDescriptor, SERIAL_PORT_MAX_FRAMES)
+
+static char receiveBuffer[SERIAL_PORT_RECEIVE_BUFFER_LENGTH];   ///< Buffer for received data.
+static char transmitBuffer[SERIAL_PORT_TRANSMIT_BUFFER_LENGTH]; ///< Buffer for transmitted data.
 static Fifo receiveFifo;  ///< RX FIFO
 static Fifo transmitFifo; ///< TX FIFO
-static int frameCounter; ///< Nonzero signals a new frame (number of received frames)
-
-#if defined(USE_F7_DISCOVERY)
-  #define SERIAL_PORT_USART USART_HAL_USART6
-#else
-  #define SERIAL_PORT_USART USART_HAL_USART2
-#endif
+static FrameQueue frameQueue;         ///< Frames received by ISR
+static unsigned int receivedBytes;    ///< Number of bytes written to RX FIFO (written by ISR)
+static unsigned int frameStart;       ///< Value of receivedBytes at start of current frame (written by ISR)
+static Boolean isFrameOverflowed;     ///< Part of current frame didn't fit in RX FIFO (written by ISR)
+static unsigned int readBytes;        ///< Number of bytes read from RX FIFO (written by main loop)
+static void (*frameCallback)(void);   ///< Called by ISR for every received frame
 
-static int transmitCb(char* characterToSend);
-static void receiveCb(char receivedCharacter);
+static int transmitCb(int transmittedLength, const char** dataToTransmit);
+static void receiveCb(const char* receivedData, int length);
+static void startTransmitter(void);
 
 /**
  * @brief Initialize communication terminal interface.
  * @param baudRate Required baud rate
  */
 void SerialPort_initialize(int baudRate) {
-  // pass baud rate
-  // callback for received data and callback for transmitted data
-  Usart_initialize(SERIAL_PORT_USART, baudRate, receiveCb, transmitCb);
   // Initialize RX FIFO for receiving data from PC
-  Fifo_addNewFifo(&receiveFifo, receiveBuffer, RECEIVE_BUFFER_LENGTH);
+  Fifo_addNewFifo(&receiveFifo, receiveBuffer, SERIAL_PORT_RECEIVE_BUFFER_LENGTH);
   // Initialize TX FIFO for transferring data to PC
-  Fifo_addNewFifo(&transmitFifo, transmitBuffer, TRANSMIT_BUFFER_LENGTH);
+  Fifo_addNewFifo(&transmitFifo, transmitBuffer, SERIAL_PORT_TRANSMIT_BUFFER_LENGTH);
+  FrameQueue_initialize(&frameQueue);
+  // pass baud rate
+  // callback for received data and callback for transmitted data
+  SERIAL_PORT_TRANSPORT.initialize(baudRate, receiveCb, transmitCb);
 }
 /**
  * @brief Send a char to PC.
- * @details This function can be called in _write for printf to work
+ * @details This function can be called in _write for printf to work.
+ * The TX FIFO has a single producer, but printf may also be called from
+ * interrupts, so writing is done with interrupts disabled. This also keeps
+ * the check of the transmitter atomic with respect to its transfer
+ * complete interrupt.
  * @param characterToSend Character to send.
  */
 void SerialPort_putCharacter(char characterToSend) {
-  // disable IRQ so it doesn't screw up FIFO count - leads to errors in transmission
-  Usart_disableIrq(SERIAL_PORT_USART);
+  uint32_t interruptState = CommonHal_disableInterrupts();
   Fifo_push(&transmitFifo, characterToSend);
-  // enable transmitter if inactive
-  if (!Usart_isSendingData(SERIAL_PORT_USART)) {
-    Usart_sendDataIrq(SERIAL_PORT_USART);
-  }
-  // enable IRQ again
-  Usart_enableIrq(SERIAL_PORT_USART);
+  startTransmitter();
+  CommonHal_restoreInterrupts(interruptState);
+}
+/**
+ * @brief Send data to PC.
+ * @details This function can be called in _write for printf to work.
+ * Data that doesn't fit in the transmit FIFO is dropped.
+ * @param data Data to send
+ * @param length Length of data
+ */
+void SerialPort_write(const char* data, int length) {
+  uint32_t interruptState = CommonHal_disableInterrupts();
+  Fifo_write(&transmitFifo, data, length);
+  startTransmitter();
+  CommonHal_restoreInterrupts(interruptState);
 }
 /**
  * @brief Send string to PC with newline
  * @param line Line to send
  */
 void SerialPort_printLine(char* line) {
-  for (unsigned int i = 0; i < strlen(line); i++) {
-    SerialPort_putCharacter(line[i]);
-  }
-  SerialPort_putCharacter('\r');
-  SerialPort_putCharacter('\n');
+  uint32_t interruptState = CommonHal_disableInterrupts();
+  Fifo_write(&transmitFifo, line, strlen(line));
+  Fifo_write(&transmitFifo, NEWLINE_SEQUENCE, strlen(NEWLINE_SEQUENCE));
+  startTransmitter();
+  CommonHal_restoreInterrupts(interruptState);
 }
 /**
  * @brief Get a char from PC
@@ -106,84 +122,136 @@ char SerialPort_getCharacter(void) {
   char receivedCharacter;
   while (Fifo_isEmpty(&receiveFifo)); // wait until buffer is not empty
   Fifo_pop(&receiveFifo, &receivedCharacter); // Get data from RX buffer
+  readBytes++;
   return (char)receivedCharacter;
 }
 /**
  * @brief Get a complete frame from PC(nonblocking)
- * @param buf Buffer for data (data will be null terminated for easier string manipulation)
- * @param len Length not including terminator character
- * @retval COMM_GOT_FRAME Received frame
- * @retval COMM_NO_FRAME_READY No frame in buffer
- * @retval COMM_FRAME_ERROR Frame error
+ * @details Receive ISR queues position of every frame when its terminator
+ * arrives, so the frame is copied out of the RX FIFO without searching for
+ * the terminator. Data preceding the frame (e.g. frames dropped because of
+ * overflow) is skipped. This function shouldn't be mixed with
+ * SerialPort_getCharacter - a frame whose start was already taken by
+ * SerialPort_getCharacter is dropped.
+ * @param frameBuffer Buffer for data (data will be null terminated for easier string manipulation)
+ * @param length Length not including terminator character
+ * @param maximumLength Length of frameBuffer
+ * @retval SERIAL_PORT_GOT_FRAME Received frame
+ * @retval SERIAL_PORT_NO_FRAME_READY No frame in buffer
+ * @retval SERIAL_PORT_FRAME_TOO_LARGE Frame doesn't fit in buffer or didn't fit in RX FIFO (it is dropped)
  */
 SerialPortResultCode SerialPort_getFrame(char* frameBuffer, int* length, int maximumLength) {
-  char receivedByte;
-  *length = 0;
 
-  if (frameCounter) {
-    while (TRUE) {
+  FrameDescriptor frame;
+  *length = 0;
 
-      // no more data and terminator wasn't reached => error
-      if (Fifo_isEmpty(&receiveFifo)) {
-        frameCounter = 0;
-        *length = 0;
-        println("Invalid frame");
-        Fifo_flush(&receiveFifo);
-        return SERIAL_PORT_FRAME_ERROR;
-      }
+  if (!FrameQueue_pop(&frameQueue, &frame)) {
+    return SERIAL_PORT_NO_FRAME_READY;
+  }
 
-      Fifo_pop(&receiveFifo, &receivedByte);
-      frameBuffer[(*length)++] = receivedByte;
+  if ((int)(frame.offset - readBytes) < 0) {
+    // SerialPort_getCharacter already took start of frame - drop the rest
+    int remainingBytes = (int)(frame.offset + frame.length - readBytes);
+    if (remainingBytes > 0) {
+      Fifo_commitRead(&receiveFifo, remainingBytes);
+      readBytes += remainingBytes;
+    }
+    return SERIAL_PORT_NO_FRAME_READY;
+  }
 
-      if (*length >= maximumLength) {
-        frameCounter = 0;
-        *length = 0;
-        println("Frame too long");
-        Fifo_flush(&receiveFifo);
-        return SERIAL_PORT_FRAME_TOO_LARGE;
-      }
+  // skip data between previous and this frame
+  Fifo_commitRead(&receiveFifo, (int)(frame.offset - readBytes));
+  readBytes = frame.offset;
 
-      // if end of frame
-      if (receivedByte == TERMINATOR_CHARACTER) {
-        (*length)--; // length without terminator character
-        frameBuffer[*length] = 0; // terminator character converted to NULL terminator
-        break;
-      }
+  if (frame.isOverflowed || frame.length >= maximumLength) {
+    logWarning("Frame too long");
+    Fifo_commitRead(&receiveFifo, frame.length);
+    readBytes += frame.length;
+    return SERIAL_PORT_FRAME_TOO_LARGE;
+  }
 
-    }
-    frameCounter--;
-    return SERIAL_PORT_GOT_FRAME;
+  Fifo_read(&receiveFifo, frameBuffer, frame.length);
+  readBytes += frame.length;
+  frameBuffer[frame.length] = 0; // terminator character converted to NULL terminator
+  *length = frame.length;
 
-  } else {
-    return SERIAL_PORT_NO_FRAME_READY;
-  }
+  return SERIAL_PORT_GOT_FRAME;
+}
+/**
+ * @brief Sets function called for every received frame.
+ * @details The function is called from the receive interrupt, so it should
+ * only signal the main loop (e.g. Scheduler_postEvents), which then reads
+ * the frame with SerialPort_getFrame.
+ * @param frameCb Callback (NULL to disable)
+ */
+void SerialPort_setFrameCallback(void (*frameCb)(void)) {
+  frameCallback = frameCb;
 }
 /**
  * @brief Callback for receiving data from PC.
- * @param c Data sent from lower layer software.
+ * @details Data is written to RX FIFO in spans between terminators. For every
+ * terminator position of the frame is queued. Frames that didn't fit in the
+ * FIFO are queued as overflowed, so that getFrame removes their data.
+ * Frames that didn't fit in the frame queue are skipped by getFrame.
+ * @param receivedData Data sent from lower layer software.
+ * @param length Number of received bytes.
  */
-void receiveCb(char receivedCharacter) {
-  FifoResultCode result = Fifo_push(&receiveFifo, receivedCharacter);
-  // Checking result to ensure no buffer overflow occurred
-  if ((receivedCharacter == TERMINATOR_CHARACTER) && (result == 0)) {
-    frameCounter++;
+void receiveCb(const char* receivedData, int length) {
+
+  while (length > 0) {
+    const char* terminator = memchr(receivedData, TERMINATOR_CHARACTER, length);
+    // write data including terminator (so that getCharacter gets whole stream)
+    int spanLength = (terminator == NULL) ? length : (terminator - receivedData + 1);
+    int written = Fifo_write(&receiveFifo, receivedData, spanLength);
+    receivedBytes += written;
+
+    if (written < spanLength) {
+      isFrameOverflowed = TRUE;
+    }
+
+    if (terminator != NULL) {
+      FrameDescriptor frame;
+      frame.offset = frameStart;
+      frame.length = (int)(receivedBytes - frameStart);
+      frame.isOverflowed = isFrameOverflowed;
+      if (!isFrameOverflowed) {
+        frame.length--; // without terminator
+      }
+      FrameQueue_push(&frameQueue, &frame);
+      frameStart = receivedBytes;
+      isFrameOverflowed = FALSE;
+      if (frameCallback != NULL) {
+        frameCallback();
+      }
+    }
+
+    receivedData += spanLength;
+    length -= spanLength;
   }
 }
 /**
  * @brief Callback for transmitting data to lower layer
- * @param dataToTransmit Transmitted data
+ * @details The data is sent by DMA directly from the TX FIFO, so it is
+ * removed from the FIFO only after the lower layer has sent it.
+ * @param transmittedLength Number of bytes sent since the last call
+ * @param dataToTransmit Pointer to the next block of data to transmit
  * @return Number of bytes to be transmitted
  */
-int transmitCb(char * dataToTransmit) {
-  if (Fifo_isEmpty(&transmitFifo)) {
-    return 0;
-  }
-  // get all the data at one go
-  int i = 0;
-  while (Fifo_pop(&transmitFifo, dataToTransmit+i) == FIFO_OK) {
-    i++;
+int transmitCb(int transmittedLength, const char** dataToTransmit) {
+  char* data;
+  Fifo_commitRead(&transmitFifo, transmittedLength);
+  int length = Fifo_peekRead(&transmitFifo, &data);
+  *dataToTransmit = data;
+  return length;
+}
+/**
+ * @brief Starts transmitter if it is inactive.
+ * @details Has to be called with interrupts disabled.
+ */
+void startTransmitter(void) {
+  if (!SERIAL_PORT_TRANSPORT.isSendingData()) {
+    SERIAL_PORT_TRANSPORT.sendData();
   }
-  return i;
 }
 /**
  * @}
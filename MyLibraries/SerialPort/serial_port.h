@@ -23,12 +23,36 @@
 /**
  * @defgroup  SERIAL_PORT SERIAL_PORT
  * @brief     Communication with PC functions.
+ *
+ * @details Data goes to PC through a transport selected at compile time
+ * with SERIAL_PORT_TRANSPORT: UART (default), USB virtual COM port (default
+ * with USE_USB_CDC defined) or loopback for testing on host.
  */
 
 /**
  * @addtogroup SERIAL_PORT
  * @{
  */
+#ifndef SERIAL_PORT_RECEIVE_BUFFER_LENGTH
+  #define SERIAL_PORT_RECEIVE_BUFFER_LENGTH  256 ///< Receive buffer length (power of two)
+#endif
+
+#ifndef SERIAL_PORT_TRANSMIT_BUFFER_LENGTH
+  #define SERIAL_PORT_TRANSMIT_BUFFER_LENGTH 512 ///< Transmit buffer length (power of two)
+#endif
+
+#ifndef SERIAL_PORT_TRANSPORT
+  #ifdef USE_USB_CDC
+    #define SERIAL_PORT_TRANSPORT SerialTransport_usbCdc ///< Lower layer (see serial_transport.h)
+  #else
+    #define SERIAL_PORT_TRANSPORT SerialTransport_uart   ///< Lower layer (see serial_transport.h)
+  #endif
+#endif
+
+#ifndef SERIAL_PORT_MAX_FRAMES
+  #define SERIAL_PORT_MAX_FRAMES             8   ///< Number of received frames waiting for getFrame (power of two)
+#endif
+
 /**
  * @brief Communication errors
  */
@@ -41,9 +65,11 @@ typedef enum {
 
 void                 SerialPort_initialize   (int baudRate);
 void                 SerialPort_putCharacter (char characterToSend);
+void                 SerialPort_write        (const char* data, int length);
 char                 SerialPort_getCharacter (void);
 SerialPortResultCode SerialPort_getFrame     (char* frameBuffer, int* length, int maximumLength);
 void                 SerialPort_printLine    (char* line);
+void                 SerialPort_setFrameCallback (void (*frameCb)(void));
 /**
  * @}
  */
@@ -0,0 +1,50 @@
+/**
+ * @file    serial_transport.h
+ * @brief   Lower layers for communication with PC.
+ * @date    18.10.2026
+ * @author  Michal Ksiezopolski
+ *
+ * @verbatim
+ * Copyright (c) 2026 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef SERIAL_TRANSPORT_H_
+#define SERIAL_TRANSPORT_H_
+
+#include "utils.h"
+
+/**
+ * @addtogroup SERIAL_PORT
+ * @{
+ */
+
+/**
+ * @brief Lower layer of serial port.
+ * @details The transport calls receive callback with spans of received data
+ * and takes data to send with transmit callback, which releases the data
+ * sent previously and returns the next block (see Usart_initialize).
+ */
+typedef struct {
+  void    (*initialize)   (int baudRate, void(*receiveCb)(const char*, int),
+      int(*transmitCb)(int, const char**)); ///< Initializes transport
+  Boolean (*isSendingData)(void);           ///< Checks if transport is sending data
+  void    (*sendData)     (void);           ///< Starts sending data
+} SerialTransport;
+
+extern const SerialTransport SerialTransport_uart;      ///< UART with DMA
+extern const SerialTransport SerialTransport_frameUart; ///< UART with DMA used by SerialFrame
+extern const SerialTransport SerialTransport_usbCdc;    ///< USB virtual COM port (needs USE_USB_CDC)
+extern const SerialTransport SerialTransport_loopback;  ///< Sent data is received back (for testing on host)
+
+/**
+ * @}
+ */
+
+#endif /* SERIAL_TRANSPORT_H_ */
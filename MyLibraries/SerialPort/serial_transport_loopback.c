@@ -0,0 +1,87 @@
+/**
+ * @file    serial_transport_loopback.c
+ * @brief   Loopback transport for testing serial port on host.
+ * @date    18.10.2026
+ * @author  Michal Ksiezopolski
+ *
+ * @verbatim
+ * Copyright (c) 2026 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include "serial_transport.h"
+#include <stddef.h>
+
+/**
+ * @addtogroup SERIAL_PORT
+ * @{
+ */
+
+static void (*receiveCallback)(const char*, int);  ///< Callback for received data
+static int  (*transmitCallback)(int, const char**);///< Callback for data to transmit
+static Boolean isSending;                          ///< Loopback in progress
+
+static void initialize(int baudRate, void(*receiveCb)(const char*, int),
+    int(*transmitCb)(int, const char**));
+static Boolean isSendingData(void);
+static void sendData(void);
+
+const SerialTransport SerialTransport_loopback = {
+  initialize,
+  isSendingData,
+  sendData,
+};
+
+/**
+ * @brief Initializes loopback.
+ * @param baudRate Not used
+ * @param receiveCb Callback for received data
+ * @param transmitCb Callback for data to transmit
+ */
+static void initialize(int baudRate, void(*receiveCb)(const char*, int),
+    int(*transmitCb)(int, const char**)) {
+  (void)baudRate;
+  receiveCallback = receiveCb;
+  transmitCallback = transmitCb;
+}
+/**
+ * @brief Checks if loopback is in progress.
+ * @retval TRUE Sending data
+ * @retval FALSE Not sending
+ */
+static Boolean isSendingData(void) {
+  return isSending;
+}
+/**
+ * @brief Passes all data to send back to receive callback.
+ * @details Data is sent synchronously, in the same blocks as a DMA
+ * transport would send it.
+ */
+static void sendData(void) {
+
+  if (isSending || transmitCallback == NULL) {
+    return;
+  }
+  isSending = TRUE;
+
+  const char* data;
+  int length = transmitCallback(0, &data);
+  while (length > 0) {
+    if (receiveCallback != NULL) {
+      receiveCallback(data, length);
+    }
+    length = transmitCallback(length, &data);
+  }
+
+  isSending = FALSE;
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,106 @@
+/**
+ * @file    serial_transport_uart.c
+ * @brief   UART transport for communication with PC.
+ * @date    18.10.2026
+ * @author  Michal Ksiezopolski
+ *
+ * @verbatim
+ * Copyright (c) 2026 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include "serial_transport.h"
+#include "usart.h"
+
+/**
+ * @addtogroup SERIAL_PORT
+ * @{
+ */
+
+#if defined(USE_F7_DISCOVERY)
+  #define SERIAL_PORT_USART  USART_HAL_USART6 ///< UART of SerialPort
+  #define SERIAL_FRAME_USART USART_HAL_USART1 ///< UART of SerialFrame
+#else
+  #define SERIAL_PORT_USART  USART_HAL_USART2 ///< UART of SerialPort
+  #define SERIAL_FRAME_USART USART_HAL_USART6 ///< UART of SerialFrame
+#endif
+
+static void initialize(int baudRate, void(*receiveCb)(const char*, int),
+    int(*transmitCb)(int, const char**));
+static Boolean isSendingData(void);
+static void sendData(void);
+static void initializeFrameUart(int baudRate, void(*receiveCb)(const char*, int),
+    int(*transmitCb)(int, const char**));
+static Boolean isFrameUartSendingData(void);
+static void sendFrameUartData(void);
+
+const SerialTransport SerialTransport_uart = {
+  initialize,
+  isSendingData,
+  sendData,
+};
+
+const SerialTransport SerialTransport_frameUart = {
+  initializeFrameUart,
+  isFrameUartSendingData,
+  sendFrameUartData,
+};
+
+/**
+ * @brief Initializes UART connected to PC.
+ * @param baudRate Baud rate
+ * @param receiveCb Callback for received data
+ * @param transmitCb Callback for data to transmit
+ */
+static void initialize(int baudRate, void(*receiveCb)(const char*, int),
+    int(*transmitCb)(int, const char**)) {
+  Usart_initialize(SERIAL_PORT_USART, baudRate, receiveCb, transmitCb);
+}
+/**
+ * @brief Checks if UART is sending data.
+ * @retval TRUE Sending data
+ * @retval FALSE Not sending
+ */
+static Boolean isSendingData(void) {
+  return Usart_isSendingData(SERIAL_PORT_USART);
+}
+/**
+ * @brief Starts sending data.
+ */
+static void sendData(void) {
+  Usart_sendDataIrq(SERIAL_PORT_USART);
+}
+/**
+ * @brief Initializes UART of binary frames.
+ * @param baudRate Baud rate
+ * @param receiveCb Callback for received data
+ * @param transmitCb Callback for data to transmit
+ */
+static void initializeFrameUart(int baudRate, void(*receiveCb)(const char*, int),
+    int(*transmitCb)(int, const char**)) {
+  Usart_initialize(SERIAL_FRAME_USART, baudRate, receiveCb, transmitCb);
+}
+/**
+ * @brief Checks if UART of binary frames is sending data.
+ * @retval TRUE Sending data
+ * @retval FALSE Not sending
+ */
+static Boolean isFrameUartSendingData(void) {
+  return Usart_isSendingData(SERIAL_FRAME_USART);
+}
+/**
+ * @brief Starts sending binary frames.
+ */
+static void sendFrameUartData(void) {
+  Usart_sendDataIrq(SERIAL_FRAME_USART);
+}
+
+/**
+ * @}
+ */
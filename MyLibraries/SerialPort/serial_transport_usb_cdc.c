@@ -0,0 +1,52 @@
+/**
+ * @file    serial_transport_usb_cdc.c
+ * @brief   USB virtual COM port transport for communication with PC.
+ * @date    18.10.2026
+ * @author  Michal Ksiezopolski
+ *
+ * @verbatim
+ * Copyright (c) 2026 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifdef USE_USB_CDC
+
+#include "serial_transport.h"
+#include "usb_cdc.h"
+
+/**
+ * @addtogroup SERIAL_PORT
+ * @{
+ */
+
+static void initialize(int baudRate, void(*receiveCb)(const char*, int),
+    int(*transmitCb)(int, const char**));
+
+const SerialTransport SerialTransport_usbCdc = {
+  initialize,
+  UsbCdc_isSendingData,
+  UsbCdc_sendDataIrq,
+};
+
+/**
+ * @brief Initializes USB virtual COM port.
+ * @param baudRate Not used (host sets the baud rate of the virtual port)
+ * @param receiveCb Callback for received data
+ * @param transmitCb Callback for data to transmit
+ */
+static void initialize(int baudRate, void(*receiveCb)(const char*, int),
+    int(*transmitCb)(int, const char**)) {
+  UsbCdc_initialize(receiveCb, transmitCb);
+}
+
+/**
+ * @}
+ */
+
+#endif /* USE_USB_CDC */
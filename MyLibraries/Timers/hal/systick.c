@@ -16,6 +16,8 @@
  */
 
 #include "systick.h"
+#include "common_hal.h"
+#include "utils.h"
 #ifdef USE_F4_DISCOVERY
   #include <stm32f4xx_hal.h>
 #endif
@@ -33,7 +35,19 @@
  * @{
  */
 
+#define DWT_LOCK_ACCESS_KEY 0xc5acce55 ///< Unlocks DWT registers on Cortex-M7
+#define WAKEUP_TICKS_PER_MILLI  10     ///< Wakeup timer runs at 10 kHz
+#define MAX_SLEEP_MILLIS        60000  ///< Longest sleep (system time is corrected at least this often)
+#define TICK_RELOAD (SystemCoreClock / 1000) ///< SysTick cycles in a millisecond (HAL_InitTick at 1 kHz)
+
+extern __IO uint32_t uwTick; ///< HAL tick counter (not declared in HAL header)
+
 static volatile unsigned int systemClockMillis;  ///< System clock timer.
+static volatile uint32_t systemClockMillisHigh;  ///< Upper word of 64-bit system time (overflows of systemClockMillis)
+static TIM_HandleTypeDef wakeupTimerHandle; ///< Timer measuring sleep time
+static Boolean isWakeupTimerInitialized = FALSE; ///< Wakeup timer was configured
+
+static void initializeWakeupTimer(void);
 
 /**
  * @brief Get the system time
@@ -42,12 +56,188 @@ static volatile unsigned int systemClockMillis;  ///< System clock timer.
 unsigned int SysTick_getTimeMillis(void) {
   return systemClockMillis;
 }
+/**
+ * @brief Get the system time with microsecond resolution
+ * @details The time is read without disabling interrupts. Millisecond
+ * count is read again if SysTick interrupt came during the read. If the
+ * interrupt is pending (interrupts are masked), the counter has wrapped
+ * around and the pending millisecond is added. The 64-bit time doesn't
+ * overflow during the life of the device. The first SysTick period after
+ * sleep is shortened to keep the phase of the millisecond, so the
+ * counter is always converted with the full reload value.
+ * @return System time in microseconds
+ */
+uint64_t SysTick_getTimeMicros(void) {
+
+  uint32_t high, millis, counter, pendingMillis;
+
+  do {
+    high = systemClockMillisHigh;
+    millis = systemClockMillis;
+    counter = SysTick->VAL;
+    pendingMillis = (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) ? 1 : 0;
+    if (pendingMillis) {
+      counter = SysTick->VAL; // read after the wrap
+    }
+  } while (high != systemClockMillisHigh || millis != systemClockMillis);
+
+  uint32_t reload = TICK_RELOAD;
+  uint32_t micros = (reload - 1 - counter) * 1000 / reload;
+  uint64_t timeMillis = (((uint64_t)high << 32) | millis) + pendingMillis;
+
+  return timeMillis * 1000 + micros;
+}
+/**
+ * @brief Starts the DWT cycle counter.
+ * @details The counter runs at core clock and doesn't need any interrupts.
+ * It isn't reset, so the function can be called by every user of the counter.
+ */
+void SysTick_initializeCycleCounter(void) {
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk; // enable DWT
+#ifdef USE_F7_DISCOVERY
+  DWT->LAR = DWT_LOCK_ACCESS_KEY; // DWT is locked after reset on Cortex-M7
+#endif
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+/**
+ * @brief Returns value of the cycle counter.
+ * @details Counter wraps around every 2^32 cycles (about 25 s at 168 MHz).
+ * @return Number of core clock cycles
+ */
+uint32_t SysTick_getCycles(void) {
+  return DWT->CYCCNT;
+}
+/**
+ * @brief Returns number of cycle counter ticks in a microsecond.
+ * @return Core clock cycles per microsecond
+ */
+uint32_t SysTick_getCyclesPerMicrosecond(void) {
+  return SystemCoreClock / 1000000;
+}
+/**
+ * @brief Sleeps with SysTick interrupt stopped.
+ * @details The core waits in sleep mode (WFI) until the TIM2 one-shot
+ * expires or any other interrupt comes. The time measured by TIM2 is then
+ * added to the system time, so SysTick doesn't have to wake the core every
+ * millisecond. Peripherals keep running, so a received byte or finished DMA
+ * transfer wakes the core early. Interrupt handlers run after the system
+ * time is corrected.
+ *
+ * The SysTick counter keeps running during sleep, but out of step with the
+ * time added. So the part of the millisecond which passed before sleep is
+ * read from SysTick and carried over the sleep, and SysTick is restarted
+ * with a shortened period at the carried phase. Time measured by TIM2 is
+ * rounded down, so SysTick_getTimeMicros never steps backwards.
+ * @param millis Maximum sleep time
+ */
+void SysTick_sleepMillis(unsigned int millis) {
+
+  if (millis == 0) {
+    return;
+  }
+  if (!isWakeupTimerInitialized) {
+    initializeWakeupTimer();
+  }
+  if (millis > MAX_SLEEP_MILLIS) {
+    millis = MAX_SLEEP_MILLIS;
+  }
+
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq(); // pending interrupts still wake WFI, but run after compensation
+
+  // part of the current millisecond (the pending one, if SysTick already wrapped)
+  uint32_t reload = TICK_RELOAD;
+  uint32_t elapsedCycles = reload - 1 - SysTick->VAL;
+  if (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) {
+    elapsedCycles = 2 * reload - 1 - SysTick->VAL; // read after the wrap
+  }
+
+  HAL_SuspendTick();
+  __HAL_TIM_SET_AUTORELOAD(&wakeupTimerHandle, millis * WAKEUP_TICKS_PER_MILLI - 1);
+  __HAL_TIM_SET_COUNTER(&wakeupTimerHandle, 0);
+  __HAL_TIM_CLEAR_FLAG(&wakeupTimerHandle, TIM_FLAG_UPDATE);
+  __HAL_TIM_ENABLE(&wakeupTimerHandle); // one pulse mode stops timer on update
+
+  __DSB();
+  __WFI();
+
+  uint32_t sleptTicks;
+  if (__HAL_TIM_GET_FLAG(&wakeupTimerHandle, TIM_FLAG_UPDATE) != RESET) {
+    sleptTicks = millis * WAKEUP_TICKS_PER_MILLI;
+  } else {
+    sleptTicks = __HAL_TIM_GET_COUNTER(&wakeupTimerHandle);
+  }
+  __HAL_TIM_DISABLE(&wakeupTimerHandle);
+  __HAL_TIM_CLEAR_FLAG(&wakeupTimerHandle, TIM_FLAG_UPDATE);
+  HAL_NVIC_ClearPendingIRQ(TIM2_IRQn);
+
+  elapsedCycles += (sleptTicks % WAKEUP_TICKS_PER_MILLI) * (reload / WAKEUP_TICKS_PER_MILLI);
+  uint32_t sleptMillis = sleptTicks / WAKEUP_TICKS_PER_MILLI + elapsedCycles / reload;
+  uint32_t phaseCycles = elapsedCycles % reload;
+  if (phaseCycles > reload - 2) {
+    phaseCycles = reload - 2; // reload value 0 would stop SysTick
+  }
+  systemClockMillis += sleptMillis;
+  if (systemClockMillis < sleptMillis) {
+    systemClockMillisHigh++;
+  }
+  uwTick += sleptMillis;
+
+  // restart SysTick in phase with the carried part of millisecond
+  SysTick->LOAD = reload - 1 - phaseCycles;
+  SysTick->VAL = 0; // counter is reloaded on the next clock
+  __DSB();
+  SysTick->LOAD = reload - 1; // used from the next wrap
+  SCB->ICSR = SCB_ICSR_PENDSTCLR_Msk; // pending millisecond is already counted
+  HAL_ResumeTick();
+
+  __set_PRIMASK(primask);
+}
 /**
  * @brief Interrupt handler for SysTick.
  */
 void SysTick_Handler(void) {
   HAL_IncTick();
   systemClockMillis++; // Update system time
+  if (systemClockMillis == 0) {
+    systemClockMillisHigh++;
+  }
+}
+/**
+ * @brief Interrupt handler for wakeup timer.
+ * @details The flag is normally cleared by SysTick_sleepMillis before
+ * interrupts are enabled.
+ */
+void TIM2_IRQHandler(void) {
+  __HAL_TIM_CLEAR_FLAG(&wakeupTimerHandle, TIM_FLAG_UPDATE);
+}
+
+/**
+ * @brief Configures TIM2 as one-shot wakeup timer.
+ * @details TIM2 is a 32-bit timer clocked at half of the core clock on
+ * both boards. Its interrupt is enabled only to wake the core.
+ */
+static void initializeWakeupTimer(void) {
+
+  __HAL_RCC_TIM2_CLK_ENABLE();
+
+  wakeupTimerHandle.Instance = TIM2;
+  wakeupTimerHandle.Init.Prescaler = (SystemCoreClock / 2) / (WAKEUP_TICKS_PER_MILLI * 1000) - 1;
+  wakeupTimerHandle.Init.Period = 0xffffffff;
+  wakeupTimerHandle.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+  wakeupTimerHandle.Init.CounterMode = TIM_COUNTERMODE_UP;
+  wakeupTimerHandle.Init.RepetitionCounter = 0;
+  if (HAL_TIM_Base_Init(&wakeupTimerHandle) != HAL_OK) {
+    CommonHal_errorHandler();
+  }
+  wakeupTimerHandle.Instance->CR1 |= TIM_CR1_OPM;
+  __HAL_TIM_CLEAR_FLAG(&wakeupTimerHandle, TIM_FLAG_UPDATE);
+  __HAL_TIM_ENABLE_IT(&wakeupTimerHandle, TIM_IT_UPDATE);
+
+  HAL_NVIC_SetPriority(TIM2_IRQn, 15, 0);
+  HAL_NVIC_EnableIRQ(TIM2_IRQn);
+
+  isWakeupTimerInitialized = TRUE;
 }
 
 /**
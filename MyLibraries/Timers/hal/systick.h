@@ -18,6 +18,8 @@
 #ifndef SYSTICK_H_
 #define SYSTICK_H_
 
+#include <inttypes.h>
+
 /**
  * @defgroup  SYSTICK SYSTICK
  * @brief     SYSTICK control functions.
@@ -27,7 +29,12 @@
  * @addtogroup SYSTICK
  * @{
  */
-unsigned int  SysTick_getTimeMillis (void);
+unsigned int  SysTick_getTimeMillis           (void);
+uint64_t      SysTick_getTimeMicros           (void);
+void          SysTick_initializeCycleCounter  (void);
+uint32_t      SysTick_getCycles               (void);
+uint32_t      SysTick_getCyclesPerMicrosecond (void);
+void          SysTick_sleepMillis             (unsigned int millis);
 
 /**
  * @}
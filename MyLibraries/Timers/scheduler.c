@@ -0,0 +1,299 @@
+/**
+ * @file    scheduler.c
+ * @brief   Cooperative run-to-completion task scheduler.
+ * @date    18.10.2026
+ * @author  Michal Ksiezopolski
+ *
+ * @verbatim
+ * Copyright (c) 2026 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include "scheduler.h"
+#include "timers.h"
+#include "systick.h"
+#include "common_hal.h"
+#include "deferred.h"
+#include <stdio.h>
+
+#define LOG_MODULE_PREFIX "SCHED--> "         ///< Prefix of log lines
+#define LOG_MODULE_LEVEL  LOG_LEVEL_SCHEDULER ///< Set with -DLOG_LEVEL_SCHEDULER=<level>
+#include "log_module.h"
+
+/**
+ * @addtogroup SCHEDULER
+ * @{
+ */
+
+#define ID_TO_ARRAY_INDEX(x)  (x-1) ///< Converts task ID to array index
+#define ARRAY_INDEX_TO_ID(x)  (x+1) ///< Converts array index to task ID
+
+typedef char SCHEDULER_tasksFitInReadyMask[(SCHEDULER_MAX_TASKS <= 32) ? 1 : -1];
+
+/**
+ * @brief Task structure.
+ */
+typedef struct {
+  const char* name;                   ///< Name in report
+  int priority;                       ///< Priority (lower value runs first)
+  void (*taskFunction)(uint32_t);     ///< Function called with posted events
+  volatile uint32_t events;           ///< Events posted since last run
+  int timerId;                        ///< Soft timer posting SCHEDULER_EVENT_TIMER (0 if none)
+  uint32_t runCount;                  ///< Number of runs since last report
+  uint64_t totalCycles;               ///< Core cycles spent in task since last report
+  uint32_t maxCycles;                 ///< Longest run since last report
+} Task;
+
+static Task tasks[SCHEDULER_MAX_TASKS]; ///< Registered tasks
+static int taskCount;                   ///< Number of registered tasks
+static volatile uint32_t readyTasks;    ///< Bit for every task with posted events
+static uint64_t reportStartMicros;      ///< Start of time covered by report
+
+static Task* getTask(int id);
+static SchedulerResultCode startTimer(Task* task, unsigned int millis, Boolean isPeriodic);
+static void timerCallback(void* argument);
+
+/**
+ * @brief Adds a task.
+ * @param name Task name for the CPU time report
+ * @param priority Task priority (0 is the highest, like for interrupts).
+ * Tasks with equal priority run in the order they were added.
+ * @param taskFunction Function called with the events posted since its
+ * previous run (it should return quickly)
+ * @return Task ID or error code
+ * @retval SCHEDULER_TOO_MANY_TASKS Too many tasks
+ */
+int Scheduler_addTask(const char* name, int priority, void (*taskFunction)(uint32_t events)) {
+
+  if (taskCount >= SCHEDULER_MAX_TASKS) {
+    logError("Reached maximum number of tasks!");
+    return SCHEDULER_TOO_MANY_TASKS;
+  }
+
+  if (taskCount == 0) {
+    SysTick_initializeCycleCounter(); // for CPU time of tasks
+    reportStartMicros = Timer_getTimeMicros();
+  }
+
+  Task* task = &tasks[taskCount];
+  task->name = name;
+  task->priority = priority;
+  task->taskFunction = taskFunction;
+  task->events = 0;
+  task->timerId = 0;
+
+  taskCount++;
+  return ARRAY_INDEX_TO_ID(taskCount - 1);
+}
+/**
+ * @brief Posts events to a task.
+ * @details Can be called from interrupts. Events are ORed with events
+ * which weren't handled yet, so the task runs once for many posts.
+ * @param taskId Task ID
+ * @param events Bit mask of events (meaning is defined by the task)
+ */
+void Scheduler_postEvents(int taskId, uint32_t events) {
+
+  Task* task = getTask(taskId);
+  if (task == NULL || events == 0) {
+    return;
+  }
+  // atomic (LDREX/STREX), so interrupts of any priority can post
+  __atomic_fetch_or(&task->events, events, __ATOMIC_RELAXED);
+  __atomic_fetch_or(&readyTasks, 1u << ID_TO_ARRAY_INDEX(taskId), __ATOMIC_RELEASE);
+}
+/**
+ * @brief Posts SCHEDULER_EVENT_TIMER to task after given time.
+ * @details Replaces previous wakeup of the task.
+ * @param taskId Task ID
+ * @param millis Time to wakeup
+ * @retval SCHEDULER_OK Wakeup started
+ * @retval SCHEDULER_INVALID_TASK Wrong task ID
+ * @retval SCHEDULER_TOO_MANY_TIMERS No free soft timer
+ */
+SchedulerResultCode Scheduler_wakeAfterMillis(int taskId, unsigned int millis) {
+
+  Task* task = getTask(taskId);
+  if (task == NULL) {
+    return SCHEDULER_INVALID_TASK;
+  }
+  return startTimer(task, millis, FALSE);
+}
+/**
+ * @brief Posts SCHEDULER_EVENT_TIMER to task periodically.
+ * @details Replaces previous wakeup of the task.
+ * @param taskId Task ID
+ * @param periodMillis Wakeup period
+ * @retval SCHEDULER_OK Wakeups started
+ * @retval SCHEDULER_INVALID_TASK Wrong task ID
+ * @retval SCHEDULER_TOO_MANY_TIMERS No free soft timer
+ */
+SchedulerResultCode Scheduler_wakeEveryMillis(int taskId, unsigned int periodMillis) {
+
+  Task* task = getTask(taskId);
+  if (task == NULL) {
+    return SCHEDULER_INVALID_TASK;
+  }
+  return startTimer(task, periodMillis, TRUE);
+}
+/**
+ * @brief Stops timer wakeups of a task.
+ * @param taskId Task ID
+ */
+void Scheduler_stopWakeups(int taskId) {
+
+  Task* task = getTask(taskId);
+  if (task == NULL || task->timerId == 0) {
+    return;
+  }
+  Timer_deleteSoftwareTimer(task->timerId);
+  task->timerId = 0;
+}
+/**
+ * @brief Runs the highest priority task with posted events.
+ * @details Core cycles spent in the task are added to its CPU time.
+ * @retval TRUE A task was ready
+ * @retval FALSE No task has events
+ */
+Boolean Scheduler_runNextTask(void) {
+
+  uint32_t ready = __atomic_load_n(&readyTasks, __ATOMIC_ACQUIRE);
+  if (ready == 0) {
+    return FALSE;
+  }
+
+  int nextIndex = -1;
+  while (ready != 0) {
+    int index = __builtin_ctz(ready);
+    ready &= ready - 1;
+    if (nextIndex < 0 || tasks[index].priority < tasks[nextIndex].priority) {
+      nextIndex = index;
+    }
+  }
+
+  Task* task = &tasks[nextIndex];
+  // clear ready bit before taking events, so events posted in between run the task again
+  __atomic_fetch_and(&readyTasks, ~(1u << nextIndex), __ATOMIC_RELAXED);
+  uint32_t events = __atomic_exchange_n(&task->events, 0, __ATOMIC_ACQUIRE);
+  if (events == 0) {
+    return TRUE;
+  }
+
+  uint32_t startCycles = SysTick_getCycles();
+  task->taskFunction(events);
+  uint32_t cycles = SysTick_getCycles() - startCycles;
+
+  task->runCount++;
+  task->totalCycles += cycles;
+  if (cycles > task->maxCycles) {
+    task->maxCycles = cycles;
+  }
+  return TRUE;
+}
+/**
+ * @brief Runs tasks forever.
+ * @details Soft timers and calls deferred by interrupts (Deferred_call)
+ * are processed before every task, so they can't be delayed by more than
+ * one task run. When no task is ready, the core sleeps until the next soft
+ * timer or interrupt. Ready tasks are checked with interrupts disabled, so
+ * an event posted right before sleep isn't missed (the pending interrupt
+ * ends the sleep).
+ */
+void Scheduler_run(void) {
+
+  while (TRUE) {
+    Timer_softwareTimersUpdate();
+    Deferred_process();
+    if (Scheduler_runNextTask()) {
+      continue;
+    }
+    uint32_t interruptState = CommonHal_disableInterrupts();
+    if (readyTasks == 0 && Deferred_isEmpty()) {
+      Timer_sleepUntilNextTimer();
+    }
+    CommonHal_restoreInterrupts(interruptState);
+  }
+}
+/**
+ * @brief Prints CPU time of every task.
+ * @details Statistics cover time since the previous report and are reset.
+ * Time not used by tasks was spent in interrupts, timer callbacks and sleep.
+ */
+void Scheduler_printReport(void) {
+
+  uint64_t currentTimeMicros = Timer_getTimeMicros();
+  uint32_t reportMicros = (uint32_t)(currentTimeMicros - reportStartMicros);
+  uint32_t cyclesPerMicrosecond = SysTick_getCyclesPerMicrosecond();
+
+  printf("Task             Prio    Runs   Total[us]   Max[us]   CPU[%%]\r\n");
+
+  for (int i = 0; i < taskCount; i++) {
+    Task* task = &tasks[i];
+    uint32_t totalMicros = (uint32_t)(task->totalCycles / cyclesPerMicrosecond);
+    // CPU time in hundredths of percent
+    uint32_t load = (reportMicros > 0) ?
+        (uint32_t)((uint64_t)totalMicros * 10000 / reportMicros) : 0;
+
+    printf("%-16s %4d %7lu %11lu %9lu %4lu.%02lu\r\n", task->name, task->priority,
+        (unsigned long)task->runCount, (unsigned long)totalMicros,
+        (unsigned long)(task->maxCycles / cyclesPerMicrosecond),
+        (unsigned long)(load / 100), (unsigned long)(load % 100));
+
+    task->runCount = 0;
+    task->totalCycles = 0;
+    task->maxCycles = 0;
+  }
+  reportStartMicros = currentTimeMicros;
+}
+
+/**
+ * @brief Finds task with given ID.
+ * @param id Task ID
+ * @return Task or NULL if ID isn't valid
+ */
+static Task* getTask(int id) {
+  if (id < 1 || id > taskCount) {
+    return NULL;
+  }
+  return &tasks[ID_TO_ARRAY_INDEX(id)];
+}
+/**
+ * @brief Starts timer posting SCHEDULER_EVENT_TIMER to task.
+ * @param task Task
+ * @param millis Timer overflow value
+ * @param isPeriodic TRUE for periodic wakeups
+ * @retval SCHEDULER_OK Timer started
+ * @retval SCHEDULER_TOO_MANY_TIMERS No free soft timer
+ */
+static SchedulerResultCode startTimer(Task* task, unsigned int millis, Boolean isPeriodic) {
+
+  if (task->timerId != 0) {
+    Timer_deleteSoftwareTimer(task->timerId);
+  }
+
+  task->timerId = Timer_addSoftwareTimerWithArgument(millis, isPeriodic, timerCallback, task);
+  if (task->timerId < 0) {
+    task->timerId = 0;
+    return SCHEDULER_TOO_MANY_TIMERS;
+  }
+  Timer_startSoftwareTimer(task->timerId);
+  return SCHEDULER_OK;
+}
+/**
+ * @brief Posts timer event to the task of the timer.
+ * @param argument Task
+ */
+static void timerCallback(void* argument) {
+  Task* task = (Task*)argument;
+  Scheduler_postEvents(ARRAY_INDEX_TO_ID(task - tasks), SCHEDULER_EVENT_TIMER);
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,70 @@
+/**
+ * @file    scheduler.h
+ * @brief   Cooperative run-to-completion task scheduler.
+ * @date    18.10.2026
+ * @author  Michal Ksiezopolski
+ *
+ * @verbatim
+ * Copyright (c) 2026 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef SCHEDULER_H_
+#define SCHEDULER_H_
+
+#include "utils.h"
+
+/**
+ * @defgroup  SCHEDULER SCHEDULER
+ * @brief     Cooperative task scheduler
+ *
+ * @details A task is a function called with the events posted to it since
+ * its previous run. It runs to completion and is called again only when
+ * new events are posted, either by code (also interrupts) or by its timer.
+ * From all tasks with events the one with the highest priority runs first.
+ * When no task has events, the core sleeps until the next soft timer or
+ * interrupt.
+ */
+
+/**
+ * @addtogroup SCHEDULER
+ * @{
+ */
+
+#ifndef SCHEDULER_MAX_TASKS
+  #define SCHEDULER_MAX_TASKS 16 ///< Maximum number of tasks (up to 32)
+#endif
+
+#define SCHEDULER_EVENT_TIMER 0x80000000 ///< Event posted by the timer of a task
+
+/**
+ * @brief Scheduler errors
+ */
+typedef enum {
+  SCHEDULER_OK = 0,                 //!< SCHEDULER_OK
+  SCHEDULER_TOO_MANY_TASKS = -100,  //!< SCHEDULER_TOO_MANY_TASKS
+  SCHEDULER_INVALID_TASK = -101,    //!< SCHEDULER_INVALID_TASK
+  SCHEDULER_TOO_MANY_TIMERS = -102, //!< SCHEDULER_TOO_MANY_TIMERS
+} SchedulerResultCode;
+
+int                 Scheduler_addTask         (const char* name, int priority,
+    void (*taskFunction)(uint32_t events));
+void                Scheduler_postEvents      (int taskId, uint32_t events);
+SchedulerResultCode Scheduler_wakeAfterMillis (int taskId, unsigned int millis);
+SchedulerResultCode Scheduler_wakeEveryMillis (int taskId, unsigned int periodMillis);
+void                Scheduler_stopWakeups     (int taskId);
+Boolean             Scheduler_runNextTask     (void);
+void                Scheduler_run             (void);
+void                Scheduler_printReport     (void);
+
+/**
+ * @}
+ */
+
+#endif /* SCHEDULER_H_ */
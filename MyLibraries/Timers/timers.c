@@ -20,48 +20,75 @@
 
 #include "timers.h"
 #include "systick.h"
-#include "hardware_timers.h"
+#include "common_hal.h"
 #include <stdio.h>
 
-#ifndef DEBUG_TIMERS
-  #define DEBUG_TIMERS
-#endif
-
-#ifdef DEBUG_TIMERS
-  #define print(str, args...) printf("TIMER--> "str"%s",##args,"\r")
-  #define println(str, args...) printf("TIMER--> "str"%s",##args,"\r\n")
-#else
-  #define print(str, args...) (void)0
-  #define println(str, args...) (void)0
-#endif
+#define LOG_MODULE_PREFIX "TIMER--> "      ///< Prefix of log lines
+#define LOG_MODULE_LEVEL  LOG_LEVEL_TIMERS ///< Set with -DLOG_LEVEL_TIMERS=<level>
+#include "log_module.h"
 
 /**
  * @addtogroup TIMER
  * @{
  */
 
-#define MAX_SOFT_TIMERS       10    ///< Maximum number of soft timers.
-#define ID_TO_ARRAY_INDEX(x)  (x-1) ///< Converts timer ID to array index
+#define WHEEL_MASK            (TIMER_WHEEL_SLOTS-1) ///< Mask converting time to wheel slot
+#define ID_TO_ARRAY_INDEX(x)  (x-1)                 ///< Converts timer ID to array index
+#define ARRAY_INDEX_TO_ID(x)  (x+1)                 ///< Converts array index to timer ID
+
+typedef char TIMER_wheelSlotsArePowerOfTwo[IS_POWER_OF_TWO(TIMER_WHEEL_SLOTS) ? 1 : -1];
+
+/**
+ * @brief Link of doubly linked list of timers.
+ * @details Every wheel slot is a circular list with the slot itself as
+ * sentinel, so timers are inserted and removed without any checks.
+ */
+typedef struct TimerLink {
+  struct TimerLink* next;     ///< Next timer in list
+  struct TimerLink* previous; ///< Previous timer in list
+} TimerLink;
+
+/**
+ * @brief State of soft timer.
+ */
+typedef enum {
+  TIMER_STATE_FREE = 0, ///< Timer not allocated
+  TIMER_STATE_STOPPED,  ///< Timer allocated, but not counting
+  TIMER_STATE_RUNNING,  ///< Timer waiting in wheel
+  TIMER_STATE_PAUSED,   ///< Timer stopped with remaining time saved
+} TimerState;
 
 /**
  * @brief Soft timer structure.
  */
 typedef struct {
-  int id;                     ///< Timer ID
-  unsigned int currentCount;  ///< Current count value
-  unsigned int overflowValue; ///< Overflow value
-  Boolean isActive;           ///< Is timer active?
+  TimerLink link;             ///< Link in wheel slot (has to be first)
+  uint32_t expiryMillis;      ///< System time of expiry (remaining time when paused)
+  uint32_t periodMillis;      ///< Overflow value
   void (*overflowCb)(void);   ///< Function called on overflow event
+  void (*overflowArgumentCb)(void*); ///< Function called on overflow event with argument
+  void* argument;             ///< Argument of overflowArgumentCb
+  uint8_t state;              ///< Timer state (TimerState)
+  Boolean isPeriodic;         ///< Is timer restarted on overflow?
 } TIMER_SoftTimerTypedef;
 
-static TIMER_SoftTimerTypedef softTimers[MAX_SOFT_TIMERS]; ///< Array of soft timers
-static int softTimerCount; ///< Count number of soft timers
-static volatile unsigned int systemClockMicros;
-static Boolean isMicrosCounterInitialized = FALSE;
+static TIMER_SoftTimerTypedef softTimers[TIMER_MAX_SOFT_TIMERS]; ///< Pool of soft timers
+static int softTimerCount;              ///< Number of soft timers ever allocated from pool
+static TimerLink* freeTimers;           ///< List of deleted timers (linked through next)
+static TimerLink wheel[TIMER_WHEEL_SLOTS]; ///< Slots of timing wheel
+static uint32_t wheelTimeMillis;        ///< System time up to which wheel was processed
+static Boolean isWheelInitialized = FALSE; ///< Wheel slots were initialized
+static Boolean isCycleCounterInitialized = FALSE; ///< Cycle counter for microsecond delays was started
+static uint32_t cyclesPerMicrosecond;  ///< Cycle counter ticks in a microsecond
+static uint32_t delayOverheadCycles;   ///< Cycles spent in Timer_delayMicros besides waiting
 
-static void microsUpdateCb(void) {
-  systemClockMicros++;
-}
+static void initializeCycleCounter(void);
+static TIMER_SoftTimerTypedef* addTimer(unsigned int periodMillis, Boolean isPeriodic);
+static TIMER_SoftTimerTypedef* getTimer(int id);
+static void scheduleTimer(TIMER_SoftTimerTypedef* timer, uint32_t delayMillis);
+static void expireSlot(TimerLink* slot, uint32_t currentTimeMillis);
+static void linkInsert(TimerLink* list, TimerLink* link);
+static void linkRemove(TimerLink* link);
 
 /**
  * @brief Returns the system time.
@@ -70,6 +97,40 @@ static void microsUpdateCb(void) {
 unsigned int Timer_getTimeMillis(void) {
   return SysTick_getTimeMillis();
 }
+/**
+ * @brief Returns the 64-bit system time.
+ * @details Time is monotonic and never wraps around, so deadlines can be
+ * compared directly.
+ * @return System time in microseconds
+ */
+uint64_t Timer_getTimeMicros(void) {
+  return SysTick_getTimeMicros();
+}
+/**
+ * @brief Computes deadline in given time from now.
+ * @param millis Time to deadline
+ * @return Deadline for Timer_isDeadlineReached
+ */
+uint64_t Timer_getDeadlineMillis(unsigned int millis) {
+  return Timer_getTimeMicros() + (uint64_t)millis * 1000;
+}
+/**
+ * @brief Computes deadline in given time from now.
+ * @param micros Time to deadline
+ * @return Deadline for Timer_isDeadlineReached
+ */
+uint64_t Timer_getDeadlineMicros(unsigned int micros) {
+  return Timer_getTimeMicros() + micros;
+}
+/**
+ * @brief Nonblocking check of deadline.
+ * @param deadlineMicros Deadline from Timer_getDeadlineMillis or Timer_getDeadlineMicros
+ * @retval FALSE Deadline has not been reached (wait longer)
+ * @retval TRUE Deadline has been reached
+ */
+Boolean Timer_isDeadlineReached(uint64_t deadlineMicros) {
+  return Timer_getTimeMicros() >= deadlineMicros;
+}
 /**
  * @brief Blocking delay function.
  * @param millis Milliseconds to delay.
@@ -78,49 +139,31 @@ unsigned int Timer_getTimeMillis(void) {
 void Timer_delayMillis(unsigned int millis) {
 
   unsigned int startTimeMillis = Timer_getTimeMillis();
-  unsigned int currentTimeMillis;
 
-  while (TRUE) {
-    currentTimeMillis = Timer_getTimeMillis();
-    if ((currentTimeMillis >= startTimeMillis) &&
-        (currentTimeMillis-startTimeMillis > millis)) {
-      break;
-    }
-    // account for system timer overflow
-    if ((currentTimeMillis < startTimeMillis) &&
-        (UINT32_MAX-startTimeMillis + currentTimeMillis > millis)) {
-      break;
-    }
-  }
+  // unsigned difference is correct when the system time wraps around
+  while (Timer_getTimeMillis() - startTimeMillis <= millis);
 }
 /**
  * @brief Blocking delay function.
- * @param micros Microseconds to delay
+ * @details Counts core clock cycles with the DWT cycle counter, so it works
+ * with interrupts disabled and doesn't need a timer interrupt. Time spent in
+ * the function call itself is subtracted from the delay.
+ * @param micros Microseconds to delay (less than 2^32 core clock cycles)
  */
 void Timer_delayMicros(unsigned int micros) {
 
-  if (!isMicrosCounterInitialized) {
-    const int TIMER_FREQUENCY_HZ = 1000000;
-    HardwareTimers_configureTimerAsIrqWithCallback(HARDWARE_TIMERS_TIMER5, TIMER_FREQUENCY_HZ,
-        microsUpdateCb);
-    isMicrosCounterInitialized = TRUE;
+  uint32_t startCycles = SysTick_getCycles();
+
+  if (!isCycleCounterInitialized) {
+    initializeCycleCounter();
+    startCycles = SysTick_getCycles();
   }
 
-  unsigned int startTimeMicros = systemClockMicros;
-  unsigned int currentTimeMicros;
+  uint32_t delayCycles = micros * cyclesPerMicrosecond;
+  delayCycles = (delayCycles > delayOverheadCycles) ? delayCycles - delayOverheadCycles : 0;
 
-  while (TRUE) {
-    currentTimeMicros = systemClockMicros;
-    if ((currentTimeMicros >= startTimeMicros) &&
-        (currentTimeMicros-startTimeMicros > micros)) {
-      break;
-    }
-    // account for system timer overflow
-    if ((currentTimeMicros < startTimeMicros) &&
-        (UINT32_MAX-startTimeMicros + currentTimeMicros > micros)) {
-      break;
-    }
-  }
+  // unsigned difference is correct when the counter wraps around
+  while (SysTick_getCycles() - startCycles < delayCycles);
 }
 /**
  * @brief Nonblocking delay function
@@ -130,22 +173,12 @@ void Timer_delayMicros(unsigned int micros) {
  * @retval TRUE Delay value has been reached
  */
 Boolean Timer_delayTimer(unsigned int millis, unsigned int startTimeMillis) {
-
-  unsigned int currentTimeMillis = Timer_getTimeMillis();
-
-  if ((currentTimeMillis >= startTimeMillis) && (currentTimeMillis-startTimeMillis > millis)) {
-    return TRUE;
-
-  // account for system timer overflow
-  } else if ((currentTimeMillis < startTimeMillis) &&
-      (UINT32_MAX-startTimeMillis + currentTimeMillis > millis)) {
-    return TRUE;
-  } else {
-    return FALSE;
-  }
+  // unsigned difference is correct when the system time wraps around
+  return (Timer_getTimeMillis() - startTimeMillis) > millis;
 }
 /**
- * @brief Adds a soft timer
+ * @brief Adds a periodic soft timer
+ * @details The timer is inactive until started.
  * @param overflowValue Overflow value of timer
  * @param overflowCb Function called on overflow (should return void and accept no parameters)
  * @return Returns the ID of the new counter or error code
@@ -154,79 +187,350 @@ Boolean Timer_delayTimer(unsigned int millis, unsigned int startTimeMillis) {
 int Timer_addSoftwareTimer(unsigned int overflowValue,
     void (*overflowCb)(void)) {
 
-  if (softTimerCount > MAX_SOFT_TIMERS) {
-    println("Reached maximum number of timers!");
+  TIMER_SoftTimerTypedef* timer = addTimer(overflowValue, TRUE);
+  if (timer == NULL) {
     return TIMER_TOO_MANY_TIMERS;
   }
-  softTimerCount++;
+  timer->overflowCb = overflowCb;
+  return ARRAY_INDEX_TO_ID(timer - softTimers);
+}
+/**
+ * @brief Adds a one-shot soft timer
+ * @details The timer is inactive until started and stops after calling
+ * overflowCb. It can be started again.
+ * @param delayMillis Time from start to the overflow
+ * @param overflowCb Function called on overflow (should return void and accept no parameters)
+ * @return Returns the ID of the new counter or error code
+ * @retval TIMER_TOO_MANY_TIMERS Too many timers
+ */
+int Timer_addOneShotTimer(unsigned int delayMillis, void (*overflowCb)(void)) {
 
-  softTimers[ID_TO_ARRAY_INDEX(softTimerCount)].id             = softTimerCount;
-  softTimers[ID_TO_ARRAY_INDEX(softTimerCount)].overflowCb     = overflowCb;
-  softTimers[ID_TO_ARRAY_INDEX(softTimerCount)].overflowValue  = overflowValue;
-  softTimers[ID_TO_ARRAY_INDEX(softTimerCount)].currentCount   = 0;
-  softTimers[ID_TO_ARRAY_INDEX(softTimerCount)].isActive       = FALSE; // inactive on startup
+  TIMER_SoftTimerTypedef* timer = addTimer(delayMillis, FALSE);
+  if (timer == NULL) {
+    return TIMER_TOO_MANY_TIMERS;
+  }
+  timer->overflowCb = overflowCb;
+  return ARRAY_INDEX_TO_ID(timer - softTimers);
+}
+/**
+ * @brief Adds a soft timer calling a function with argument
+ * @details The timer is inactive until started. This lets one overflow
+ * function serve many timers (e.g. one per task).
+ * @param overflowValue Overflow value of timer
+ * @param isPeriodic TRUE for periodic timer, FALSE for one-shot timer
+ * @param overflowCb Function called on overflow
+ * @param argument Argument passed to overflowCb
+ * @return Returns the ID of the new counter or error code
+ * @retval TIMER_TOO_MANY_TIMERS Too many timers
+ */
+int Timer_addSoftwareTimerWithArgument(unsigned int overflowValue, Boolean isPeriodic,
+    void (*overflowCb)(void*), void* argument) {
 
-  return softTimerCount;
+  TIMER_SoftTimerTypedef* timer = addTimer(overflowValue, isPeriodic);
+  if (timer == NULL) {
+    return TIMER_TOO_MANY_TIMERS;
+  }
+  timer->overflowArgumentCb = overflowCb;
+  timer->argument = argument;
+  return ARRAY_INDEX_TO_ID(timer - softTimers);
+}
+/**
+ * @brief Deletes a soft timer
+ * @details The timer is stopped and its ID may be returned by the next
+ * added timer. Can be called from the overflow function.
+ * @param id Timer ID
+ */
+void Timer_deleteSoftwareTimer(int id) {
+
+  TIMER_SoftTimerTypedef* timer = getTimer(id);
+  if (timer == NULL) {
+    return;
+  }
+  if (timer->state == TIMER_STATE_RUNNING) {
+    linkRemove(&timer->link);
+  }
+  timer->state = TIMER_STATE_FREE;
+  timer->link.next = freeTimers;
+  freeTimers = &timer->link;
 }
 /**
  * @brief Starts the timer (zeroes out current count value).
  * @param id Timer ID
  */
 void Timer_startSoftwareTimer(int id) {
-  softTimers[ID_TO_ARRAY_INDEX(id)].currentCount = 0;
-  softTimers[ID_TO_ARRAY_INDEX(id)].isActive = TRUE; // start timer
+
+  TIMER_SoftTimerTypedef* timer = getTimer(id);
+  if (timer == NULL) {
+    return;
+  }
+  if (timer->state == TIMER_STATE_RUNNING) {
+    linkRemove(&timer->link);
+  }
+  scheduleTimer(timer, timer->periodMillis);
 }
 /**
  * @brief Pauses given timer (current count value unchanged)
  * @param id Timer ID
  */
 void Timer_pauseSoftwareTimer(int id) {
-  softTimers[ID_TO_ARRAY_INDEX(id)].isActive = FALSE; // pause timer
+
+  TIMER_SoftTimerTypedef* timer = getTimer(id);
+  if (timer == NULL || timer->state != TIMER_STATE_RUNNING) {
+    return;
+  }
+  linkRemove(&timer->link);
+  int32_t remainingMillis = (int32_t)(timer->expiryMillis - SysTick_getTimeMillis());
+  timer->expiryMillis = (remainingMillis > 0) ? (uint32_t)remainingMillis : 0;
+  timer->state = TIMER_STATE_PAUSED;
 }
 /**
  * @brief Resumes a timer (starts counting from last value).
  * @param id Timer ID
  */
 void Timer_resumeSoftwareTimer(int id) {
-  softTimers[ID_TO_ARRAY_INDEX(id)].isActive = TRUE; // start timer
+
+  TIMER_SoftTimerTypedef* timer = getTimer(id);
+  if (timer == NULL || timer->state != TIMER_STATE_PAUSED) {
+    return;
+  }
+  scheduleTimer(timer, timer->expiryMillis);
 }
 /**
  * @brief Updates all the timers and calls the overflow functions as
  * necessary
  * @details This function can be called periodically in the main
- * loop of the program
+ * loop of the program. Timers are kept in a hashed timing wheel with a slot
+ * per millisecond, so only the slots of the milliseconds which passed since
+ * the previous run are checked, not all the timers. Overflow functions
+ * may add, start, pause and delete timers.
  */
 void Timer_softwareTimersUpdate(void) {
 
-  static unsigned int previousTimeMillis;
-  unsigned int deltaMillis;
-  unsigned int currentTimeMillis = SysTick_getTimeMillis();
+  if (!isWheelInitialized) {
+    return; // no timers were started yet
+  }
+
+  uint32_t currentTimeMillis = SysTick_getTimeMillis();
+  // unsigned difference is correct when the system time wraps around
+  uint32_t elapsedMillis = currentTimeMillis - wheelTimeMillis;
 
-  if (currentTimeMillis >= previousTimeMillis) {
-    // How much time passed from previous run
-    deltaMillis = currentTimeMillis - previousTimeMillis;
-  } else { // if overflow occurs
-    // the difference is the value that previousTimeMillis
-    // has to UINT32_MAX + the new number of currentTimeMillis
-    deltaMillis = UINT32_MAX - previousTimeMillis + currentTimeMillis;
+  // after a whole turn of the wheel every slot has been checked
+  if (elapsedMillis > TIMER_WHEEL_SLOTS) {
+    elapsedMillis = TIMER_WHEEL_SLOTS;
   }
 
-  previousTimeMillis += deltaMillis; // update time for the function
+  for (uint32_t i = 1; i <= elapsedMillis; i++) {
+    expireSlot(&wheel[(wheelTimeMillis + i) & WHEEL_MASK], currentTimeMillis);
+  }
+  wheelTimeMillis = currentTimeMillis;
+}
 
-  for (int i = 0; i < softTimerCount; i++) {
+/**
+ * @brief Returns time to the nearest soft timer overflow.
+ * @details Wheel slots are checked in order of time. The search stops at
+ * the first slot holding a timer which expires in the current turn of the
+ * wheel, since timers in later slots expire later.
+ * @return Milliseconds to the nearest overflow (0 if a timer is due,
+ * UINT32_MAX if no timer is running)
+ */
+unsigned int Timer_getMillisToNextTimer(void) {
 
-    if (softTimers[i].isActive == TRUE) {
+  if (!isWheelInitialized) {
+    return UINT32_MAX;
+  }
 
-      softTimers[i].currentCount += deltaMillis; // update active timer values
+  uint32_t nearestMillis = UINT32_MAX; // time from wheelTimeMillis
 
-      if (softTimers[i].currentCount >= softTimers[i].overflowValue) { // if overflow
-        softTimers[i].currentCount = 0; // zero out timer
-        if (softTimers[i].overflowCb != NULL) {
-          softTimers[i].overflowCb(); // call the overflow function
-        }
+  for (uint32_t i = 1; i <= TIMER_WHEEL_SLOTS && nearestMillis > i - 1; i++) {
+    TimerLink* slot = &wheel[(wheelTimeMillis + i) & WHEEL_MASK];
+    for (TimerLink* link = slot->next; link != slot; link = link->next) {
+      int32_t expiryMillis = (int32_t)(((TIMER_SoftTimerTypedef*)link)->expiryMillis - wheelTimeMillis);
+      if (expiryMillis <= 0) {
+        return 0;
+      }
+      if ((uint32_t)expiryMillis < nearestMillis) {
+        nearestMillis = expiryMillis;
       }
     }
   }
+
+  if (nearestMillis == UINT32_MAX) {
+    return UINT32_MAX;
+  }
+  uint32_t elapsedMillis = SysTick_getTimeMillis() - wheelTimeMillis;
+  return (nearestMillis > elapsedMillis) ? nearestMillis - elapsedMillis : 0;
+}
+/**
+ * @brief Sleeps until the nearest soft timer overflow.
+ * @details SysTick is stopped during sleep, so the core isn't woken up
+ * every millisecond. Any interrupt ends the sleep early, so the function
+ * can be called at the end of the main loop instead of spinning:
+ * @code
+ * while (TRUE) {
+ *   Timer_softwareTimersUpdate();
+ *   Timer_sleepUntilNextTimer();
+ * }
+ * @endcode
+ * Work which doesn't come from timers or interrupts (polling of pins etc.)
+ * has to be done by a timer.
+ *
+ * Interrupts are disabled before the nearest overflow is computed, so a
+ * timer started by an interrupt after that can't be missed: its interrupt
+ * stays pending and ends the sleep at once. If a timer is already due, the
+ * function returns without sleeping.
+ */
+void Timer_sleepUntilNextTimer(void) {
+  uint32_t interruptState = CommonHal_disableInterrupts();
+  SysTick_sleepMillis(Timer_getMillisToNextTimer());
+  CommonHal_restoreInterrupts(interruptState);
+}
+/**
+ * @brief Starts the cycle counter and measures delay overhead.
+ */
+static void initializeCycleCounter(void) {
+
+  SysTick_initializeCycleCounter();
+  cyclesPerMicrosecond = SysTick_getCyclesPerMicrosecond();
+  isCycleCounterInitialized = TRUE;
+
+  // measure cost of a zero delay (call, multiplication and one counter read)
+  delayOverheadCycles = 0;
+  uint32_t startCycles = SysTick_getCycles();
+  Timer_delayMicros(0);
+  delayOverheadCycles = SysTick_getCycles() - startCycles;
+}
+
+/**
+ * @brief Allocates a soft timer from the pool.
+ * @param periodMillis Overflow value of timer
+ * @param isPeriodic Is timer restarted on overflow?
+ * @return Timer without overflow functions or NULL if there are too many timers
+ */
+static TIMER_SoftTimerTypedef* addTimer(unsigned int periodMillis, Boolean isPeriodic) {
+
+  TIMER_SoftTimerTypedef* timer;
+
+  if (freeTimers != NULL) {
+    timer = (TIMER_SoftTimerTypedef*)freeTimers;
+    freeTimers = freeTimers->next;
+  } else if (softTimerCount < TIMER_MAX_SOFT_TIMERS) {
+    timer = &softTimers[softTimerCount++];
+  } else {
+    logError("Reached maximum number of timers!");
+    return NULL;
+  }
+
+  timer->overflowCb         = NULL;
+  timer->overflowArgumentCb = NULL;
+  timer->argument           = NULL;
+  timer->periodMillis       = periodMillis;
+  timer->isPeriodic         = isPeriodic;
+  timer->state              = TIMER_STATE_STOPPED; // inactive on startup
+
+  return timer;
+}
+/**
+ * @brief Finds timer with given ID.
+ * @param id Timer ID
+ * @return Timer or NULL if ID isn't a valid timer
+ */
+static TIMER_SoftTimerTypedef* getTimer(int id) {
+
+  if (id < 1 || id > softTimerCount) {
+    return NULL;
+  }
+  TIMER_SoftTimerTypedef* timer = &softTimers[ID_TO_ARRAY_INDEX(id)];
+  return (timer->state == TIMER_STATE_FREE) ? NULL : timer;
+}
+/**
+ * @brief Puts timer into wheel slot of its expiry time.
+ * @param timer Timer (not in wheel)
+ * @param delayMillis Time from now to expiry
+ */
+static void scheduleTimer(TIMER_SoftTimerTypedef* timer, uint32_t delayMillis) {
+
+  if (!isWheelInitialized) {
+    for (int i = 0; i < TIMER_WHEEL_SLOTS; i++) {
+      wheel[i].next = wheel[i].previous = &wheel[i];
+    }
+    wheelTimeMillis = SysTick_getTimeMillis();
+    isWheelInitialized = TRUE;
+  }
+
+  // expiry has to be in a slot which wasn't checked yet
+  if (delayMillis == 0) {
+    delayMillis = 1;
+  }
+  timer->expiryMillis = SysTick_getTimeMillis() + delayMillis;
+  timer->state = TIMER_STATE_RUNNING;
+  linkInsert(&wheel[timer->expiryMillis & WHEEL_MASK], &timer->link);
+}
+/**
+ * @brief Calls overflow functions of expired timers in a wheel slot.
+ * @details Timers which expire in later turns of the wheel stay in the
+ * slot. Expired timers are moved to a separate list first, so overflow
+ * functions can modify any timer, including the ones which are still
+ * waiting for their overflow function to be called.
+ * @param slot Wheel slot
+ * @param currentTimeMillis System time
+ */
+static void expireSlot(TimerLink* slot, uint32_t currentTimeMillis) {
+
+  TimerLink expired = {&expired, &expired};
+  TimerLink* link = slot->next;
+
+  while (link != slot) {
+    TIMER_SoftTimerTypedef* timer = (TIMER_SoftTimerTypedef*)link;
+    link = link->next;
+    // signed difference is correct when the system time wraps around
+    if ((int32_t)(timer->expiryMillis - currentTimeMillis) <= 0) {
+      linkRemove(&timer->link);
+      linkInsert(&expired, &timer->link);
+    }
+  }
+
+  while (expired.next != &expired) {
+    TIMER_SoftTimerTypedef* timer = (TIMER_SoftTimerTypedef*)expired.next;
+    linkRemove(&timer->link);
+
+    if (timer->isPeriodic && timer->periodMillis > 0) {
+      // keep the period without drift, unless overflows were missed
+      timer->expiryMillis += timer->periodMillis;
+      if ((int32_t)(timer->expiryMillis - currentTimeMillis) <= 0) {
+        timer->expiryMillis = currentTimeMillis + timer->periodMillis;
+      }
+      linkInsert(&wheel[timer->expiryMillis & WHEEL_MASK], &timer->link);
+    } else if (timer->isPeriodic) {
+      scheduleTimer(timer, 0);
+    } else {
+      timer->state = TIMER_STATE_STOPPED;
+    }
+
+    if (timer->overflowCb != NULL) {
+      timer->overflowCb(); // call the overflow function
+    } else if (timer->overflowArgumentCb != NULL) {
+      timer->overflowArgumentCb(timer->argument);
+    }
+  }
+}
+/**
+ * @brief Inserts link at the end of a list.
+ * @param list List sentinel
+ * @param link Inserted link
+ */
+static void linkInsert(TimerLink* list, TimerLink* link) {
+  link->next = list;
+  link->previous = list->previous;
+  list->previous->next = link;
+  list->previous = link;
+}
+/**
+ * @brief Removes link from its list.
+ * @param link Removed link
+ */
+static void linkRemove(TimerLink* link) {
+  link->previous->next = link->next;
+  link->next->previous = link->previous;
 }
 
 /**
@@ -40,13 +40,33 @@ typedef enum {
   TIMER_TOO_MANY_TIMERS = -100,//!< TIMER_TOO_MANY_TIMERS
 } TimerResultCode;
 
+#ifndef TIMER_MAX_SOFT_TIMERS
+  #define TIMER_MAX_SOFT_TIMERS 32 ///< Maximum number of soft timers
+#endif
+
+#ifndef TIMER_WHEEL_SLOTS
+  #define TIMER_WHEEL_SLOTS     64 ///< Number of timing wheel slots, one per millisecond (power of two)
+#endif
+
 void         Timer_delayMicros          (unsigned int micros);
 void         Timer_delayMillis          (unsigned int millis);
 void         Timer_startSoftwareTimer   (int id);
+void         Timer_pauseSoftwareTimer   (int id);
+void         Timer_resumeSoftwareTimer  (int id);
+void         Timer_deleteSoftwareTimer  (int id);
 void         Timer_softwareTimersUpdate (void);
+unsigned int Timer_getMillisToNextTimer (void);
+void         Timer_sleepUntilNextTimer  (void);
 Boolean      Timer_delayTimer           (unsigned int millis, unsigned int startTimeMillis);
 unsigned int Timer_getTimeMillis        (void);
+uint64_t     Timer_getTimeMicros        (void);
+uint64_t     Timer_getDeadlineMillis    (unsigned int millis);
+uint64_t     Timer_getDeadlineMicros    (unsigned int micros);
+Boolean      Timer_isDeadlineReached    (uint64_t deadlineMicros);
 int          Timer_addSoftwareTimer     (unsigned int overflowValue, void (*overflowCb)(void));
+int          Timer_addOneShotTimer      (unsigned int delayMillis, void (*overflowCb)(void));
+int          Timer_addSoftwareTimerWithArgument (unsigned int overflowValue, Boolean isPeriodic,
+    void (*overflowCb)(void*), void* argument);
 /**
  * @}
  */
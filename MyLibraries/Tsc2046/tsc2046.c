@@ -21,15 +21,9 @@
 #include "timers.h"
 #include <stdio.h>
 
-#define DEBUG
-
-#ifdef DEBUG
-#define print(str, args...) printf(""str"%s",##args,"")
-#define println(str, args...) printf("TSC--> "str"%s",##args,"\r\n")
-#else
-#define print(str, args...) (void)0
-#define println(str, args...) (void)0
-#endif
+#define LOG_MODULE_PREFIX "TSC--> "         ///< Prefix of log lines
+#define LOG_MODULE_LEVEL  LOG_LEVEL_TSC2046 ///< Set with -DLOG_LEVEL_TSC2046=<level>
+#include "log_module.h"
 
 /**
  * @addtogroup TSC2046
@@ -95,6 +89,8 @@ static TSC2046_EventTypedef registeredEvents[MAX_EVENTS]; ///< Registered events
 static int numberOfRegisteredEvents;      ///< Number of registered events
 static volatile Boolean wasTouchDetected; ///< Was touch detected in IRQ
 
+static int spiDevice = -1; ///< ID of touch screen controller on SPI bus
+
 static void touchInterruptCallback(void);
 static void readTouchPosition(int *x, int *y);
 
@@ -108,7 +104,15 @@ void TSC2046_Initialize(void) {
   const int POSITION_HIGH_BYTE = 1;
   const int POSITION_LOW_BYTE = 2;
 
-  SpiHal_initialize(SPI_HAL_SPI3);
+  if (spiDevice < 0) {
+    const SpiDeviceConfig TSC2046_SPI_CONFIG = {
+        .spi = SPI_HAL_SPI3,
+        .chipSelect = SPI_HAL_CS_SPI3,
+        .prescaler = SPI_HAL_CLOCK_DIV_256,
+        .mode = SPI_HAL_MODE_0,
+    };
+    spiDevice = SpiHal_addDevice(&TSC2046_SPI_CONFIG);
+  }
   TSC2046_HAL_PenirqInit(touchInterruptCallback);
 
   // send first commands
@@ -125,9 +129,11 @@ void TSC2046_Initialize(void) {
   txBuffer[POSITION_HIGH_BYTE] = 0;
   txBuffer[POSITION_LOW_BYTE] = 0;
 
-  SpiHal_select(SPI_HAL_SPI3);
+  if (SpiHal_acquire(spiDevice) != 0) {
+    return;
+  }
   SpiHal_sendBuffer(SPI_HAL_SPI3, txBuffer, TOUCHSCREEN_COMMAND_LENGTH);
-  SpiHal_deselect(SPI_HAL_SPI3);
+  SpiHal_release(spiDevice);
 }
 /**
  * @brief Registers a given region of the touch screen
@@ -175,7 +181,7 @@ void TSC2046_Update(void) {
     WAIT_FOR_NEXT_TOUCH,
   } TouchStateTypedef;
 
-  static int debounce;
+  static uint64_t deadline;
   static TouchStateTypedef touchState = WAITING_FOR_IRQ;
 
   switch (touchState) {
@@ -187,15 +193,15 @@ void TSC2046_Update(void) {
     break;
 
   case IRQ_RECEIVED:
-    debounce = Timer_getTimeMillis();
+    deadline = Timer_getDeadlineMillis(DEBOUNCE_TIME);
     touchState = WAIT_FOR_DEBOUNCE;
     break;
 
   case WAIT_FOR_DEBOUNCE:
-    if (Timer_delayTimer(DEBOUNCE_TIME, debounce)) {
+    if (Timer_isDeadlineReached(deadline)) {
       int x, y;
       touchState = WAIT_FOR_NEXT_TOUCH;
-      debounce = Timer_getTimeMillis();
+      deadline = Timer_getDeadlineMillis(WAIT_TIME);
       // still down?
       if (!TSC2046_HAL_ReadPenirq()) {
 
@@ -215,7 +221,7 @@ void TSC2046_Update(void) {
     break;
 
   case WAIT_FOR_NEXT_TOUCH:
-    if (Timer_delayTimer(WAIT_TIME, debounce)) {
+    if (Timer_isDeadlineReached(deadline)) {
       touchState = WAITING_FOR_IRQ;
       wasTouchDetected = FALSE;
     }
@@ -236,8 +242,11 @@ void readTouchPosition(int *x, int *y) {
   const int POSITION_LOW_BYTE = 2;
   const int TOUCH_BIT_SHIFT = 3;
 
+  if (SpiHal_acquire(spiDevice) != 0) {
+    *x = *y = -1;
+    return;
+  }
   TSC2046_HAL_DisablePenirq(); // disable IRQ during read
-  SpiHal_select(SPI_HAL_SPI3);
 
   // control byte
   ControlByteTypedef ctrl;
@@ -273,7 +282,7 @@ void readTouchPosition(int *x, int *y) {
 
   println("Touch position: x = %d y = %d", *x, *y);
 
-  SpiHal_deselect(SPI_HAL_SPI3);
+  SpiHal_release(spiDevice);
   TSC2046_HAL_EnablePenirq();
 }
 /**
@@ -0,0 +1,138 @@
+/**
+ * @file    deferred.c
+ * @brief   Calls deferred from interrupts to main loop.
+ * @date    18.10.2026
+ * @author  Michal Ksiezopolski
+ *
+ * @verbatim
+ * Copyright (c) 2026 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include "deferred.h"
+#include <stddef.h>
+
+/**
+ * @addtogroup DEFERRED
+ * @{
+ */
+
+#define QUEUE_MASK (DEFERRED_QUEUE_LENGTH-1) ///< Mask converting position to slot
+
+typedef char DEFERRED_queueLengthIsPowerOfTwo[IS_POWER_OF_TWO(DEFERRED_QUEUE_LENGTH) ? 1 : -1];
+
+/**
+ * @brief Queued call.
+ * @details Sequence says which turn of the queue the slot belongs to.
+ * For position p in turn t = p & ~QUEUE_MASK the slot is free when
+ * sequence is t and holds a call when sequence is t + 1. Zeroed slots are
+ * free for the first turn, so the queue needs no initialization.
+ */
+typedef struct {
+  void (*function)(void*);    ///< Deferred function
+  void* argument;             ///< Argument of function
+  volatile uint32_t sequence; ///< Turn of the slot
+} DeferredCall;
+
+static DeferredCall calls[DEFERRED_QUEUE_LENGTH]; ///< Queued calls
+static volatile uint32_t writePosition; ///< Next position to reserve (interrupts)
+static uint32_t readPosition;           ///< Next position to run (main loop)
+static volatile uint32_t droppedCount;  ///< Calls dropped, because queue was full
+
+/**
+ * @brief Queues call of a function in the main loop.
+ * @details Can be called from interrupts of any priority. Reserving a slot
+ * is retried only if a higher priority interrupt reserved it first.
+ * @param function Function to call
+ * @param argument Argument of function
+ * @retval TRUE Call queued
+ * @retval FALSE Queue full (call dropped)
+ */
+Boolean Deferred_call(void (*function)(void*), void* argument) {
+
+  uint32_t position = __atomic_load_n(&writePosition, __ATOMIC_RELAXED);
+  DeferredCall* call;
+
+  while (TRUE) {
+    call = &calls[position & QUEUE_MASK];
+    uint32_t sequence = __atomic_load_n(&call->sequence, __ATOMIC_ACQUIRE);
+    int32_t difference = (int32_t)(sequence - (position & ~QUEUE_MASK));
+
+    if (difference == 0) {
+      // slot free - reserve it (position is updated if another interrupt was first)
+      if (__atomic_compare_exchange_n(&writePosition, &position, position + 1,
+          TRUE, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        break;
+      }
+    } else if (difference < 0) {
+      // slot still holds call from previous turn
+      __atomic_fetch_add(&droppedCount, 1, __ATOMIC_RELAXED);
+      return FALSE;
+    } else {
+      position = __atomic_load_n(&writePosition, __ATOMIC_RELAXED);
+    }
+  }
+
+  call->function = function;
+  call->argument = argument;
+  // publish call
+  __atomic_store_n(&call->sequence, (position & ~QUEUE_MASK) + 1, __ATOMIC_RELEASE);
+  return TRUE;
+}
+/**
+ * @brief Runs queued calls.
+ * @details Runs the calls queued before this function started, so calls
+ * queued all the time by interrupts don't block the main loop. Stops at a
+ * slot reserved, but not yet written by an interrupt. Not reentrant.
+ * @return Number of calls run
+ */
+int Deferred_process(void) {
+
+  uint32_t endPosition = __atomic_load_n(&writePosition, __ATOMIC_ACQUIRE);
+  int count = 0;
+
+  while (readPosition != endPosition) {
+    DeferredCall* call = &calls[readPosition & QUEUE_MASK];
+    uint32_t turn = readPosition & ~QUEUE_MASK;
+
+    if (__atomic_load_n(&call->sequence, __ATOMIC_ACQUIRE) != turn + 1) {
+      break;
+    }
+    void (*function)(void*) = call->function;
+    void* argument = call->argument;
+    // free slot for the next turn before the call, so the call can queue calls
+    __atomic_store_n(&call->sequence, turn + DEFERRED_QUEUE_LENGTH, __ATOMIC_RELEASE);
+    readPosition++;
+
+    if (function != NULL) {
+      function(argument);
+    }
+    count++;
+  }
+  return count;
+}
+/**
+ * @brief Checks if calls are waiting.
+ * @retval TRUE No calls queued
+ * @retval FALSE Calls waiting for Deferred_process
+ */
+Boolean Deferred_isEmpty(void) {
+  return __atomic_load_n(&writePosition, __ATOMIC_ACQUIRE) == readPosition;
+}
+/**
+ * @brief Returns number of calls dropped because the queue was full.
+ * @return Number of dropped calls
+ */
+unsigned int Deferred_getDroppedCount(void) {
+  return droppedCount;
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,56 @@
+/**
+ * @file    deferred.h
+ * @brief   Calls deferred from interrupts to main loop.
+ * @date    18.10.2026
+ * @author  Michal Ksiezopolski
+ *
+ * @verbatim
+ * Copyright (c) 2026 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef DEFERRED_H_
+#define DEFERRED_H_
+
+#include "utils.h"
+
+/**
+ * @defgroup  DEFERRED DEFERRED
+ * @brief     Deferred callback queue
+ *
+ * @details Interrupts queue a function with an argument with Deferred_call
+ * instead of calling it, so heavy processing (decoding, printf) runs in
+ * the main loop and interrupts stay short. The queue is lock-free: a slot
+ * is reserved with compare-and-swap, so interrupts of any priority can
+ * queue calls without disabling interrupts. Calls run in the order their
+ * slots were reserved.
+ *
+ * Queued calls are run by Deferred_process, called in the main loop
+ * (Scheduler_run calls it before every task).
+ */
+
+/**
+ * @addtogroup DEFERRED
+ * @{
+ */
+
+#ifndef DEFERRED_QUEUE_LENGTH
+  #define DEFERRED_QUEUE_LENGTH 32 ///< Number of calls waiting for main loop (power of two)
+#endif
+
+Boolean      Deferred_call            (void (*function)(void*), void* argument);
+int          Deferred_process         (void);
+Boolean      Deferred_isEmpty         (void);
+unsigned int Deferred_getDroppedCount (void);
+
+/**
+ * @}
+ */
+
+#endif /* DEFERRED_H_ */
@@ -0,0 +1,99 @@
+/**
+ * @file    log.c
+ * @brief   Deferred logging.
+ * @date    18.10.2026
+ * @author  Michal Ksiezopolski
+ *
+ * @verbatim
+ * Copyright (c) 2026 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include "log.h"
+#include "ring_buffer.h"
+#include "common_hal.h"
+#include <stdarg.h>
+#include <stdio.h>
+
+/**
+ * @addtogroup LOG
+ * @{
+ */
+
+/**
+ * @brief Log entry waiting for formatting
+ */
+typedef struct {
+  const char* format;                      ///< printf format string
+  uintptr_t   arguments[LOG_MAX_ARGUMENTS]; ///< Raw arguments
+} LogEntry;
+
+RING_BUFFER_DEFINE(LogQueue, LogEntry, LOG_QUEUE_LENGTH)
+
+static LogQueue logQueue;                   ///< Entries waiting for Log_process (zero initialized is empty)
+static volatile unsigned int droppedCount;  ///< Number of entries dropped because queue was full
+static unsigned int reportedDroppedCount;   ///< Number of dropped entries already reported
+
+/**
+ * @brief Queues log entry.
+ * @details Use LOG_DEFERRED macro, which counts the arguments. Entry is
+ * pushed with interrupts disabled, so it can be called from main loop and
+ * interrupts at the same time.
+ * @param format printf format string (has to persist until Log_process)
+ * @param argumentCount Number of arguments (at most LOG_MAX_ARGUMENTS)
+ */
+void Log_write(const char* format, int argumentCount, ...) {
+  LogEntry entry = {format, {0}};
+  va_list arguments;
+
+  va_start(arguments, argumentCount);
+  for (int i = 0; i < argumentCount && i < LOG_MAX_ARGUMENTS; i++) {
+    entry.arguments[i] = va_arg(arguments, uintptr_t);
+  }
+  va_end(arguments);
+
+  uint32_t state = CommonHal_disableInterrupts();
+  if (!LogQueue_push(&logQueue, &entry)) {
+    droppedCount++;
+  }
+  CommonHal_restoreInterrupts(state);
+}
+/**
+ * @brief Formats and sends queued log entries.
+ * @details Call in idle time, e.g. in main loop. Not reentrant.
+ * @return Number of entries sent
+ */
+int Log_process(void) {
+  LogEntry entry;
+  int count = 0;
+
+  while (LogQueue_pop(&logQueue, &entry)) {
+    printf(entry.format, entry.arguments[0], entry.arguments[1],
+        entry.arguments[2], entry.arguments[3]);
+    count++;
+  }
+
+  unsigned int dropped = droppedCount;
+  if (dropped != reportedDroppedCount) {
+    printf("LOG--> Dropped %u entries\r\n", dropped - reportedDroppedCount);
+    reportedDroppedCount = dropped;
+  }
+  return count;
+}
+/**
+ * @brief Returns number of entries dropped because queue was full.
+ * @return Number of dropped entries
+ */
+unsigned int Log_getDroppedCount(void) {
+  return droppedCount;
+}
+
+/**
+ * @}
+ */
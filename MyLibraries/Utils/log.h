@@ -0,0 +1,117 @@
+/**
+ * @file    log.h
+ * @brief   Deferred logging.
+ * @date    18.10.2026
+ * @author  Michal Ksiezopolski
+ *
+ * @verbatim
+ * Copyright (c) 2026 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef LOG_H_
+#define LOG_H_
+
+#include <inttypes.h>
+
+/**
+ * @defgroup  LOG LOG
+ * @brief     Logging with deferred formatting
+ *
+ * @details LOG_DEFERRED stores only the format string pointer and raw
+ * arguments in a binary queue, which takes tens of cycles, so it can be used
+ * in hot paths and interrupts. Formatting and sending to the serial port is
+ * done by Log_process, which should be called in idle time (e.g. main loop).
+ *
+ * Limitations:
+ * - at most LOG_MAX_ARGUMENTS arguments,
+ * - arguments have to be 32-bit integers or pointers (no float, no 64-bit),
+ * - format string and %s arguments have to persist until Log_process
+ *   (string literals, __FUNCTION__, static buffers).
+ *
+ * If the queue is full, entries are dropped and their number is reported
+ * by Log_process.
+ *
+ * Log output of every module is selected at compile time. LOG_LEVEL sets
+ * the default level for all modules and every module has its own override,
+ * e.g. -DLOG_LEVEL_FAT=LOG_LEVEL_TRACE. A module names its override and
+ * prefix and includes log_module.h, which defines logError, logWarning,
+ * logInfo, println and trace compiled to nothing below their level:
+ *
+ * @code
+ * #define LOG_MODULE_PREFIX "FAT--> "
+ * #define LOG_MODULE_LEVEL  LOG_LEVEL_FAT
+ * #include "log_module.h"
+ * @endcode
+ *
+ * Messages in hot paths (e.g. every sector read) belong to LOG_LEVEL_TRACE,
+ * so they are not compiled in by default. Defining NDEBUG or
+ * LOG_LEVEL=LOG_LEVEL_NONE removes all logging from the build.
+ */
+
+/**
+ * @addtogroup LOG
+ * @{
+ */
+
+// levels start at 1, so an override which isn't defined (0) can be detected
+#define LOG_LEVEL_NONE    1 ///< No logging
+#define LOG_LEVEL_ERROR   2 ///< Errors only
+#define LOG_LEVEL_WARNING 3 ///< Errors and warnings
+#define LOG_LEVEL_INFO    4 ///< Important events
+#define LOG_LEVEL_DEBUG   5 ///< Debugging messages
+#define LOG_LEVEL_TRACE   6 ///< Messages in hot paths
+
+#ifndef LOG_LEVEL
+  #ifdef NDEBUG
+    #define LOG_LEVEL LOG_LEVEL_NONE  ///< Default level of all modules
+  #else
+    #define LOG_LEVEL LOG_LEVEL_DEBUG ///< Default level of all modules
+  #endif
+#endif
+
+#ifndef LOG_QUEUE_LENGTH
+  #define LOG_QUEUE_LENGTH 32 ///< Number of entries waiting for formatting (power of two)
+#endif
+
+#define LOG_MAX_ARGUMENTS 4   ///< Maximum number of arguments of a log entry
+
+/**
+ * @brief Counts arguments (up to LOG_MAX_ARGUMENTS)
+ * @details 5 to 16 arguments select LOG_TOO_MANY_ARGUMENTS, which
+ * doesn't compile, instead of a wrong count.
+ */
+#define LOG_COUNT_ARGUMENTS(args...) LOG_SELECT_COUNT(0, ##args, \
+    LOG_TOO_MANY_ARGUMENTS, LOG_TOO_MANY_ARGUMENTS, LOG_TOO_MANY_ARGUMENTS, \
+    LOG_TOO_MANY_ARGUMENTS, LOG_TOO_MANY_ARGUMENTS, LOG_TOO_MANY_ARGUMENTS, \
+    LOG_TOO_MANY_ARGUMENTS, LOG_TOO_MANY_ARGUMENTS, LOG_TOO_MANY_ARGUMENTS, \
+    LOG_TOO_MANY_ARGUMENTS, LOG_TOO_MANY_ARGUMENTS, LOG_TOO_MANY_ARGUMENTS, \
+    4, 3, 2, 1, 0)
+#define LOG_SELECT_COUNT(_0, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, \
+    _12, _13, _14, _15, _16, count, ...) count
+#define LOG_TOO_MANY_ARGUMENTS \
+  ((int)sizeof(struct { int tooManyLogArguments : -1; })) ///< Compile error (negative bit-field width)
+
+/**
+ * @brief Queues log entry for formatting in Log_process
+ * @param format printf format string
+ * @param args Arguments (32-bit integers or pointers)
+ */
+#define LOG_DEFERRED(format, args...) \
+  Log_write(format, LOG_COUNT_ARGUMENTS(args), ##args)
+
+void Log_write(const char* format, int argumentCount, ...);
+int  Log_process(void);
+unsigned int Log_getDroppedCount(void);
+
+/**
+ * @}
+ */
+
+#endif /* LOG_H_ */
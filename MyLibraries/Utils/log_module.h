@@ -0,0 +1,76 @@
+/**
+ * @file    log_module.h
+ * @brief   Log macros of a module.
+ * @date    18.10.2026
+ * @author  Michal Ksiezopolski
+ *
+ * @details Included once by every logging module (no include guard), after
+ * defining:
+ * - LOG_MODULE_PREFIX - prefix of every line, e.g. "FAT--> ",
+ * - LOG_MODULE_LEVEL - level override of the module, e.g. LOG_LEVEL_FAT,
+ * - LOG_MODULE_DEFAULT_LEVEL (optional) - level used when the override
+ *   isn't set, LOG_LEVEL if not defined.
+ *
+ * Defines the macros of the module, each compiled to nothing below its level:
+ * - logError (LOG_LEVEL_ERROR),
+ * - logWarning (LOG_LEVEL_WARNING),
+ * - logInfo (LOG_LEVEL_INFO),
+ * - println and print (LOG_LEVEL_DEBUG, print continues a line),
+ * - trace (LOG_LEVEL_TRACE, deferred with LOG_DEFERRED for hot paths).
+ *
+ * @verbatim
+ * Copyright (c) 2026 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include "log.h"
+#include <stdio.h>
+
+#ifndef LOG_MODULE_DEFAULT_LEVEL
+  #define LOG_MODULE_DEFAULT_LEVEL LOG_LEVEL ///< Level of modules without override
+#endif
+
+// override which isn't defined evaluates to 0 (levels start at 1)
+#if LOG_MODULE_LEVEL
+  #define LOG_MODULE_ACTIVE_LEVEL LOG_MODULE_LEVEL ///< Level of this module
+#else
+  #define LOG_MODULE_ACTIVE_LEVEL LOG_MODULE_DEFAULT_LEVEL ///< Level of this module
+#endif
+
+#if LOG_MODULE_ACTIVE_LEVEL >= LOG_LEVEL_ERROR
+  #define logError(str, args...) printf(LOG_MODULE_PREFIX"Error: "str"%s",##args,"\r\n")
+#else
+  #define logError(str, args...) (void)0
+#endif
+
+#if LOG_MODULE_ACTIVE_LEVEL >= LOG_LEVEL_WARNING
+  #define logWarning(str, args...) printf(LOG_MODULE_PREFIX"Warning: "str"%s",##args,"\r\n")
+#else
+  #define logWarning(str, args...) (void)0
+#endif
+
+#if LOG_MODULE_ACTIVE_LEVEL >= LOG_LEVEL_INFO
+  #define logInfo(str, args...) printf(LOG_MODULE_PREFIX str"%s",##args,"\r\n")
+#else
+  #define logInfo(str, args...) (void)0
+#endif
+
+#if LOG_MODULE_ACTIVE_LEVEL >= LOG_LEVEL_DEBUG
+  #define print(str, args...) printf(""str"%s",##args,"")
+  #define println(str, args...) printf(LOG_MODULE_PREFIX str"%s",##args,"\r\n")
+#else
+  #define print(str, args...) (void)0
+  #define println(str, args...) (void)0
+#endif
+
+#if LOG_MODULE_ACTIVE_LEVEL >= LOG_LEVEL_TRACE
+  #define trace(str, args...) LOG_DEFERRED(LOG_MODULE_PREFIX str"\r\n",##args)
+#else
+  #define trace(str, args...) (void)0
+#endif
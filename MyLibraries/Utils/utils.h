@@ -33,6 +33,12 @@
 #define NEWLINE_SEQUENCE "\r\n"   ///< Sequence to send to get new line in terminal
 #define NUMBER_OF_BITS_IN_BYTE 8
 #define IS_EVEN(x) ((x) % 2 == 0)
+#define IS_POWER_OF_TWO(x) (((x) > 0) && (((x) & ((x) - 1)) == 0))
+/**
+ * @brief Full memory barrier (compiles to DMB on Cortex-M)
+ * @details Orders data accesses of an ISR and the main loop sharing lock-free structures.
+ */
+#define MEMORY_BARRIER() __sync_synchronize()
 
 /**
  * @brief Boolean type for flags
@@ -52,6 +58,7 @@ void Utils_hexdumpWithCharacters(const uint8_t const * dataBuffer, int length);
 void Utils_hexdump16(const uint16_t const * dataBuffer, int length);
 unsigned int Utils_convertUnsignedIntToHostEndianness(unsigned int value);
 Boolean Utils_isArchitectureBigEndian(void);
+uint16_t Utils_crc16(uint16_t crc, const uint8_t* data, int length);
 
 /**
  * @}